@@ -0,0 +1,621 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  事件紀錄的檔案系統: 以 littlefs 與 spiffs 的原始碼在主機上比較，flash 為映射到檔案
+  (bench_event_store.img) 的 NOR flash，大小與 partitions.csv 的 storage 分區相同，
+  抹除為 0xFF、寫入只能把 1 改成 0。設定與設備相同 (spiffs 見 stubs/spiffs_config.h，
+  littlefs 為 esp_littlefs 的預設值)。
+
+  每種後端以填充檔填到容量的 0/25/50/75%，輸出一行 JSON:
+  - 掛載: 主機上的耗時與讀取的 flash bytes (spiffs 需掃描整個分區)
+  - append: 與 event_store_append() 相同寫入一筆紀錄並 fsync，平均/最大耗時與每筆寫入、抹除的量
+  - 斷電: 在 append 途中第 n 次 flash 寫入或抹除時斷電 (只完成一半)，重新掛載後檢查掛載是否成功、
+    已 fsync 的紀錄是否都在、是否留下不完整的紀錄。掛載失敗時設備會格式化分區 (全部紀錄遺失)
+
+  耗時為主機上的相對比較，不代表 ESP32-H2 上的時間，flash 的讀寫與抹除量可直接對應。
+  ctest 確認兩種後端在沒有斷電時都能讀回全部紀錄，且 littlefs 在每個斷電點都能復原；
+  spiffs 的斷電結果只輸出不判定 (即 event_store 以 LittleFS 為預設的原因)。
+
+  bench_event_store [每種設定最多的斷電點數]
+*/
+
+#include <fcntl.h>
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "lfs.h"
+#include "spiffs.h"
+#include "test_util.h"
+
+#define IMAGE_FILE          "bench_event_store.img"
+#define FLASH_SIZE          0xF0000     // partitions.csv 的 storage 分區
+#define SECTOR_SIZE         4096
+#define APPENDS             20          // 每種設定量測的 append 次數
+#define RECORD_MAX          64
+#define LOG_MAX             (APPENDS * RECORD_MAX)
+#define DEFAULT_CUTS        100000      // 預設測試全部斷電點
+
+#define LFS_RW_SIZE         128         // CONFIG_LITTLEFS_READ_SIZE / WRITE_SIZE
+#define LFS_CACHE_SIZE      512
+#define LFS_LOOKAHEAD_SIZE  128
+#define LFS_BLOCK_CYCLES    512
+
+#define SPIFFS_PAGE_SIZE    256         // CONFIG_SPIFFS_PAGE_SIZE
+#define SPIFFS_MAX_FILES    5           // EVENT_STORE_MAX_FILES
+#define SPIFFS_FD_SIZE      128         // 每個 spiffs_fd 預留的空間 (大於 sizeof(spiffs_fd))
+#define SPIFFS_CACHE_PAGES  8
+
+/* flash: 映射到檔案的記憶體，base 為每個斷電測試開始時的內容 */
+static uint8_t *flash;
+static uint8_t *base;
+
+typedef struct {
+    uint64_t read_bytes;
+    uint64_t prog_bytes;
+    uint64_t erases;
+} flash_stats_t;
+
+static flash_stats_t stats;
+static long flash_ops;          // 寫入與抹除的次數
+static long cut_at = -1;        // 第幾次寫入或抹除時斷電，-1 表示不斷電
+static jmp_buf power_cut;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* 這次寫入或抹除時斷電 */
+static bool power_fails(void)
+{
+    return flash_ops++ == cut_at;
+}
+
+static void flash_read(uint32_t addr, void *dst, uint32_t size)
+{
+    memcpy(dst, flash + addr, size);
+    stats.read_bytes += size;
+}
+
+/* NOR flash 寫入只能把 1 改成 0，斷電時只寫入前一半後不再返回 */
+static void flash_prog(uint32_t addr, const void *src, uint32_t size)
+{
+    bool cut = power_fails();
+    uint32_t len = cut ? size / 2 : size;
+    for (uint32_t i = 0; i < len; i++) {
+        flash[addr + i] &= ((const uint8_t *)src)[i];
+    }
+    stats.prog_bytes += len;
+    if (cut) {
+        longjmp(power_cut, 1);
+    }
+}
+
+/* 以 sector 為單位抹除，斷電時該 sector 只抹除前一半 */
+static void flash_erase(uint32_t addr, uint32_t size)
+{
+    for (uint32_t off = 0; off < size; off += SECTOR_SIZE) {
+        bool cut = power_fails();
+        memset(flash + addr + off, 0xff, cut ? SECTOR_SIZE / 2 : SECTOR_SIZE);
+        stats.erases++;
+        if (cut) {
+            longjmp(power_cut, 1);
+        }
+    }
+}
+
+/* 測試的檔案系統操作，回傳 0 表示成功 */
+typedef struct {
+    const char *name;
+    int  (*format)(void);
+    int  (*mount)(void);
+    void (*unmount)(void);
+    int  (*fill)(size_t len);                       // 寫入 len bytes 的填充檔
+    int  (*log_open)(void);                         // 以 append 開啟事件紀錄
+    int  (*log_append)(const char *record, size_t len);    // 寫入並 fsync
+    void (*log_close)(void);
+    int  (*log_read)(char *buf, size_t cap, size_t *len);
+    void (*info)(size_t *total, size_t *used);
+} fs_ops_t;
+
+/* ---- littlefs ---- */
+
+static lfs_t lfs;
+static lfs_file_t lfs_fill_file, lfs_log_file;
+static uint8_t lfs_read_buf[LFS_CACHE_SIZE], lfs_prog_buf[LFS_CACHE_SIZE], lfs_file_buf[LFS_CACHE_SIZE];
+static uint32_t lfs_lookahead_buf[LFS_LOOKAHEAD_SIZE / 4];
+static const struct lfs_file_config lfs_file_cfg = { .buffer = lfs_file_buf };
+
+static int lfs_bd_read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
+{
+    flash_read(block * c->block_size + off, buffer, size);
+    return 0;
+}
+
+static int lfs_bd_prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+    flash_prog(block * c->block_size + off, buffer, size);
+    return 0;
+}
+
+static int lfs_bd_erase(const struct lfs_config *c, lfs_block_t block)
+{
+    flash_erase(block * c->block_size, c->block_size);
+    return 0;
+}
+
+static int lfs_bd_sync(const struct lfs_config *c)
+{
+    return 0;
+}
+
+static const struct lfs_config lfs_cfg = {
+    .read = lfs_bd_read,
+    .prog = lfs_bd_prog,
+    .erase = lfs_bd_erase,
+    .sync = lfs_bd_sync,
+    .read_size = LFS_RW_SIZE,
+    .prog_size = LFS_RW_SIZE,
+    .block_size = SECTOR_SIZE,
+    .block_count = FLASH_SIZE / SECTOR_SIZE,
+    .block_cycles = LFS_BLOCK_CYCLES,
+    .cache_size = LFS_CACHE_SIZE,
+    .lookahead_size = LFS_LOOKAHEAD_SIZE,
+    .read_buffer = lfs_read_buf,
+    .prog_buffer = lfs_prog_buf,
+    .lookahead_buffer = lfs_lookahead_buf,
+};
+
+static int littlefs_format(void)
+{
+    return lfs_format(&lfs, &lfs_cfg);
+}
+
+static int littlefs_mount(void)
+{
+    return lfs_mount(&lfs, &lfs_cfg);
+}
+
+static void littlefs_unmount(void)
+{
+    lfs_unmount(&lfs);
+}
+
+static int littlefs_fill(size_t len)
+{
+    static uint8_t block[SECTOR_SIZE];
+    int err = lfs_file_opencfg(&lfs, &lfs_fill_file, "fill.bin", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC, &lfs_file_cfg);
+    if (err) {
+        return err;
+    }
+    memset(block, 'x', sizeof(block));
+    for (size_t n = 0; n < len; n += sizeof(block)) {
+        if (lfs_file_write(&lfs, &lfs_fill_file, block, sizeof(block)) != sizeof(block)) {
+            break;  // 分區已滿，以實際寫入的量為準
+        }
+    }
+    return lfs_file_close(&lfs, &lfs_fill_file);
+}
+
+static int littlefs_log_open(void)
+{
+    return lfs_file_opencfg(&lfs, &lfs_log_file, "data.json", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND, &lfs_file_cfg);
+}
+
+static int littlefs_log_append(const char *record, size_t len)
+{
+    if (lfs_file_write(&lfs, &lfs_log_file, record, len) != (lfs_ssize_t)len) {
+        return -1;
+    }
+    return lfs_file_sync(&lfs, &lfs_log_file);
+}
+
+static void littlefs_log_close(void)
+{
+    lfs_file_close(&lfs, &lfs_log_file);
+}
+
+static int littlefs_log_read(char *buf, size_t cap, size_t *len)
+{
+    *len = 0;
+    int err = lfs_file_opencfg(&lfs, &lfs_log_file, "data.json", LFS_O_RDONLY, &lfs_file_cfg);
+    if (err == LFS_ERR_NOENT) {
+        return 0;
+    }
+    if (err) {
+        return err;
+    }
+    lfs_ssize_t got = lfs_file_read(&lfs, &lfs_log_file, buf, cap);
+    lfs_file_close(&lfs, &lfs_log_file);
+    if (got < 0) {
+        return got;
+    }
+    *len = got;
+    return 0;
+}
+
+static void littlefs_info(size_t *total, size_t *used)
+{
+    lfs_ssize_t blocks = lfs_fs_size(&lfs);
+    *total = (size_t)lfs_cfg.block_count * lfs_cfg.block_size;
+    *used = blocks < 0 ? 0 : (size_t)blocks * lfs_cfg.block_size;
+}
+
+static const fs_ops_t littlefs_ops = {
+    .name = "littlefs",
+    .format = littlefs_format,
+    .mount = littlefs_mount,
+    .unmount = littlefs_unmount,
+    .fill = littlefs_fill,
+    .log_open = littlefs_log_open,
+    .log_append = littlefs_log_append,
+    .log_close = littlefs_log_close,
+    .log_read = littlefs_log_read,
+    .info = littlefs_info,
+};
+
+/* ---- spiffs ---- */
+
+static spiffs spiffs_fs;
+static spiffs_file spiffs_log_file;
+static uint8_t spiffs_work[SPIFFS_PAGE_SIZE * 2];
+static uint32_t spiffs_fds[SPIFFS_FD_SIZE * SPIFFS_MAX_FILES / 4];
+static uint32_t spiffs_cache[((SPIFFS_PAGE_SIZE + 32) * SPIFFS_CACHE_PAGES + 64) / 4];
+
+static s32_t spiffs_hal_read(u32_t addr, u32_t size, u8_t *dst)
+{
+    flash_read(addr, dst, size);
+    return SPIFFS_OK;
+}
+
+static s32_t spiffs_hal_write(u32_t addr, u32_t size, u8_t *src)
+{
+    flash_prog(addr, src, size);
+    return SPIFFS_OK;
+}
+
+static s32_t spiffs_hal_erase(u32_t addr, u32_t size)
+{
+    flash_erase(addr, size);
+    return SPIFFS_OK;
+}
+
+static int spiffs_do_mount(void)
+{
+    spiffs_config cfg = {
+        .hal_read_f = spiffs_hal_read,
+        .hal_write_f = spiffs_hal_write,
+        .hal_erase_f = spiffs_hal_erase,
+        .phys_size = FLASH_SIZE,
+        .phys_addr = 0,
+        .phys_erase_block = SECTOR_SIZE,
+        .log_block_size = SECTOR_SIZE,
+        .log_page_size = SPIFFS_PAGE_SIZE,
+    };
+    return SPIFFS_mount(&spiffs_fs, &cfg, spiffs_work, (u8_t *)spiffs_fds, sizeof(spiffs_fds),
+                        spiffs_cache, sizeof(spiffs_cache), NULL);
+}
+
+/* SPIFFS_format() 需要先嘗試掛載以設定分區參數 */
+static int spiffs_do_format(void)
+{
+    if (spiffs_do_mount() == SPIFFS_OK) {
+        SPIFFS_unmount(&spiffs_fs);
+    }
+    return SPIFFS_format(&spiffs_fs);
+}
+
+static void spiffs_do_unmount(void)
+{
+    SPIFFS_unmount(&spiffs_fs);
+}
+
+static int spiffs_fill(size_t len)
+{
+    static uint8_t block[SECTOR_SIZE];
+    spiffs_file f = SPIFFS_open(&spiffs_fs, "/fill.bin", SPIFFS_O_CREAT | SPIFFS_O_TRUNC | SPIFFS_O_WRONLY, 0);
+    if (f < 0) {
+        return f;
+    }
+    memset(block, 'x', sizeof(block));
+    for (size_t n = 0; n < len; n += sizeof(block)) {
+        if (SPIFFS_write(&spiffs_fs, f, block, sizeof(block)) != sizeof(block)) {
+            break;  // 分區已滿 (spiffs 需保留空間)，以實際寫入的量為準
+        }
+    }
+    return SPIFFS_close(&spiffs_fs, f);
+}
+
+static int spiffs_log_open(void)
+{
+    spiffs_log_file = SPIFFS_open(&spiffs_fs, "/data.json", SPIFFS_O_CREAT | SPIFFS_O_APPEND | SPIFFS_O_WRONLY, 0);
+    return spiffs_log_file < 0 ? spiffs_log_file : 0;
+}
+
+static int spiffs_log_append(const char *record, size_t len)
+{
+    if (SPIFFS_write(&spiffs_fs, spiffs_log_file, (void *)record, len) != (s32_t)len) {
+        return -1;
+    }
+    return SPIFFS_fflush(&spiffs_fs, spiffs_log_file);
+}
+
+static void spiffs_log_close(void)
+{
+    SPIFFS_close(&spiffs_fs, spiffs_log_file);
+}
+
+static int spiffs_log_read(char *buf, size_t cap, size_t *len)
+{
+    spiffs_stat st;
+    *len = 0;
+    spiffs_file f = SPIFFS_open(&spiffs_fs, "/data.json", SPIFFS_O_RDONLY, 0);
+    if (f < 0) {
+        return f == SPIFFS_ERR_NOT_FOUND ? 0 : f;
+    }
+    s32_t res = SPIFFS_fstat(&spiffs_fs, f, &st);
+    if (res == SPIFFS_OK && st.size > 0) {
+        res = SPIFFS_read(&spiffs_fs, f, buf, st.size < cap ? st.size : cap);
+        if (res >= 0) {
+            *len = res;
+            res = SPIFFS_OK;
+        }
+    }
+    SPIFFS_close(&spiffs_fs, f);
+    return res;
+}
+
+static void spiffs_info(size_t *total, size_t *used)
+{
+    u32_t t = 0, u = 0;
+    SPIFFS_info(&spiffs_fs, &t, &u);
+    *total = t;
+    *used = u;
+}
+
+static const fs_ops_t spiffs_ops = {
+    .name = "spiffs",
+    .format = spiffs_do_format,
+    .mount = spiffs_do_mount,
+    .unmount = spiffs_do_unmount,
+    .fill = spiffs_fill,
+    .log_open = spiffs_log_open,
+    .log_append = spiffs_log_append,
+    .log_close = spiffs_log_close,
+    .log_read = spiffs_log_read,
+    .info = spiffs_info,
+};
+
+/* ---- 量測 ---- */
+
+static int make_record(int seq, char *buf)
+{
+    return snprintf(buf, RECORD_MAX, "{\"event\":\"bench\",\"time after startup(ms)\":%d}\n", seq);
+}
+
+typedef struct {
+    int  records;       // 開頭連續且正確的紀錄數
+    bool torn;          // 之後還有不是完整紀錄的資料
+} log_check_t;
+
+/* 紀錄必須依序為 make_record(0..)，之後不應有其他資料 */
+static log_check_t check_log(const char *buf, size_t len)
+{
+    log_check_t result = { 0, false };
+    char expected[RECORD_MAX];
+    size_t pos = 0;
+
+    while (pos < len) {
+        int n = make_record(result.records, expected);
+        if (len - pos < (size_t)n || memcmp(buf + pos, expected, n) != 0) {
+            result.torn = true;
+            break;
+        }
+        pos += n;
+        result.records++;
+    }
+    return result;
+}
+
+typedef struct {
+    int     cuts;
+    int     mount_failed;   // 重新掛載失敗，設備會格式化分區
+    int     records_lost;   // 已 fsync 的紀錄遺失 (或無法讀取) 的斷電點數
+    int     torn;           // 留下不完整紀錄的斷電點數
+    int64_t recover_ns_max; // 斷電後重新掛載的最長耗時
+} cut_result_t;
+
+/*
+  由 base 開始 append APPENDS 筆紀錄，回傳完成 fsync 的筆數。
+  cut_at >= 0 時在該次 flash 操作斷電，*cut 為 true
+*/
+static int run_appends(const fs_ops_t *fs, bool *cut)
+{
+    static volatile int committed;
+    char record[RECORD_MAX];
+
+    committed = 0;
+    *cut = false;
+    flash_ops = 0;
+    if (setjmp(power_cut)) {
+        *cut = true;
+        cut_at = -1;
+        return committed;
+    }
+    if (fs->mount() != 0 || fs->log_open() != 0) {
+        return -1;
+    }
+    for (int i = 0; i < APPENDS; i++) {
+        int n = make_record(i, record);
+        if (fs->log_append(record, n) != 0) {
+            break;
+        }
+        committed++;
+    }
+    fs->log_close();
+    fs->unmount();
+    return committed;
+}
+
+/* 斷電後重新掛載並讀出紀錄 */
+static void recover(const fs_ops_t *fs, int committed, cut_result_t *result)
+{
+    static char buf[LOG_MAX];
+    size_t len;
+
+    int64_t start = now_ns();
+    int err = fs->mount();
+    int64_t ns = now_ns() - start;
+    if (ns > result->recover_ns_max) {
+        result->recover_ns_max = ns;
+    }
+    if (err != 0) {
+        result->mount_failed++;
+        return;
+    }
+    if (fs->log_read(buf, sizeof(buf), &len) != 0) {
+        result->records_lost++;
+    } else {
+        log_check_t log = check_log(buf, len);
+        // 斷電時寫入中的紀錄可以完整出現或不出現
+        if (log.records < committed) {
+            result->records_lost++;
+        }
+        if (log.torn) {
+            result->torn++;
+        }
+    }
+    fs->unmount();
+}
+
+static void bench_fs(const fs_ops_t *fs, unsigned fill_pct, long max_cuts)
+{
+    static char buf[LOG_MAX];
+    char record[RECORD_MAX];
+    size_t total = 0, used = 0, len = 0;
+    flash_stats_t before;
+
+    memset(flash, 0xff, FLASH_SIZE);
+    TEST_CHECK_INT(0, fs->format());
+    TEST_CHECK_INT(0, fs->mount());
+    fs->info(&total, &used);
+    TEST_CHECK_INT(0, fs->fill(total / 100 * fill_pct));
+    fs->unmount();
+    memcpy(base, flash, FLASH_SIZE);
+
+    // 掛載
+    stats = (flash_stats_t){ 0 };
+    int64_t start = now_ns();
+    int err = fs->mount();
+    int64_t mount_ns = now_ns() - start;
+    uint64_t mount_read_bytes = stats.read_bytes;
+    TEST_CHECK_INT(0, err);
+    if (err != 0) {
+        return;
+    }
+
+    // append (含 fsync)
+    int64_t append_total_ns = 0, append_max_ns = 0;
+    TEST_CHECK_INT(0, fs->log_open());
+    before = stats;
+    for (int i = 0; i < APPENDS; i++) {
+        int n = make_record(i, record);
+        start = now_ns();
+        TEST_CHECK_INT(0, fs->log_append(record, n));
+        int64_t ns = now_ns() - start;
+        append_total_ns += ns;
+        if (ns > append_max_ns) {
+            append_max_ns = ns;
+        }
+    }
+    fs->log_close();
+    uint64_t append_prog = stats.prog_bytes - before.prog_bytes;
+    uint64_t append_erases = stats.erases - before.erases;
+    TEST_CHECK_INT(0, fs->log_read(buf, sizeof(buf), &len));
+    log_check_t log = check_log(buf, len);
+    TEST_CHECK_INT(APPENDS, log.records);
+    TEST_CHECK(!log.torn);
+    fs->info(&total, &used);
+    fs->unmount();
+
+    printf("{\"bench\":\"event_store\",\"backend\":\"%s\",\"fill_pct\":%u,\"used\":%zu,\"total\":%zu,"
+           "\"mount_ns\":%lld,\"mount_read_bytes\":%llu,\"append_avg_ns\":%lld,\"append_max_ns\":%lld,"
+           "\"append_prog_bytes\":%llu,\"append_erases\":%.2f}\n",
+           fs->name, fill_pct, used, total, (long long)mount_ns, (unsigned long long)mount_read_bytes,
+           (long long)(append_total_ns / APPENDS), (long long)append_max_ns,
+           (unsigned long long)(append_prog / APPENDS), (double)append_erases / APPENDS);
+
+    // 沒有斷電時的 flash 操作次數，即可斷電的位置
+    bool cut;
+    memcpy(flash, base, FLASH_SIZE);
+    TEST_CHECK_INT(APPENDS, run_appends(fs, &cut));
+    long ops = flash_ops;
+    long step = ops > max_cuts ? (ops + max_cuts - 1) / max_cuts : 1;
+
+    cut_result_t result = { 0 };
+    for (long n = 0; n < ops; n += step) {
+        memcpy(flash, base, FLASH_SIZE);
+        cut_at = n;
+        int committed = run_appends(fs, &cut);
+        cut_at = -1;
+        if (!cut) {
+            continue;
+        }
+        result.cuts++;
+        recover(fs, committed < 0 ? 0 : committed, &result);
+    }
+    printf("{\"bench\":\"event_store_power_cut\",\"backend\":\"%s\",\"fill_pct\":%u,\"flash_ops\":%ld,\"cuts\":%d,"
+           "\"mount_failed\":%d,\"records_lost\":%d,\"torn\":%d,\"recover_mount_max_ns\":%lld}\n",
+           fs->name, fill_pct, ops, result.cuts, result.mount_failed, result.records_lost, result.torn,
+           (long long)result.recover_ns_max);
+    if (fs == &littlefs_ops) {
+        // littlefs 在 fsync 完成後才更新 metadata，任何斷電點都不遺失已寫入的紀錄
+        TEST_CHECK_INT(0, result.mount_failed);
+        TEST_CHECK_INT(0, result.records_lost);
+        TEST_CHECK_INT(0, result.torn);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const unsigned fill_pcts[] = { 0, 25, 50, 75 };
+    static const fs_ops_t *const backends[] = { &spiffs_ops, &littlefs_ops };
+    long max_cuts = argc > 1 ? atol(argv[1]) : DEFAULT_CUTS;
+
+    if (max_cuts <= 0) {
+        max_cuts = DEFAULT_CUTS;
+    }
+    int fd = open(IMAGE_FILE, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, FLASH_SIZE) != 0) {
+        perror(IMAGE_FILE);
+        return 1;
+    }
+    flash = mmap(NULL, FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    base = malloc(FLASH_SIZE);
+    if (flash == MAP_FAILED || base == NULL) {
+        perror("flash image");
+        return 1;
+    }
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        for (size_t i = 0; i < sizeof(fill_pcts) / sizeof(fill_pcts[0]); i++) {
+            bench_fs(backends[b], fill_pcts[i], max_cuts);
+        }
+    }
+    munmap(flash, FLASH_SIZE);
+    close(fd);
+    free(base);
+    return TEST_EXIT();
+}
@@ -0,0 +1,164 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  GATT 寫入分派: gatts_dispatch 的 handle 查表與原本逐一比較 handle 的判斷鏈。
+  判斷鏈與原本的寫法相同，每個寫入都比較所有 characteristic (沒有 else)。
+  寫入的組成模擬 OTA 期間: 大部分為 OTA Data，其餘平均分配到其他屬性。
+
+  先確認兩種方式呼叫相同的處理函數，再量測每次分派的時間，屬性數由目前的 5 個增加到
+  GATTS_DISPATCH_MAX_ATTRS。數值為主機上的相對比較，不代表 ESP32-H2 上的時間。
+
+  bench_gatts_dispatch [每種設定的寫入次數]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gatts_dispatch.h"
+#include "test_util.h"
+
+#define DEFAULT_WRITES      2000000
+#define FIRST_HANDLE        40      // 第一個 service 的起始 handle
+#define ATTRS_PER_CHAR      2       // characteristic 宣告 + 值
+#define OTA_DATA_PERCENT    95
+#define WRITE_MIX_LEN       4096
+
+/* 目前有處理函數的屬性: OTA Control、OTA Data、CCCD A2、B2 (事件紀錄)、C2 (診斷) */
+#define CURRENT_ATTRS       5
+#define OTA_DATA_INDEX      1       // 判斷鏈中 OTA Data 的位置，與原本的程式相同
+
+typedef struct {
+    uint16_t         handle;
+    gatts_write_cb_t write;
+    void            *ctx;
+} chain_entry_t;
+
+static chain_entry_t chain[GATTS_DISPATCH_MAX_ATTRS];
+static int chain_len;
+static uint16_t handles[GATTS_DISPATCH_MAX_ATTRS];
+static gatts_attr_ops_t ops[GATTS_DISPATCH_MAX_ATTRS];
+static uint32_t hits[GATTS_DISPATCH_MAX_ATTRS];
+static uint16_t write_mix[WRITE_MIX_LEN];
+
+static esp_gatt_status_t count_write(esp_gatt_if_t gatts_if, ble_conn_t *conn,
+                                     esp_ble_gatts_cb_param_t *param, void *ctx)
+{
+    (*(uint32_t *)ctx)++;
+    return ESP_GATT_OK;
+}
+
+/* 原本的寫法: 每個 characteristic 一個 if，全部比較完 */
+static __attribute__((noinline)) esp_gatt_status_t chain_dispatch(esp_ble_gatts_cb_param_t *param)
+{
+    esp_gatt_status_t status = ESP_GATT_OK;
+    for (int i = 0; i < chain_len; i++) {
+        if (chain[i].handle == param->write.handle) {
+            status = chain[i].write(0, NULL, param, chain[i].ctx);
+        }
+    }
+    return status;
+}
+
+static __attribute__((noinline)) esp_gatt_status_t table_dispatch(esp_ble_gatts_cb_param_t *param)
+{
+    const gatts_attr_ops_t *attr = gatts_dispatch_lookup(param->write.handle);
+    if (attr && attr->write) {
+        return attr->write(0, NULL, param, attr->ctx);
+    }
+    return ESP_GATT_OK;
+}
+
+/* attr_num 個屬性，值的 handle 依序排列；寫入以 OTA_DATA_PERCENT 寫到 OTA Data */
+static void setup(int attr_num)
+{
+    chain_len = attr_num;
+    gatts_dispatch_reset();
+    for (int i = 0; i < attr_num; i++) {
+        handles[i] = FIRST_HANDLE + i * ATTRS_PER_CHAR + 1;
+        ops[i] = (gatts_attr_ops_t){ .write = count_write, .ctx = &hits[i] };
+        chain[i] = (chain_entry_t){ .handle = handles[i], .write = count_write, .ctx = &hits[i] };
+    }
+    TEST_CHECK_INT(ESP_OK, gatts_dispatch_register(handles, ops, attr_num));
+
+    srand(attr_num);
+    for (int i = 0; i < WRITE_MIX_LEN; i++) {
+        int target = OTA_DATA_INDEX;
+        if (rand() % 100 >= OTA_DATA_PERCENT) {
+            target = rand() % attr_num;
+        }
+        write_mix[i] = handles[target];
+    }
+}
+
+typedef esp_gatt_status_t (*dispatch_fn_t)(esp_ble_gatts_cb_param_t *param);
+
+/* 回傳每次分派的 ns，hits 記錄每個屬性被呼叫的次數 */
+static double run(dispatch_fn_t dispatch, long writes)
+{
+    esp_ble_gatts_cb_param_t param = {0};
+    struct timespec start, end;
+
+    for (int i = 0; i < chain_len; i++) {
+        hits[i] = 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long n = 0; n < writes; n++) {
+        param.write.handle = write_mix[n % WRITE_MIX_LEN];
+        dispatch(&param);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    return ns / writes;
+}
+
+/* 兩種方式必須呼叫相同的處理函數，未註冊的 handle 都不呼叫 */
+static void check_same_targets(int attr_num)
+{
+    esp_ble_gatts_cb_param_t param = {0};
+    uint32_t chain_hits[GATTS_DISPATCH_MAX_ATTRS];
+    uint16_t last = FIRST_HANDLE + attr_num * ATTRS_PER_CHAR + 2;
+
+    for (uint16_t handle = 0; handle <= last; handle++) {
+        param.write.handle = handle;
+        for (int i = 0; i < attr_num; i++) {
+            hits[i] = 0;
+        }
+        chain_dispatch(&param);
+        for (int i = 0; i < attr_num; i++) {
+            chain_hits[i] = hits[i];
+            hits[i] = 0;
+        }
+        table_dispatch(&param);
+        for (int i = 0; i < attr_num; i++) {
+            TEST_CHECK_INT(chain_hits[i], hits[i]);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const int attr_nums[] = { CURRENT_ATTRS, 8, 16, GATTS_DISPATCH_MAX_ATTRS };
+    long writes = argc > 1 ? atol(argv[1]) : DEFAULT_WRITES;
+
+    if (writes <= 0) {
+        writes = DEFAULT_WRITES;
+    }
+    printf("%-6s %14s %14s %8s\n", "attrs", "chain ns/op", "table ns/op", "ratio");
+    for (size_t i = 0; i < sizeof(attr_nums) / sizeof(attr_nums[0]); i++) {
+        int attr_num = attr_nums[i];
+        setup(attr_num);
+        check_same_targets(attr_num);
+        double chain_ns = run(chain_dispatch, writes);
+        uint32_t chain_data_hits = hits[OTA_DATA_INDEX];
+        double table_ns = run(table_dispatch, writes);
+        TEST_CHECK_INT(chain_data_hits, hits[OTA_DATA_INDEX]);
+        printf("%-6d %14.2f %14.2f %8.2f\n", attr_num, chain_ns, table_ns, chain_ns / table_ns);
+    }
+    return TEST_EXIT();
+}
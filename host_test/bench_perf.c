@@ -0,0 +1,239 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  韌體熱路徑的 micro-benchmark: 事件序列化、GATT handle 查表、長寫入緩衝、喚醒腳位解碼、
+  OTA 第一個 chunk 的映像開頭檢查與溫度封包打包。每項輸出一行 JSON，可逐次 commit 比較:
+  {"bench":"<名稱>","iterations":N,"ns_per_op":x,"allocs_per_op":x,"bytes_per_op":x}
+
+  配置次數與位元組數以連結時包裝 malloc/calloc/realloc 統計 (-Wl,--wrap)。
+  event_format 在設備上由 MEM_BUDGET_JSON_POOL 配置 (MEM_BUDGET_STATIC)，主機上不使用 pool，
+  統計的是 cJSON 本身的配置；需要 cJSON 的原始碼 (CJSON_DIR)，找不到時不量測。
+  耗時為主機上的相對比較，不代表 ESP32-H2 上的時間。
+
+  bench_perf [每項的次數]
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sdkconfig.h"
+#include "esp_app_format.h"
+#include "gatts_dispatch.h"
+#include "ota_image_check.h"
+#include "prepare_write.h"
+#include "temperature_frame.h"
+#include "wake_fsm.h"
+#if BENCH_EVENT_FORMAT
+#include "event_store.h"
+#endif
+#include "test_util.h"
+
+#define DEFAULT_ITERATIONS  1000000
+#define BENCH_HANDLE_BASE   40      // 與實際 attribute handle 範圍相近
+#define BENCH_HANDLE_NUM    16
+#define BENCH_CONN_ID       0       // 主機上只有這個連線
+#define BENCH_TEMP_SAMPLES  64
+#define BENCH_FRAME_LEN     (500 - 3)   // GATTS_LOCAL_MTU - ATT_WRITE_HEADER_LEN
+
+static bool counting;
+static uint64_t alloc_count;
+static uint64_t alloc_bytes;
+static volatile uint32_t sink;      // 避免編譯器移除被測的程式
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    if (counting) {
+        alloc_count++;
+        alloc_bytes += size;
+    }
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    if (counting) {
+        alloc_count++;
+        alloc_bytes += n * size;
+    }
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    if (counting) {
+        alloc_count++;
+        alloc_bytes += size;
+    }
+    return __real_realloc(ptr, size);
+}
+
+esp_err_t esp_ble_gatts_send_response(esp_gatt_if_t gatts_if, uint16_t conn_id, uint32_t trans_id,
+                                      esp_gatt_status_t status, esp_gatt_rsp_t *rsp)
+{
+    return ESP_OK;
+}
+
+#if BENCH_EVENT_FORMAT
+/* 設備上切換 cJSON 到 pool，主機上使用 heap (見檔案開頭) */
+void mem_budget_json_begin(void)
+{
+}
+
+void mem_budget_json_end(void)
+{
+}
+#endif
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+typedef void (*bench_fn_t)(int i);
+
+static void bench(const char *name, bench_fn_t fn, int iterations)
+{
+    alloc_count = 0;
+    alloc_bytes = 0;
+    counting = true;
+    int64_t start = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        fn(i);
+    }
+    int64_t elapsed_ns = now_ns() - start;
+    counting = false;
+
+    printf("{\"bench\":\"%s\",\"iterations\":%d,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f}\n",
+           name, iterations, (double)elapsed_ns / iterations, (double)alloc_count / iterations,
+           (double)alloc_bytes / iterations);
+}
+
+#if BENCH_EVENT_FORMAT
+/* 事件紀錄的 JSON 序列化 (write_event_log) */
+static void bench_event_format(int i)
+{
+    static char record[MEM_BUDGET_EVENT_RECORD];
+    TEST_CHECK_INT(ESP_OK, event_store_format("Temperature1 ≤ 1°C", i, record, sizeof(record)));
+    sink += record[0];
+}
+#endif
+
+static esp_gatt_status_t bench_write_cb(esp_gatt_if_t gatts_if, ble_conn_t *conn, esp_ble_gatts_cb_param_t *param, void *ctx)
+{
+    return ESP_GATT_OK;
+}
+
+/* GATT 寫入事件的 handle 查表 */
+static void bench_dispatch_lookup(int i)
+{
+    const gatts_attr_ops_t *ops = gatts_dispatch_lookup(BENCH_HANDLE_BASE + i % BENCH_HANDLE_NUM);
+    sink += ops != NULL;
+}
+
+/* 長寫入: 一次 prepare write 的緩衝，每 4 次為一個 512 bytes 的長寫入 */
+static void bench_prepare_write(int i)
+{
+    static uint8_t value[128];
+    esp_ble_gatts_cb_param_t param = {
+        .write = {
+            .conn_id = BENCH_CONN_ID,
+            .handle = BENCH_HANDLE_BASE,
+            .offset = (i % 4) * sizeof(value),
+            .len = sizeof(value),
+            .need_rsp = false,
+            .is_prep = true,
+            .value = value,
+        },
+    };
+    prepare_write_event(ESP_GATT_IF_NONE, &param);
+    if (i % 4 == 3) {
+        prepare_write_conn_close(BENCH_CONN_ID);
+    }
+}
+
+/* 喚醒腳位對應事件 */
+static void bench_wake_decode(int i)
+{
+    sink += wake_fsm_event_name(BLE_WAKEUP_GPIO + i % 6) != NULL;
+}
+
+/* OTA: 第一個 chunk 的映像開頭檢查 */
+static void bench_ota_image_check(int i)
+{
+    static uint8_t head[OTA_IMAGE_CHECK_LEN];
+    if (head[0] == 0) {
+        esp_image_header_t *header = (esp_image_header_t *)head;
+        header->magic = ESP_IMAGE_HEADER_MAGIC;
+        header->segment_count = 1;
+        header->chip_id = CONFIG_IDF_FIRMWARE_CHIP_ID;
+    }
+    sink += ota_image_check(head, sizeof(esp_image_header_t), NULL);
+}
+
+/* 溫度封包打包 (一包 MTU 500) */
+static void bench_temperature_frame(int i)
+{
+    static temperature_sample_t samples[BENCH_TEMP_SAMPLES];
+    static uint8_t frame[BENCH_FRAME_LEN];
+    size_t packed;
+    for (int n = 0; n < BENCH_TEMP_SAMPLES; n++) {
+        samples[n].timestamp_ms = (i + n) * 1000;
+        samples[n].centi_celsius = 2500 + (n % 7) - 3;
+    }
+    sink += temperature_frame_encode(samples, BENCH_TEMP_SAMPLES, i, frame, sizeof(frame), &packed);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        iterations = DEFAULT_ITERATIONS;
+    }
+
+#if BENCH_EVENT_FORMAT
+    bench("event_format", bench_event_format, iterations);
+#endif
+    bench("wake_decode", bench_wake_decode, iterations);
+    bench("ota_image_check", bench_ota_image_check, iterations);
+    bench("temperature_frame_encode", bench_temperature_frame, iterations);
+
+    static const gatts_attr_ops_t ops[BENCH_HANDLE_NUM] = {
+        [0] = { .write = bench_write_cb },
+        [BENCH_HANDLE_NUM / 2] = { .write = bench_write_cb },
+    };
+    uint16_t handles[BENCH_HANDLE_NUM];
+    for (int i = 0; i < BENCH_HANDLE_NUM; i++) {
+        handles[i] = BENCH_HANDLE_BASE + i;
+    }
+    TEST_CHECK_INT(ESP_OK, gatts_dispatch_register(handles, ops, BENCH_HANDLE_NUM));
+    bench("gatts_dispatch_lookup", bench_dispatch_lookup, iterations);
+    bench("prepare_write", bench_prepare_write, iterations);
+
+    // 韌體的熱路徑都不應在 heap 配置 (event_format 在設備上使用 pool)
+    alloc_count = 0;
+    counting = true;
+    bench_wake_decode(0);
+    bench_ota_image_check(0);
+    bench_temperature_frame(0);
+    bench_dispatch_lookup(0);
+    for (int i = 0; i < 4; i++) {
+        bench_prepare_write(i);
+    }
+    counting = false;
+    TEST_CHECK_INT(0, alloc_count);
+    return TEST_EXIT();
+}
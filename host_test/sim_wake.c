@@ -0,0 +1,397 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  喚醒流程模擬: 以虛擬時鐘執行 main/wake_fsm.c 與 main/power_model.c，重播腳本中的喚醒事件，
+  結束時印出 power_model_report() 的耗電估計。平台操作以固定的時間代替:
+
+    - light sleep 直接把時鐘推進到下一個腳本事件或 timer 喚醒
+    - 寫入事件紀錄、取樣、啟動各花費腳本設定的時間 (cost)
+    - 藍芽廣播與連線、console 依腳本的時間長度進行後重新啟動
+    - 重新啟動以 longjmp 回到啟動流程，power_stats_t 保留 (與 __NOINIT_ATTR 相同)
+
+  timer 取樣的週期固定為腳本的 period，不模擬 temp_sampler 依溫度調整週期與重複事件的 hold-off。
+
+  腳本每行一項，# 之後為註解，時間單位為 ms:
+
+    period <ms>                     timer 取樣週期，0 表示不以 timer 喚醒
+    cost boot|event|sample <ms>     重新啟動到 app_main、寫入事件紀錄、一次取樣的時間
+    end <ms>                        模擬的總時間
+    <ms> gpio <10 ~ 14>             GPIO 喚醒
+    <ms> ble <廣播 ms> <連線 ms>    pin 9 喚醒，廣播後連線，斷線後重新啟動
+    <ms> uart <輸入 ms>             UART 喚醒，console 輸入結束後閒置 DIAG_CONSOLE_IDLE_MS 重新啟動
+    <ms> temp <10 ~ 12>             此時間之後的第一次取樣跨越臨界值
+
+  事件依時間排列；清醒時到達的事件在下一次進入 light sleep 時立即喚醒。
+
+  sim_wake [-v] <腳本>...   -v 同時印出喚醒流程本身的輸出
+*/
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "diag_console.h"
+#include "power_model.h"
+#include "wake_fsm.h"
+#include "wake_session.h"
+#include "test_util.h"
+
+#define SIM_MAX_EVENTS      256
+#define SIM_LINE_MAX        128
+#define SIM_US(ms)          ((int64_t)(ms) * 1000)
+
+/* 預設的時間為估計值，腳本以 cost 覆寫 */
+#define SIM_BOOT_MS         300
+#define SIM_EVENT_MS        500
+#define SIM_SAMPLE_MS       5
+
+typedef enum {
+    SIM_GPIO,
+    SIM_BLE,
+    SIM_UART,
+    SIM_TEMP,
+} sim_kind_t;
+
+typedef struct {
+    int64_t    at_us;
+    sim_kind_t kind;
+    uint8_t    gpio;
+    int64_t    first_us;        // ble: 廣播，uart: 輸入
+    int64_t    second_us;       // ble: 連線
+    bool       done;
+} sim_event_t;
+
+typedef enum {
+    SIM_WAKE_NONE,
+    SIM_WAKE_GPIO,
+    SIM_WAKE_UART,
+    SIM_WAKE_TIMER,
+} sim_wake_t;
+
+static struct {
+    sim_event_t events[SIM_MAX_EVENTS];
+    int         event_num;
+    int64_t     period_us;
+    int64_t     boot_us;
+    int64_t     event_us;
+    int64_t     sample_us;
+    int64_t     end_us;
+
+    int64_t     clock_us;       // 模擬開始後的時間
+    int64_t     boot_at_us;     // 本次啟動時的 clock_us，now_us() 由此歸零
+    sim_wake_t  wake;
+    sim_event_t *woken;         // 造成本次 GPIO/UART 喚醒的事件
+    uint32_t    restarts;
+    uint32_t    events_written;
+    uint32_t    samples;
+} sim;
+
+static power_stats_t stats;
+static jmp_buf boot_jmp;
+static jmp_buf end_jmp;
+
+static void sim_advance(int64_t us)
+{
+    sim.clock_us += us;
+}
+
+static int64_t sim_now_us(void)
+{
+    return sim.clock_us - sim.boot_at_us;
+}
+
+/* 下一個尚未處理的 GPIO/UART 喚醒 */
+static sim_event_t *next_wake_event(void)
+{
+    for (int i = 0; i < sim.event_num; i++) {
+        if (!sim.events[i].done && sim.events[i].kind != SIM_TEMP) {
+            return &sim.events[i];
+        }
+    }
+    return NULL;
+}
+
+static void sim_light_sleep(void)
+{
+    sim_event_t *ev = next_wake_event();
+    int64_t wake_at = sim.end_us;
+
+    sim.wake = SIM_WAKE_NONE;
+    sim.woken = NULL;
+    if (sim.period_us > 0 && sim.clock_us + sim.period_us < wake_at) {
+        wake_at = sim.clock_us + sim.period_us;
+        sim.wake = SIM_WAKE_TIMER;
+    }
+    if (ev && ev->at_us <= wake_at) {
+        wake_at = ev->at_us > sim.clock_us ? ev->at_us : sim.clock_us;
+        sim.wake = ev->kind == SIM_UART ? SIM_WAKE_UART : SIM_WAKE_GPIO;
+        sim.woken = ev;
+    }
+    if (sim.wake == SIM_WAKE_NONE) {
+        // 沒有其他喚醒，睡到模擬結束
+        sim.clock_us = sim.end_us;
+        longjmp(end_jmp, 1);
+    }
+    sim.clock_us = wake_at;
+}
+
+static bool sim_woken_by_gpio(void)
+{
+    return sim.wake == SIM_WAKE_GPIO;
+}
+
+static bool sim_woken_by_uart(void)
+{
+    return sim.wake == SIM_WAKE_UART;
+}
+
+static bool sim_woken_by_timer(void)
+{
+    return sim.wake == SIM_WAKE_TIMER;
+}
+
+/* 取樣: 已到達時間的 temp 事件表示跨越臨界值 */
+static wake_sample_t sim_sample(uint8_t *gpio)
+{
+    sim_advance(sim.sample_us);
+    sim.samples++;
+    for (int i = 0; i < sim.event_num; i++) {
+        sim_event_t *ev = &sim.events[i];
+        if (ev->kind == SIM_TEMP && !ev->done && ev->at_us <= sim.clock_us) {
+            ev->done = true;
+            *gpio = ev->gpio;
+            return WAKE_SAMPLE_EVENT;
+        }
+    }
+    return WAKE_SAMPLE_SLEEP;
+}
+
+static uint8_t sim_wait_gpio_inactive(void)
+{
+    sim.woken->done = true;
+    return sim.woken->gpio;
+}
+
+static void sim_write_event(uint8_t gpio)
+{
+    // 與 wake_session 相同，最長 WAKE_SESSION_DEADLINE_MS
+    sim_advance(sim.event_us < SIM_US(WAKE_SESSION_DEADLINE_MS) ? sim.event_us : SIM_US(WAKE_SESSION_DEADLINE_MS));
+    sim.events_written++;
+}
+
+/* 廣播後連線，斷線後與 app_main.c 的 ble_disconnected() 相同重新啟動 */
+static void sim_start_ble(void)
+{
+    sim_advance(sim.woken->first_us);
+    wake_fsm_set_state(WAKE_STATE_BLE_CONN);
+    sim_advance(sim.woken->second_us);
+    wake_fsm_restart();
+}
+
+static void sim_start_console(void)
+{
+    sim.woken->done = true;
+    sim_advance(sim.woken->first_us + SIM_US(DIAG_CONSOLE_IDLE_MS));
+    wake_fsm_restart();
+}
+
+static void sim_restart(void)
+{
+    sim.restarts++;
+    longjmp(boot_jmp, 1);
+}
+
+static const wake_platform_t sim_platform = {
+    .now_us = sim_now_us,
+    .light_sleep = sim_light_sleep,
+    .woken_by_gpio = sim_woken_by_gpio,
+    .woken_by_uart = sim_woken_by_uart,
+    .woken_by_timer = sim_woken_by_timer,
+    .sample = sim_sample,
+    .wait_gpio_inactive = sim_wait_gpio_inactive,
+    .start_ble = sim_start_ble,
+    .write_event = sim_write_event,
+    .start_console = sim_start_console,
+    .restart = sim_restart,
+    .stats = &stats,
+};
+
+static int parse_error(const char *path, int line, const char *text)
+{
+    fprintf(stderr, "%s:%d: %s\n", path, line, text);
+    return -1;
+}
+
+static int load_script(const char *path)
+{
+    char text[SIM_LINE_MAX];
+    int line = 0;
+    FILE *f = fopen(path, "r");
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    memset(&sim, 0, sizeof(sim));
+    sim.boot_us = SIM_US(SIM_BOOT_MS);
+    sim.event_us = SIM_US(SIM_EVENT_MS);
+    sim.sample_us = SIM_US(SIM_SAMPLE_MS);
+
+    int ret = 0;
+    while (ret == 0 && fgets(text, sizeof(text), f)) {
+        char *comment = strchr(text, '#');
+        char word[16];
+        long long a, b, c;
+
+        line++;
+        if (comment) {
+            *comment = '\0';
+        }
+        if (sscanf(text, " %15s", word) != 1) {
+            continue;
+        }
+        if (sscanf(text, " period %lld", &a) == 1) {
+            sim.period_us = SIM_US(a);
+        } else if (sscanf(text, " cost %15s %lld", word, &a) == 2) {
+            if (strcmp(word, "boot") == 0) {
+                sim.boot_us = SIM_US(a);
+            } else if (strcmp(word, "event") == 0) {
+                sim.event_us = SIM_US(a);
+            } else if (strcmp(word, "sample") == 0) {
+                sim.sample_us = SIM_US(a);
+            } else {
+                ret = parse_error(path, line, "unknown cost");
+            }
+        } else if (sscanf(text, " end %lld", &a) == 1) {
+            sim.end_us = SIM_US(a);
+        } else if (sscanf(text, " %lld %15s", &a, word) == 2) {
+            sim_event_t *ev = &sim.events[sim.event_num];
+            b = c = 0;
+            if (sim.event_num == SIM_MAX_EVENTS) {
+                ret = parse_error(path, line, "too many events");
+                break;
+            }
+            if (sim.event_num > 0 && SIM_US(a) < ev[-1].at_us) {
+                ret = parse_error(path, line, "events out of order");
+                break;
+            }
+            ev->at_us = SIM_US(a);
+            if (strcmp(word, "gpio") == 0 && sscanf(text, " %*s %*s %lld", &b) == 1
+                && b >= TEMPERATURE_WAKEUP_GPIO1 && b <= DEVICE_ABNORMAL_WAKEUP_GPIO) {
+                ev->kind = SIM_GPIO;
+                ev->gpio = b;
+            } else if (strcmp(word, "ble") == 0 && sscanf(text, " %*s %*s %lld %lld", &b, &c) == 2) {
+                ev->kind = SIM_BLE;
+                ev->gpio = BLE_WAKEUP_GPIO;
+                ev->first_us = SIM_US(b);
+                ev->second_us = SIM_US(c);
+            } else if (strcmp(word, "uart") == 0 && sscanf(text, " %*s %*s %lld", &b) == 1) {
+                ev->kind = SIM_UART;
+                ev->first_us = SIM_US(b);
+            } else if (strcmp(word, "temp") == 0 && sscanf(text, " %*s %*s %lld", &b) == 1
+                       && b >= TEMPERATURE_WAKEUP_GPIO1 && b <= TEMPERATURE_WAKEUP_GPIO3) {
+                ev->kind = SIM_TEMP;
+                ev->gpio = b;
+            } else {
+                ret = parse_error(path, line, "bad event");
+                break;
+            }
+            sim.event_num++;
+        } else {
+            ret = parse_error(path, line, "unknown line");
+        }
+    }
+    fclose(f);
+    if (ret == 0 && sim.end_us <= 0) {
+        ret = parse_error(path, line, "missing end");
+    }
+    return ret;
+}
+
+/* 執行到 end，verbose 為 false 時丟棄喚醒流程每次啟動的輸出 */
+static void run(bool verbose)
+{
+    int saved = -1;
+
+    fflush(stdout);
+    if (!verbose) {
+        saved = dup(STDOUT_FILENO);
+        if (freopen("/dev/null", "w", stdout) == NULL) {
+            saved = -1;
+        }
+    }
+    memset(&stats, 0, sizeof(stats));
+    if (setjmp(end_jmp) == 0) {
+        setjmp(boot_jmp);
+        // 重新啟動到 app_main 的時間在 esp_timer 歸零之前，power model 沒有計入
+        sim.boot_at_us = sim.clock_us;
+        sim_advance(sim.boot_us);
+        wake_fsm_run(&sim_platform);
+        // 模擬的平台在每個分支都重新啟動或睡到結束，不會到這裡
+        TEST_CHECK(false);
+    }
+    // 最後一段 light sleep 計入
+    power_model_enter(&stats, stats.state, sim_now_us());
+
+    fflush(stdout);
+    if (saved >= 0) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+        clearerr(stdout);
+    }
+}
+
+static void report(const char *path)
+{
+    int64_t modelled_us = 0;
+    int pending = 0;
+
+    for (int i = 0; i < WAKE_STATE_NUM; i++) {
+        modelled_us += stats.time_us[i];
+    }
+    for (int i = 0; i < sim.event_num; i++) {
+        pending += !sim.events[i].done;
+    }
+    printf("%s: %lld s simulated, %lu restarts, %lu events written, %lu samples\n", path,
+           (long long)(sim.clock_us / 1000000), (unsigned long)sim.restarts,
+           (unsigned long)sim.events_written, (unsigned long)sim.samples);
+    power_model_report(&stats);
+    printf("  reset to app_main, not in the model: %lld ms\n", (long long)((sim.clock_us - modelled_us) / 1000));
+
+    // 模型的時間加上每次啟動前的時間等於模擬的時間，所有事件都已處理
+    TEST_CHECK_INT(sim.end_us, sim.clock_us);
+    TEST_CHECK_INT(sim.clock_us, modelled_us + (int64_t)stats.boot_count * sim.boot_us);
+    TEST_CHECK_INT(sim.restarts + 1, stats.boot_count);
+    TEST_CHECK_INT(0, pending);
+}
+
+int main(int argc, char **argv)
+{
+    bool verbose = false;
+    int scripts = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+            continue;
+        }
+        if (load_script(argv[i]) != 0) {
+            return 1;
+        }
+        run(verbose);
+        report(argv[i]);
+        scripts++;
+    }
+    if (scripts == 0) {
+        fprintf(stderr, "usage: %s [-v] <script>...\n", argv[0]);
+        return 1;
+    }
+    return TEST_EXIT();
+}
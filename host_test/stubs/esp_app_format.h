@@ -0,0 +1,63 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* ESP-IDF v5.1 的 app 映像格式 (components/bootloader_support/include/esp_app_format.h) */
+
+#pragma once
+
+#include <stdint.h>
+
+#define ESP_IMAGE_HEADER_MAGIC      0xE9
+#define ESP_IMAGE_MAX_SEGMENTS      16
+#define ESP_APP_DESC_MAGIC_WORD     0xABCD5432
+
+typedef enum {
+    ESP_CHIP_ID_ESP32   = 0x0000,
+    ESP_CHIP_ID_ESP32C3 = 0x0005,
+    ESP_CHIP_ID_ESP32H2 = 0x0010,
+    ESP_CHIP_ID_INVALID = 0xFFFF,
+} __attribute__((packed)) esp_chip_id_t;
+
+typedef struct {
+    uint8_t       magic;
+    uint8_t       segment_count;
+    uint8_t       spi_mode;
+    uint8_t       spi_speed: 4;
+    uint8_t       spi_size: 4;
+    uint32_t      entry_addr;
+    uint8_t       wp_pin;
+    uint8_t       spi_pin_drv[3];
+    esp_chip_id_t chip_id;
+    uint8_t       min_chip_rev;
+    uint16_t      min_chip_rev_full;
+    uint16_t      max_chip_rev_full;
+    uint8_t       reserved[4];
+    uint8_t       hash_appended;
+} __attribute__((packed)) esp_image_header_t;
+
+_Static_assert(sizeof(esp_image_header_t) == 24, "esp_image_header_t should be 24 bytes");
+
+typedef struct {
+    uint32_t load_addr;
+    uint32_t data_len;
+} esp_image_segment_header_t;
+
+typedef struct {
+    uint32_t magic_word;
+    uint32_t secure_version;
+    uint32_t reserv1[2];
+    char     version[32];
+    char     project_name[32];
+    char     time[16];
+    char     date[16];
+    char     idf_ver[32];
+    uint8_t  app_elf_sha256[32];
+    uint32_t reserv2[20];
+} esp_app_desc_t;
+
+_Static_assert(sizeof(esp_app_desc_t) == 256, "esp_app_desc_t should be 256 bytes");
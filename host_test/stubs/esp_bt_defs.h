@@ -0,0 +1,16 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#define ESP_BD_ADDR_LEN     6
+
+typedef uint8_t esp_bd_addr_t[ESP_BD_ADDR_LEN];
@@ -0,0 +1,57 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 只包含主機端測試用到的 Bluedroid GATT 定義，數值與 ESP-IDF 相同 */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_bt_defs.h"
+
+#define ESP_GATT_DEF_BLE_MTU_SIZE   23
+#define ESP_GATT_MAX_MTU_SIZE       517
+#define ESP_GATT_MAX_ATTR_LEN       600
+
+#define ESP_GATT_PREP_WRITE_CANCEL  0x00
+#define ESP_GATT_PREP_WRITE_EXEC    0x01
+
+#define ESP_GATT_AUTH_REQ_NONE      0
+
+typedef uint8_t esp_gatt_if_t;
+
+#define ESP_GATT_IF_NONE            0xff
+
+typedef enum {
+    ESP_GATT_OK                 = 0x00,
+    ESP_GATT_INVALID_HANDLE     = 0x01,
+    ESP_GATT_READ_NOT_PERMIT    = 0x02,
+    ESP_GATT_WRITE_NOT_PERMIT   = 0x03,
+    ESP_GATT_INVALID_PDU        = 0x04,
+    ESP_GATT_INSUF_AUTHENTICATION = 0x05,
+    ESP_GATT_REQ_NOT_SUPPORTED  = 0x06,
+    ESP_GATT_INVALID_OFFSET     = 0x07,
+    ESP_GATT_INSUF_AUTHORIZATION = 0x08,
+    ESP_GATT_PREPARE_Q_FULL     = 0x09,
+    ESP_GATT_NOT_FOUND          = 0x0a,
+    ESP_GATT_NOT_LONG           = 0x0b,
+    ESP_GATT_INSUF_KEY_SIZE     = 0x0c,
+    ESP_GATT_INVALID_ATTR_LEN   = 0x0d,
+} esp_gatt_status_t;
+
+typedef struct {
+    uint8_t  value[ESP_GATT_MAX_ATTR_LEN];
+    uint16_t handle;
+    uint16_t offset;
+    uint16_t len;
+    uint8_t  auth_req;
+} esp_gatt_value_t;
+
+typedef union {
+    esp_gatt_value_t attr_value;
+    uint16_t         handle;
+} esp_gatt_rsp_t;
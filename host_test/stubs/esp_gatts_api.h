@@ -0,0 +1,38 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* GATT server 事件參數 (只保留寫入相關欄位)，esp_ble_gatts_send_response() 由各測試提供 */
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_gatt_defs.h"
+
+typedef union {
+    struct gatts_write_evt_param {
+        uint16_t      conn_id;
+        uint32_t      trans_id;
+        esp_bd_addr_t bda;
+        uint16_t      handle;
+        uint16_t      offset;
+        bool          need_rsp;
+        bool          is_prep;
+        uint16_t      len;
+        uint8_t      *value;
+    } write;
+    struct gatts_exec_write_evt_param {
+        uint16_t      conn_id;
+        uint32_t      trans_id;
+        esp_bd_addr_t bda;
+        uint8_t       exec_write_flag;
+    } exec_write;
+} esp_ble_gatts_cb_param_t;
+
+esp_err_t esp_ble_gatts_send_response(esp_gatt_if_t gatts_if, uint16_t conn_id, uint32_t trans_id,
+                                      esp_gatt_status_t status, esp_gatt_rsp_t *rsp);
@@ -0,0 +1,40 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  log 只在定義 HOST_TEST_VERBOSE 時印出。不做格式檢查: 目標平台的 int64_t/uint32_t
+  與主機不同 (long long/unsigned long)，原始碼的格式字串以目標平台為準
+*/
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+static inline void host_log(const char *level, const char *tag, const char *format, ...)
+{
+#ifdef HOST_TEST_VERBOSE
+    va_list args;
+    va_start(args, format);
+    printf("%s (%s) ", level, tag);
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+#endif
+}
+
+#define ESP_LOGE(tag, format, ...)  host_log("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  host_log("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  host_log("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)  host_log("D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)  host_log("V", tag, format, ##__VA_ARGS__)
+
+static inline void esp_log_buffer_hex(const char *tag, const void *buffer, uint16_t len)
+{
+}
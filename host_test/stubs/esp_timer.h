@@ -0,0 +1,15 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* esp_timer_get_time() 由各測試提供 (通常為虛擬時鐘) */
+
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,15 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 主機端測試使用的設定，數值與專案的 sdkconfig 相同 */
+
+#pragma once
+
+#define CONFIG_BT_ACL_CONNECTIONS       4
+#define CONFIG_BT_LE_MAX_CONNECTIONS    3
+#define CONFIG_IDF_FIRMWARE_CHIP_ID     0x0010
@@ -0,0 +1,136 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  廣播封包的事件摘要: 編碼後解碼還原，company id 或版本不符、長度不足的封包，
+  以及事件次數超過 255 後從 0 繼續時 gateway 仍可算出新事件數
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "adv_beacon.h"
+#include "test_util.h"
+
+static void round_trip(void)
+{
+    const adv_beacon_t beacon = {
+        .flags = ADV_BEACON_FLAG_LOW_BATTERY | ADV_BEACON_FLAG_ABNORMAL,
+        .latest_gpio = 13,
+        .counters = { 1, 2, 3, 254, 255 },
+        .log_len = 0x12345678,
+    };
+    uint8_t data[ADV_BEACON_LEN];
+    adv_beacon_t decoded;
+
+    TEST_CHECK_INT(ADV_BEACON_LEN, adv_beacon_encode(&beacon, data, sizeof(data)));
+    // company id 為 little endian
+    TEST_CHECK_INT(ADV_BEACON_COMPANY_ID & 0xff, data[0]);
+    TEST_CHECK_INT(ADV_BEACON_COMPANY_ID >> 8, data[1]);
+    TEST_CHECK_INT(0x78, data[10]);
+    TEST_CHECK_INT(0x12, data[13]);
+
+    memset(&decoded, 0xaa, sizeof(decoded));
+    TEST_CHECK(adv_beacon_decode(data, sizeof(data), &decoded));
+    TEST_CHECK_INT(beacon.flags, decoded.flags);
+    TEST_CHECK_INT(beacon.latest_gpio, decoded.latest_gpio);
+    TEST_CHECK(memcmp(beacon.counters, decoded.counters, ADV_BEACON_EVENT_TYPES) == 0);
+    TEST_CHECK_INT(beacon.log_len, decoded.log_len);
+
+    // 沒有事件時全部為 0
+    const adv_beacon_t empty = { 0 };
+    TEST_CHECK_INT(ADV_BEACON_LEN, adv_beacon_encode(&empty, data, sizeof(data)));
+    TEST_CHECK(adv_beacon_decode(data, sizeof(data), &decoded));
+    TEST_CHECK_INT(0, decoded.latest_gpio);
+    TEST_CHECK_INT(0, decoded.log_len);
+
+    // 較長的 manufacturer data 只解讀前 ADV_BEACON_LEN bytes
+    uint8_t longer[ADV_BEACON_LEN + 4];
+    memset(longer, 0xff, sizeof(longer));
+    TEST_CHECK_INT(ADV_BEACON_LEN, adv_beacon_encode(&beacon, longer, sizeof(longer)));
+    TEST_CHECK_INT(0xff, longer[ADV_BEACON_LEN]);
+    TEST_CHECK(adv_beacon_decode(longer, sizeof(longer), &decoded));
+    TEST_CHECK_INT(beacon.log_len, decoded.log_len);
+}
+
+static void rejected(void)
+{
+    const adv_beacon_t beacon = { .latest_gpio = 10, .log_len = 100 };
+    uint8_t data[ADV_BEACON_LEN];
+    uint8_t bad[ADV_BEACON_LEN];
+    adv_beacon_t decoded;
+
+    adv_beacon_encode(&beacon, data, sizeof(data));
+
+    // 其他廠商的 company id (兩個 byte 各自不符，以及 byte 順序相反)
+    memcpy(bad, data, sizeof(bad));
+    bad[0] ^= 0x01;
+    TEST_CHECK(!adv_beacon_decode(bad, sizeof(bad), &decoded));
+    memcpy(bad, data, sizeof(bad));
+    bad[1] ^= 0x01;
+    TEST_CHECK(!adv_beacon_decode(bad, sizeof(bad), &decoded));
+    memcpy(bad, data, sizeof(bad));
+    bad[0] = data[1];
+    bad[1] = data[0];
+    TEST_CHECK(!adv_beacon_decode(bad, sizeof(bad), &decoded));
+
+    // 不同的版本
+    memcpy(bad, data, sizeof(bad));
+    bad[2] = ADV_BEACON_VERSION + 1;
+    TEST_CHECK(!adv_beacon_decode(bad, sizeof(bad), &decoded));
+    bad[2] = ADV_BEACON_VERSION - 1;
+    TEST_CHECK(!adv_beacon_decode(bad, sizeof(bad), &decoded));
+
+    // 長度不足: 解碼失敗，編碼不寫入
+    for (size_t len = 0; len < ADV_BEACON_LEN; len++) {
+        TEST_CHECK(!adv_beacon_decode(data, len, &decoded));
+    }
+    memset(bad, 0xee, sizeof(bad));
+    TEST_CHECK_INT(0, adv_beacon_encode(&beacon, bad, ADV_BEACON_LEN - 1));
+    TEST_CHECK_INT(0xee, bad[0]);
+}
+
+static void counter_wrap(void)
+{
+    uint32_t totals[ADV_BEACON_EVENT_TYPES] = { 0, 255, 256, 257, 0x10000 + 7 };
+    uint8_t data[ADV_BEACON_LEN];
+    adv_beacon_t beacon = { 0 };
+    adv_beacon_t decoded;
+
+    adv_beacon_set_counters(&beacon, totals);
+    TEST_CHECK_INT(0, beacon.counters[0]);
+    TEST_CHECK_INT(255, beacon.counters[1]);
+    TEST_CHECK_INT(0, beacon.counters[2]);
+    TEST_CHECK_INT(1, beacon.counters[3]);
+    TEST_CHECK_INT(7, beacon.counters[4]);
+
+    // gateway 記下上次掃描的值，以 (uint8_t)(新值 - 舊值) 計算新事件，跨過 255 時仍正確
+    adv_beacon_encode(&beacon, data, sizeof(data));
+    TEST_CHECK(adv_beacon_decode(data, sizeof(data), &decoded));
+    uint8_t previous[ADV_BEACON_EVENT_TYPES];
+    memcpy(previous, decoded.counters, sizeof(previous));
+
+    const uint32_t added[ADV_BEACON_EVENT_TYPES] = { 3, 1, 255, 0, 200 };
+    for (int i = 0; i < ADV_BEACON_EVENT_TYPES; i++) {
+        totals[i] += added[i];
+    }
+    adv_beacon_set_counters(&beacon, totals);
+    adv_beacon_encode(&beacon, data, sizeof(data));
+    TEST_CHECK(adv_beacon_decode(data, sizeof(data), &decoded));
+    TEST_CHECK_INT(0, decoded.counters[1]);     // 255 + 1
+    for (int i = 0; i < ADV_BEACON_EVENT_TYPES; i++) {
+        TEST_CHECK_INT(added[i], (uint8_t)(decoded.counters[i] - previous[i]));
+    }
+}
+
+int main(void)
+{
+    round_trip();
+    rejected();
+    counter_wrap();
+    return TEST_EXIT();
+}
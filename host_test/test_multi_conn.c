@@ -0,0 +1,231 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  多連線: 連線數上限為 BLE_CONN_MAX，多個連線交錯進行長寫入時各自的資料互不影響，
+  斷線時釋放該連線的長寫入緩衝區
+*/
+
+#include <string.h>
+#include "ble_conn.h"
+#include "prepare_write.h"
+#include "test_util.h"
+
+#define GATTS_IF        3
+#define HANDLE_LONG     42      // 以 prepare_write_register() 註冊
+#define HANDLE_DEFAULT  43      // 未註冊，使用 PREPARE_BUF_MAX_SIZE
+#define HANDLE_POOL     44      // 需要整個緩衝池
+#define LONG_CAPACITY   600
+#define CHUNK           18      // MTU 23 時一次 prepare write 的資料量
+
+static int64_t now_us;
+
+/* 最近一次回應每個連線的狀態 */
+static esp_gatt_status_t last_status[BLE_CONN_MAX + 1];
+
+/* 長寫入執行後交給處理函數的資料 */
+static struct {
+    uint16_t handle;
+    uint16_t len;
+    uint8_t  data[LONG_CAPACITY];
+    int      calls;
+} received[BLE_CONN_MAX + 1];
+
+int64_t esp_timer_get_time(void)
+{
+    return now_us;
+}
+
+esp_err_t esp_ble_gatts_send_response(esp_gatt_if_t gatts_if, uint16_t conn_id, uint32_t trans_id,
+                                      esp_gatt_status_t status, esp_gatt_rsp_t *rsp)
+{
+    last_status[conn_id] = status;
+    return ESP_OK;
+}
+
+/* 處理函數的回傳值，做為 Execute Write 的回應 */
+static esp_gatt_status_t long_write_status = ESP_GATT_OK;
+
+static esp_gatt_status_t on_long_write(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t handle,
+                                       const uint8_t *data, uint16_t len)
+{
+    received[conn_id].handle = handle;
+    received[conn_id].len = len;
+    memcpy(received[conn_id].data, data, len);
+    received[conn_id].calls++;
+    return long_write_status;
+}
+
+/* 每個連線寫入不同的內容: 第 i 個位元組為 conn_id * 64 + i */
+static uint8_t pattern(uint16_t conn_id, int i)
+{
+    return (uint8_t)(conn_id * 64 + i);
+}
+
+static esp_gatt_status_t prep_write(uint16_t conn_id, uint16_t handle, uint16_t offset, uint16_t len)
+{
+    uint8_t value[CHUNK];
+    esp_ble_gatts_cb_param_t param = {0};
+
+    for (int i = 0; i < len; i++) {
+        value[i] = pattern(conn_id, offset + i);
+    }
+    param.write.conn_id = conn_id;
+    param.write.handle = handle;
+    param.write.offset = offset;
+    param.write.len = len;
+    param.write.value = value;
+    param.write.need_rsp = true;
+    param.write.is_prep = true;
+    last_status[conn_id] = ESP_GATT_NOT_FOUND;
+    prepare_write_event(GATTS_IF, &param);
+    return last_status[conn_id];
+}
+
+static esp_gatt_status_t exec_write(uint16_t conn_id, uint8_t flag)
+{
+    esp_ble_gatts_cb_param_t param = {0};
+
+    param.exec_write.conn_id = conn_id;
+    param.exec_write.exec_write_flag = flag;
+    last_status[conn_id] = ESP_GATT_NOT_FOUND;
+    prepare_write_exec(GATTS_IF, &param);
+    return last_status[conn_id];
+}
+
+static void disconnect(uint16_t conn_id)
+{
+    prepare_write_conn_close(conn_id);
+    ble_conn_close(conn_id);
+}
+
+static void check_received(uint16_t conn_id, uint16_t handle, uint16_t len)
+{
+    TEST_CHECK_INT(1, received[conn_id].calls);
+    TEST_CHECK_INT(handle, received[conn_id].handle);
+    TEST_CHECK_INT(len, received[conn_id].len);
+    for (int i = 0; i < len && i < LONG_CAPACITY; i++) {
+        if (received[conn_id].data[i] != pattern(conn_id, i)) {
+            TEST_CHECK_INT(pattern(conn_id, i), received[conn_id].data[i]);
+            break;
+        }
+    }
+}
+
+/* 連線數上限取 host 與 controller 較小者，滿了之後不再建立連線 */
+static void connection_limit(void)
+{
+    esp_bd_addr_t bda = {0x11, 0x22, 0x33, 0x44, 0x55, 0};
+
+    TEST_CHECK_INT(CONFIG_BT_LE_MAX_CONNECTIONS, BLE_CONN_MAX);
+    for (int i = 0; i < BLE_CONN_MAX; i++) {
+        bda[5] = i;
+        ble_conn_t *conn = ble_conn_open(i, bda);
+        TEST_CHECK(conn != NULL);
+        TEST_CHECK(ble_conn_find_bda(bda) == conn);
+    }
+    TEST_CHECK_INT(BLE_CONN_MAX, ble_conn_count());
+    bda[5] = BLE_CONN_MAX;
+    TEST_CHECK(ble_conn_open(BLE_CONN_MAX, bda) == NULL);
+    TEST_CHECK(ble_conn_find(BLE_CONN_MAX) == NULL);
+}
+
+/*
+  三個連線交錯寫入: 0 與 2 寫入已註冊的長屬性 (順序相反)，1 寫入未註冊的屬性，
+  每輪每個連線送出一個 CHUNK
+*/
+static void interleaved(void)
+{
+    const uint16_t len_long = LONG_CAPACITY;
+    const uint16_t len_default = 250;
+
+    for (uint16_t offset = 0; offset < len_long; offset += CHUNK) {
+        uint16_t n = len_long - offset < CHUNK ? len_long - offset : CHUNK;
+        TEST_CHECK_INT(ESP_GATT_OK, prep_write(0, HANDLE_LONG, offset, n));
+        if (offset < len_default) {
+            uint16_t m = len_default - offset < CHUNK ? len_default - offset : CHUNK;
+            TEST_CHECK_INT(ESP_GATT_OK, prep_write(1, HANDLE_DEFAULT, offset, m));
+        }
+        uint16_t back = len_long - offset - n;
+        TEST_CHECK_INT(ESP_GATT_OK, prep_write(2, HANDLE_LONG, back, n));
+    }
+    // 一次長寫入只處理一個屬性
+    TEST_CHECK_INT(ESP_GATT_REQ_NOT_SUPPORTED, prep_write(0, HANDLE_DEFAULT, 0, CHUNK));
+    // 超過註冊的長度
+    TEST_CHECK_INT(ESP_GATT_INVALID_ATTR_LEN, prep_write(2, HANDLE_LONG, LONG_CAPACITY - 1, 2));
+
+    TEST_CHECK_INT(ESP_GATT_OK, exec_write(2, ESP_GATT_PREP_WRITE_EXEC));
+    TEST_CHECK_INT(ESP_GATT_OK, exec_write(0, ESP_GATT_PREP_WRITE_EXEC));
+    check_received(0, HANDLE_LONG, len_long);
+    check_received(2, HANDLE_LONG, len_long);
+    // 未註冊的屬性只印出內容
+    TEST_CHECK_INT(0, received[1].calls);
+    exec_write(1, ESP_GATT_PREP_WRITE_EXEC);
+    TEST_CHECK_INT(0, received[1].calls);
+}
+
+/* Execute Write 在處理函數返回後才回應，處理函數的錯誤 (例如 OTA 的狀態碼) 回報給 client */
+static void exec_write_status(void)
+{
+    const esp_gatt_status_t ota_status = (esp_gatt_status_t)0x8A;
+    int calls = received[0].calls;
+
+    TEST_CHECK_INT(ESP_GATT_OK, prep_write(0, HANDLE_LONG, 0, CHUNK));
+    long_write_status = ota_status;
+    TEST_CHECK_INT(ota_status, exec_write(0, ESP_GATT_PREP_WRITE_EXEC));
+    TEST_CHECK_INT(calls + 1, received[0].calls);
+    long_write_status = ESP_GATT_OK;
+
+    // 取消時不呼叫處理函數，回應成功；沒有長寫入時也回應
+    TEST_CHECK_INT(ESP_GATT_OK, prep_write(0, HANDLE_LONG, 0, CHUNK));
+    TEST_CHECK_INT(ESP_GATT_OK, exec_write(0, ESP_GATT_PREP_WRITE_CANCEL));
+    TEST_CHECK_INT(ESP_GATT_OK, exec_write(0, ESP_GATT_PREP_WRITE_EXEC));
+    TEST_CHECK_INT(calls + 1, received[0].calls);
+    received[0].calls = calls;
+}
+
+/* 斷線時釋放未執行的長寫入，緩衝池可再由其他連線使用 */
+static void disconnect_frees_buffer(void)
+{
+    esp_bd_addr_t bda = {0x11, 0x22, 0x33, 0x44, 0x55, 3};
+
+    TEST_CHECK_INT(ESP_GATT_OK, prep_write(0, HANDLE_LONG, 0, CHUNK));
+    TEST_CHECK_INT(ESP_GATT_OK, prep_write(1, HANDLE_DEFAULT, 0, CHUNK));
+    // 其他連線占用緩衝區時，需要整個緩衝池的寫入失敗
+    TEST_CHECK_INT(ESP_GATT_PREPARE_Q_FULL, prep_write(2, HANDLE_POOL, 0, CHUNK));
+
+    disconnect(0);
+    disconnect(1);
+    TEST_CHECK_INT(1, ble_conn_count());
+    // 斷線的連線不會執行長寫入
+    exec_write(0, ESP_GATT_PREP_WRITE_EXEC);
+    TEST_CHECK_INT(1, received[0].calls);
+
+    TEST_CHECK(ble_conn_open(3, bda) != NULL);
+    TEST_CHECK_INT(ESP_GATT_OK, prep_write(2, HANDLE_POOL, 0, CHUNK));
+    // 取消後釋放
+    exec_write(2, ESP_GATT_PREP_WRITE_CANCEL);
+    TEST_CHECK_INT(1, received[2].calls);
+    TEST_CHECK_INT(ESP_GATT_OK, prep_write(3, HANDLE_POOL, PREPARE_WRITE_BLOCK_SIZE * PREPARE_WRITE_BLOCK_NUM - CHUNK, CHUNK));
+    disconnect(3);
+    disconnect(2);
+    TEST_CHECK_INT(0, ble_conn_count());
+}
+
+int main(void)
+{
+    TEST_CHECK_INT(ESP_OK, prepare_write_register(HANDLE_LONG, LONG_CAPACITY, on_long_write));
+    TEST_CHECK_INT(ESP_OK, prepare_write_register(HANDLE_POOL, PREPARE_WRITE_BLOCK_SIZE * PREPARE_WRITE_BLOCK_NUM, on_long_write));
+    TEST_CHECK_INT(ESP_ERR_INVALID_SIZE, prepare_write_register(45, PREPARE_WRITE_BLOCK_SIZE * PREPARE_WRITE_BLOCK_NUM + 1, NULL));
+
+    connection_limit();
+    interleaved();
+    exec_write_status();
+    disconnect_frees_buffer();
+    return TEST_EXIT();
+}
@@ -0,0 +1,215 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  OTA 映像開頭檢查: 一組正確與錯誤的映像以不同的寫入大小送入 ota_image_check_feed()，
+  錯誤必須在收到判斷所需的 bytes 的那一次寫入就被拒絕，並回報對應的狀態碼
+*/
+
+#include <string.h>
+#include "sdkconfig.h"
+#include "ota_image_check.h"
+#include "test_util.h"
+
+#define IMAGE_LEN           4096
+#define SEGMENT_OFFSET      sizeof(esp_image_header_t)
+#define DESC_OFFSET         (SEGMENT_OFFSET + sizeof(esp_image_segment_header_t))
+#define RUNNING_VERSION     "1.2.0"
+#define EFUSE_SECURE_VER    2
+
+typedef struct {
+    const char   *name;
+    void        (*mutate)(uint8_t *image);
+    const ota_image_policy_t *policy;
+    ota_status_t  status;       // 預期的結果
+    size_t        reject_at;    // 收到這麼多 bytes 時即可判斷，0 表示通過
+} image_case_t;
+
+static uint8_t image[IMAGE_LEN];
+
+static bool secure_version_ok(uint32_t version)
+{
+    return version >= EFUSE_SECURE_VER;
+}
+
+static const ota_image_policy_t same_version_policy = {
+    .running_version = RUNNING_VERSION,
+};
+
+static const ota_image_policy_t anti_rollback_policy = {
+    .secure_version_ok = secure_version_ok,
+};
+
+/* 正確的映像: chip id 與本機相同，版本與執行中的不同 */
+static void make_image(uint8_t *buf)
+{
+    esp_image_header_t header = {
+        .magic = ESP_IMAGE_HEADER_MAGIC,
+        .segment_count = 4,
+        .chip_id = CONFIG_IDF_FIRMWARE_CHIP_ID,
+    };
+    esp_image_segment_header_t segment = {
+        .load_addr = 0x42000020,
+        .data_len = 0x8000,
+    };
+    esp_app_desc_t desc = {
+        .magic_word = ESP_APP_DESC_MAGIC_WORD,
+        .secure_version = EFUSE_SECURE_VER,
+        .version = "1.3.0",
+        .project_name = "ble_ota",
+    };
+
+    for (int i = 0; i < IMAGE_LEN; i++) {
+        buf[i] = (uint8_t)(i * 7);
+    }
+    memcpy(buf, &header, sizeof(header));
+    memcpy(buf + SEGMENT_OFFSET, &segment, sizeof(segment));
+    memcpy(buf + DESC_OFFSET, &desc, sizeof(desc));
+}
+
+static esp_image_header_t *header_of(uint8_t *buf)
+{
+    return (esp_image_header_t *)buf;
+}
+
+static esp_app_desc_t *desc_of(uint8_t *buf)
+{
+    return (esp_app_desc_t *)(buf + DESC_OFFSET);
+}
+
+static void text_file(uint8_t *buf)
+{
+    memcpy(buf, "{\"event\":", 9);
+}
+
+static void erased_flash(uint8_t *buf)
+{
+    memset(buf, 0xff, IMAGE_LEN);
+}
+
+static void other_chip(uint8_t *buf)
+{
+    header_of(buf)->chip_id = ESP_CHIP_ID_ESP32C3;
+}
+
+static void no_segments(uint8_t *buf)
+{
+    header_of(buf)->segment_count = 0;
+}
+
+static void too_many_segments(uint8_t *buf)
+{
+    header_of(buf)->segment_count = ESP_IMAGE_MAX_SEGMENTS + 1;
+}
+
+static void short_segment(uint8_t *buf)
+{
+    esp_image_segment_header_t segment = { .load_addr = 0x42000020, .data_len = sizeof(esp_app_desc_t) - 1 };
+    memcpy(buf + SEGMENT_OFFSET, &segment, sizeof(segment));
+}
+
+static void bootloader_image(uint8_t *buf)
+{
+    // bootloader 的第一個 segment 不是 app 描述
+    desc_of(buf)->magic_word = 0x40380000;
+}
+
+static void running_version(uint8_t *buf)
+{
+    strcpy(desc_of(buf)->version, RUNNING_VERSION);
+}
+
+static void old_secure_version(uint8_t *buf)
+{
+    desc_of(buf)->secure_version = EFUSE_SECURE_VER - 1;
+}
+
+static const image_case_t corpus[] = {
+    { "good",                       NULL,               NULL,                   OTA_STATUS_OK,              0 },
+    { "good, other version",        NULL,               &same_version_policy,   OTA_STATUS_OK,              0 },
+    { "good, secure version",       NULL,               &anti_rollback_policy,  OTA_STATUS_OK,              0 },
+    { "text file",                  text_file,          NULL,                   OTA_STATUS_BAD_MAGIC,       1 },
+    { "erased flash",               erased_flash,       NULL,                   OTA_STATUS_BAD_MAGIC,       1 },
+    { "other chip",                 other_chip,         NULL,                   OTA_STATUS_BAD_CHIP,        SEGMENT_OFFSET },
+    { "no segments",                no_segments,        NULL,                   OTA_STATUS_BAD_SEGMENT,     SEGMENT_OFFSET },
+    { "too many segments",          too_many_segments,  NULL,                   OTA_STATUS_BAD_SEGMENT,     SEGMENT_OFFSET },
+    { "short first segment",        short_segment,      NULL,                   OTA_STATUS_BAD_SEGMENT,     DESC_OFFSET },
+    { "bootloader image",           bootloader_image,   NULL,                   OTA_STATUS_BAD_APP_DESC,    OTA_IMAGE_CHECK_LEN },
+    { "running version",            running_version,    &same_version_policy,   OTA_STATUS_SAME_VERSION,    OTA_IMAGE_CHECK_LEN },
+    { "running version, no policy", running_version,    NULL,                   OTA_STATUS_OK,              0 },
+    { "old secure version",         old_secure_version, &anti_rollback_policy,  OTA_STATUS_SECURE_VERSION,  OTA_IMAGE_CHECK_LEN },
+    { "old secure version, no check", old_secure_version, &same_version_policy, OTA_STATUS_OK,              0 },
+};
+
+/* 以 chunk bytes 為單位寫入整個映像，回傳第一個錯誤，*fed 為當時已寫入的長度 */
+static ota_status_t feed_image(const image_case_t *c, size_t chunk, size_t *fed)
+{
+    ota_image_check_begin(c->policy);
+    for (*fed = 0; *fed < IMAGE_LEN;) {
+        size_t len = IMAGE_LEN - *fed < chunk ? IMAGE_LEN - *fed : chunk;
+        ota_status_t status = ota_image_check_feed(image + *fed, len);
+        *fed += len;
+        if (status != OTA_STATUS_OK) {
+            return status;
+        }
+    }
+    return OTA_STATUS_OK;
+}
+
+static void run_corpus(size_t chunk)
+{
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        const image_case_t *c = &corpus[i];
+        size_t fed;
+
+        make_image(image);
+        if (c->mutate) {
+            c->mutate(image);
+        }
+        ota_status_t status = feed_image(c, chunk, &fed);
+        if (status != c->status) {
+            fprintf(stderr, "%s (chunk %zu): ", c->name, chunk);
+        }
+        TEST_CHECK_INT(c->status, status);
+        if (c->reject_at) {
+            // 在包含判斷點的那一次寫入就拒絕
+            size_t expected = (c->reject_at + chunk - 1) / chunk * chunk;
+            if (fed != expected) {
+                fprintf(stderr, "%s (chunk %zu): ", c->name, chunk);
+            }
+            TEST_CHECK_INT(expected, fed);
+        }
+    }
+}
+
+/* 直接檢查部分開頭: 資料不足以判斷時通過 */
+static void partial_head(void)
+{
+    make_image(image);
+    other_chip(image);
+    TEST_CHECK_INT(OTA_STATUS_OK, ota_image_check(image, 0, NULL));
+    TEST_CHECK_INT(OTA_STATUS_OK, ota_image_check(image, SEGMENT_OFFSET - 1, NULL));
+    TEST_CHECK_INT(OTA_STATUS_BAD_CHIP, ota_image_check(image, SEGMENT_OFFSET, NULL));
+
+    make_image(image);
+    running_version(image);
+    TEST_CHECK_INT(OTA_STATUS_OK, ota_image_check(image, OTA_IMAGE_CHECK_LEN - 1, &same_version_policy));
+    TEST_CHECK_INT(OTA_STATUS_SAME_VERSION, ota_image_check(image, OTA_IMAGE_CHECK_LEN, &same_version_policy));
+}
+
+int main(void)
+{
+    static const size_t chunks[] = { 1, 7, 20, 244, 497, IMAGE_LEN };
+
+    TEST_CHECK_INT(24 + 8 + 256, OTA_IMAGE_CHECK_LEN);
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        run_corpus(chunks[i]);
+    }
+    partial_head();
+    return TEST_EXIT();
+}
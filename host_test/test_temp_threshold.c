@@ -0,0 +1,186 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  溫度臨界值: 跨越時只觸發一次，遲滯範圍內的抖動不重複觸發，回升超過遲滯才解除；
+  到邊界的距離與取樣週期的調整與限制
+*/
+
+#include <stdint.h>
+#include "temp_sampler.h"
+#include "temp_threshold.h"
+#include "wake_fsm.h"
+#include "test_util.h"
+
+#define TH_NUM              (sizeof(thresholds) / sizeof(thresholds[0]))
+#define HYST                TEMP_SAMPLER_HYSTERESIS_CC
+#define MIN_MS              TEMP_SAMPLER_MIN_PERIOD_MS
+#define MAX_MS              TEMP_SAMPLER_MAX_PERIOD_MS
+
+/* 與 temp_sampler.c 相同的臨界值 */
+static const temp_threshold_t thresholds[] = {
+    { .trigger_cc = 100,  .hysteresis_cc = HYST, .event = TEMPERATURE_WAKEUP_GPIO1 },
+    { .trigger_cc = -100, .hysteresis_cc = HYST, .event = TEMPERATURE_WAKEUP_GPIO2 },
+    { .trigger_cc = -500, .hysteresis_cc = HYST, .event = TEMPERATURE_WAKEUP_GPIO3 },
+};
+
+/* 依序送入樣本，回傳觸發的次數，fired 記錄每個臨界值觸發的次數 */
+static int feed(const int16_t *cc, int n, uint32_t *active, int fired[TH_NUM])
+{
+    int events = 0;
+    for (int i = 0; i < n; i++) {
+        int th = temp_threshold_update(thresholds, TH_NUM, cc[i], active);
+        if (th >= 0) {
+            fired[th]++;
+            events++;
+        }
+    }
+    return events;
+}
+
+/* 向下跨越: 等於臨界值即觸發，已觸發時不再觸發 */
+static void crossing(void)
+{
+    uint32_t active = 0;
+
+    TEST_CHECK_INT(-1, temp_threshold_update(thresholds, TH_NUM, 500, &active));
+    TEST_CHECK_INT(-1, temp_threshold_update(thresholds, TH_NUM, 101, &active));
+    TEST_CHECK_INT(0, active);
+    TEST_CHECK_INT(0, temp_threshold_update(thresholds, TH_NUM, 100, &active));
+    TEST_CHECK_INT(0x1, active);
+    TEST_CHECK_INT(-1, temp_threshold_update(thresholds, TH_NUM, 0, &active));
+    TEST_CHECK_INT(1, temp_threshold_update(thresholds, TH_NUM, -100, &active));
+    TEST_CHECK_INT(0x3, active);
+    TEST_CHECK_INT(-1, temp_threshold_update(thresholds, TH_NUM, -499, &active));
+    TEST_CHECK_INT(0x3, active);
+}
+
+/* 一次跨越多個臨界值: 每次取樣觸發一個，依陣列順序，各產生一筆事件 */
+static void multi_crossing(void)
+{
+    uint32_t active = 0;
+
+    TEST_CHECK_INT(0, temp_threshold_update(thresholds, TH_NUM, -600, &active));
+    TEST_CHECK_INT(1, temp_threshold_update(thresholds, TH_NUM, -600, &active));
+    TEST_CHECK_INT(2, temp_threshold_update(thresholds, TH_NUM, -600, &active));
+    TEST_CHECK_INT(-1, temp_threshold_update(thresholds, TH_NUM, -600, &active));
+    TEST_CHECK_INT(0x7, active);
+
+    // 一次回升到所有解除溫度以上，全部解除且不產生事件
+    TEST_CHECK_INT(-1, temp_threshold_update(thresholds, TH_NUM, 500, &active));
+    TEST_CHECK_INT(0, active);
+}
+
+/* 遲滯: 在 trigger 與 trigger + HYST 之間的抖動不重複觸發，超過後才解除，再次跨越時重新觸發 */
+static void hysteresis(void)
+{
+    static const int16_t noisy[] = { 120, 100, 110, 99, 140, 101, 150, 100, 95, 130, 100 };
+    int fired[TH_NUM] = { 0 };
+    uint32_t active = 0;
+
+    TEST_CHECK_INT(1, feed(noisy, sizeof(noisy) / sizeof(noisy[0]), &active, fired));
+    TEST_CHECK_INT(1, fired[0]);
+    TEST_CHECK_INT(0x1, active);
+
+    // 等於解除溫度時仍觸發中
+    TEST_CHECK_INT(-1, temp_threshold_update(thresholds, TH_NUM, 100 + HYST, &active));
+    TEST_CHECK_INT(0x1, active);
+    TEST_CHECK_INT(-1, temp_threshold_update(thresholds, TH_NUM, 100 + HYST + 1, &active));
+    TEST_CHECK_INT(0, active);
+    TEST_CHECK_INT(0, temp_threshold_update(thresholds, TH_NUM, 100, &active));
+
+    // 各臨界值獨立解除: 0°C 高於 -100 的解除溫度，但仍在 100 的遲滯範圍內
+    active = 0x3;
+    TEST_CHECK_INT(-1, temp_threshold_update(thresholds, TH_NUM, 0, &active));
+    TEST_CHECK_INT(0x1, active);
+}
+
+/* 到邊界的距離: 未觸發時到 trigger，觸發中到解除溫度 (超過才解除，因此 +1)，有未觸發的跨越時為 0 */
+static void margin(void)
+{
+    TEST_CHECK_INT(200, temp_threshold_margin(thresholds, TH_NUM, 300, 0));
+    TEST_CHECK_INT(HYST + 1, temp_threshold_margin(thresholds, TH_NUM, 100, 0x1));
+    TEST_CHECK_INT(40, temp_threshold_margin(thresholds, TH_NUM, -60, 0x1));
+    TEST_CHECK_INT(0, temp_threshold_margin(thresholds, TH_NUM, -150, 0x1));
+    TEST_CHECK_INT(0, temp_threshold_margin(thresholds, TH_NUM, 50, 0));
+    TEST_CHECK_INT(INT32_MAX, temp_threshold_margin(thresholds, 0, 50, 0));
+}
+
+/* 週期: 溫度不變時加倍，接近邊界時取到達時間的一半，結果限制在 [MIN_MS, MAX_MS] */
+static void next_period(void)
+{
+    // 溫度不變: 加倍，到上限為止
+    TEST_CHECK_INT(4000, temp_threshold_next_period(2000, 500, 500, 400, MIN_MS, MAX_MS));
+    TEST_CHECK_INT(MAX_MS, temp_threshold_next_period(40000, 500, 500, 400, MIN_MS, MAX_MS));
+    TEST_CHECK_INT(MAX_MS, temp_threshold_next_period(MAX_MS, 500, 500, 400, MIN_MS, MAX_MS));
+
+    // 10 秒變化 1°C、距離邊界 2°C: 約 20 秒到達，下一次 10 秒後取樣
+    TEST_CHECK_INT(10000, temp_threshold_next_period(10000, 300, 200, 200, MIN_MS, MAX_MS));
+    // 上升與下降相同
+    TEST_CHECK_INT(10000, temp_threshold_next_period(10000, 200, 300, 200, MIN_MS, MAX_MS));
+
+    // 變化很慢時最多加倍
+    TEST_CHECK_INT(20000, temp_threshold_next_period(10000, 300, 299, 2000, MIN_MS, MAX_MS));
+
+    // 已到邊界或變化很快: 下限
+    TEST_CHECK_INT(MIN_MS, temp_threshold_next_period(10000, 300, 200, 0, MIN_MS, MAX_MS));
+    TEST_CHECK_INT(MIN_MS, temp_threshold_next_period(10000, 2000, -2000, 100, MIN_MS, MAX_MS));
+
+    // 沒有臨界值 (margin 為 INT32_MAX) 且溫度大幅變化時不溢位
+    TEST_CHECK_INT(MAX_MS, temp_threshold_next_period(MAX_MS, -32768, 32767, INT32_MAX, MIN_MS, MAX_MS));
+}
+
+/*
+  以調整後的週期取樣每秒變化 0.1°C 的溫度，由 25°C 降到 -6°C 再回升到 5°C:
+  每個臨界值各觸發一次，觸發時的溫度與臨界值的差不超過以最短週期取樣時的變化量
+*/
+static void ramp(void)
+{
+    const int32_t rate_cc_per_s = 10;
+    const int32_t max_overshoot = rate_cc_per_s * MIN_MS / 1000;
+    uint32_t period = MAX_MS;
+    uint32_t active = 0;
+    int fired[TH_NUM] = { 0 };
+    int64_t t_ms = 0;
+    int16_t prev = 2500;
+
+    for (int dir = -1; dir <= 1; dir += 2) {
+        for (;;) {
+            t_ms += period;
+            int32_t cc = dir < 0 ? 2500 - rate_cc_per_s * t_ms / 1000 : -600 + rate_cc_per_s * t_ms / 1000;
+            if ((dir < 0 && cc <= -600) || (dir > 0 && cc >= 500)) {
+                break;
+            }
+            int th = temp_threshold_update(thresholds, TH_NUM, cc, &active);
+            if (th >= 0) {
+                fired[th]++;
+                TEST_CHECK(thresholds[th].trigger_cc - cc <= max_overshoot);
+            }
+            int32_t m = temp_threshold_margin(thresholds, TH_NUM, cc, active);
+            period = temp_threshold_next_period(period, prev, cc, m, MIN_MS, MAX_MS);
+            TEST_CHECK(period >= MIN_MS && period <= MAX_MS);
+            prev = cc;
+        }
+        t_ms = 0;
+    }
+    for (size_t i = 0; i < TH_NUM; i++) {
+        TEST_CHECK_INT(1, fired[i]);
+    }
+    TEST_CHECK_INT(0, active);
+}
+
+int main(void)
+{
+    crossing();
+    multi_crossing();
+    hysteresis();
+    margin();
+    next_period();
+    ramp();
+    return TEST_EXIT();
+}
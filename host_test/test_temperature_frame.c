@@ -0,0 +1,118 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 溫度通知封包: 編碼後解碼必須還原相同的樣本，格式錯誤的封包必須被拒絕 */
+
+#include <stdlib.h>
+#include <string.h>
+#include "temperature_frame.h"
+#include "test_util.h"
+
+#define ATT_NOTIFY_HEADER_LEN   3
+#define SAMPLE_NUM              600
+
+static temperature_sample_t samples[SAMPLE_NUM];
+
+/* 1 秒週期、偶爾延遲的取樣，溫度隨機漫步並跨越 0°C */
+static void make_samples(void)
+{
+    uint32_t ts = 0xfffff000;   // 接近 32 位元上限，時間差仍為正
+    int32_t cc = 150;
+    srand(1);
+    for (int i = 0; i < SAMPLE_NUM; i++) {
+        ts += 1000 + (i % 37 == 0 ? 70000 : rand() % 5);
+        cc += rand() % 41 - 20;
+        if (i == SAMPLE_NUM / 2) {
+            cc = -3000;         // 大跳動需要多位元組的 zigzag varint
+        }
+        samples[i].timestamp_ms = ts;
+        samples[i].centi_celsius = (int16_t)cc;
+    }
+}
+
+/* 以 mtu 將所有樣本分包送出，再逐包解碼比對 */
+static void round_trip(uint16_t mtu)
+{
+    uint8_t frame[512];
+    temperature_sample_t decoded[TEMPERATURE_FRAME_MAX_SAMPLES];
+    temperature_frame_info_t info;
+    size_t cap = mtu - ATT_NOTIFY_HEADER_LEN;
+    size_t done = 0;
+    uint8_t seq = 250;          // 序號會繞回
+
+    while (done < SAMPLE_NUM) {
+        size_t packed;
+        size_t len = temperature_frame_encode(samples + done, SAMPLE_NUM - done, seq, frame, cap, &packed);
+        TEST_CHECK(len > 0 && len <= cap);
+        TEST_CHECK(packed > 0);
+        if (len == 0 || packed == 0) {
+            return;
+        }
+        int n = temperature_frame_decode(frame, len, &info, decoded, TEMPERATURE_FRAME_MAX_SAMPLES);
+        TEST_CHECK_INT(packed, n);
+        TEST_CHECK_INT(TEMPERATURE_FRAME_VERSION, info.version);
+        TEST_CHECK_INT(seq, info.seq);
+        TEST_CHECK_INT(packed, info.count);
+        for (int i = 0; i < n; i++) {
+            TEST_CHECK_INT(samples[done + i].timestamp_ms, decoded[i].timestamp_ms);
+            TEST_CHECK_INT(samples[done + i].centi_celsius, decoded[i].centi_celsius);
+        }
+        done += packed;
+        seq++;
+    }
+}
+
+/* 格式錯誤: 截斷、多餘的位元組、版本不符與樣本數為 0 */
+static void malformed(void)
+{
+    uint8_t frame[64];
+    temperature_sample_t decoded[8];
+    size_t packed;
+    size_t len = temperature_frame_encode(samples, 8, 0, frame, sizeof(frame) - 1, &packed);
+
+    TEST_CHECK_INT(8, packed);
+    TEST_CHECK_INT(-1, temperature_frame_decode(frame, TEMPERATURE_FRAME_HEADER_LEN - 1, NULL, decoded, 8));
+    TEST_CHECK_INT(-1, temperature_frame_decode(frame, len - 1, NULL, decoded, 8));
+    frame[len] = 0;
+    TEST_CHECK_INT(-1, temperature_frame_decode(frame, len + 1, NULL, decoded, 8));
+
+    frame[0] = TEMPERATURE_FRAME_VERSION + 1;
+    TEST_CHECK_INT(-1, temperature_frame_decode(frame, len, NULL, decoded, 8));
+    frame[0] = TEMPERATURE_FRAME_VERSION;
+    frame[2] = 0;
+    TEST_CHECK_INT(-1, temperature_frame_decode(frame, len, NULL, decoded, 8));
+}
+
+/* 輸出空間不足一筆樣本時不打包；解碼的輸出空間較小時只輸出前面的樣本 */
+static void capacity(void)
+{
+    uint8_t frame[64];
+    temperature_sample_t decoded[2];
+    size_t packed;
+
+    TEST_CHECK_INT(0, temperature_frame_encode(samples, 4, 0, frame, TEMPERATURE_FRAME_HEADER_LEN - 1, &packed));
+    TEST_CHECK_INT(0, packed);
+    TEST_CHECK_INT(TEMPERATURE_FRAME_HEADER_LEN, temperature_frame_encode(samples, 4, 0, frame, TEMPERATURE_FRAME_HEADER_LEN, &packed));
+    TEST_CHECK_INT(1, packed);
+
+    size_t len = temperature_frame_encode(samples, 4, 0, frame, sizeof(frame), &packed);
+    TEST_CHECK_INT(4, packed);
+    TEST_CHECK_INT(2, temperature_frame_decode(frame, len, NULL, decoded, 2));
+    TEST_CHECK_INT(samples[1].centi_celsius, decoded[1].centi_celsius);
+}
+
+int main(void)
+{
+    make_samples();
+    round_trip(23);
+    round_trip(185);
+    round_trip(247);
+    malformed();
+    capacity();
+    return TEST_EXIT();
+}
@@ -0,0 +1,32 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* 主機端測試共用的檢查巨集，失敗時印出位置並繼續，main() 以 TEST_EXIT() 回傳結果 */
+
+#pragma once
+
+#include <stdio.h>
+
+static int test_failures;
+
+#define TEST_CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define TEST_CHECK_INT(expected, actual) do { \
+        long long e_ = (long long)(expected), a_ = (long long)(actual); \
+        if (e_ != a_) { \
+            fprintf(stderr, "%s:%d: %s: expected %lld, got %lld\n", __FILE__, __LINE__, #actual, e_, a_); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define TEST_EXIT() (printf("%s: %s\n", __FILE__, test_failures ? "FAILED" : "OK"), test_failures ? 1 : 0)
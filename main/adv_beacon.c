@@ -0,0 +1,47 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+#include "adv_beacon.h"
+
+void adv_beacon_set_counters(adv_beacon_t *beacon, const uint32_t *totals)
+{
+    for (int i = 0; i < ADV_BEACON_EVENT_TYPES; i++) {
+        beacon->counters[i] = totals[i] & 0xff;
+    }
+}
+
+size_t adv_beacon_encode(const adv_beacon_t *beacon, uint8_t *out, size_t cap)
+{
+    if (cap < ADV_BEACON_LEN) {
+        return 0;
+    }
+    out[0] = ADV_BEACON_COMPANY_ID & 0xff;
+    out[1] = ADV_BEACON_COMPANY_ID >> 8;
+    out[2] = ADV_BEACON_VERSION;
+    out[3] = beacon->flags;
+    out[4] = beacon->latest_gpio;
+    memcpy(&out[5], beacon->counters, ADV_BEACON_EVENT_TYPES);
+    out[10] = beacon->log_len & 0xff;
+    out[11] = (beacon->log_len >> 8) & 0xff;
+    out[12] = (beacon->log_len >> 16) & 0xff;
+    out[13] = beacon->log_len >> 24;
+    return ADV_BEACON_LEN;
+}
+
+bool adv_beacon_decode(const uint8_t *data, size_t len, adv_beacon_t *beacon)
+{
+    if (len < ADV_BEACON_LEN || (data[0] | data[1] << 8) != ADV_BEACON_COMPANY_ID || data[2] != ADV_BEACON_VERSION) {
+        return false;
+    }
+    beacon->flags = data[3];
+    beacon->latest_gpio = data[4];
+    memcpy(beacon->counters, &data[5], ADV_BEACON_EVENT_TYPES);
+    beacon->log_len = data[10] | data[11] << 8 | data[12] << 16 | (uint32_t)data[13] << 24;
+    return true;
+}
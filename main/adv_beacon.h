@@ -0,0 +1,62 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  廣播封包中的事件摘要 (manufacturer specific data，與 ESP-IDF 無關，可直接在主機端編譯解碼)，
+  gateway 只需被動掃描即可得知是否有新事件，log 長度增加時才連線匯出
+
+  | offset | size | 內容                                                  |
+  |--------|------|-------------------------------------------------------|
+  | 0      | 2    | company id ADV_BEACON_COMPANY_ID (little endian)      |
+  | 2      | 1    | 版本 ADV_BEACON_VERSION                               |
+  | 3      | 1    | 旗標 ADV_BEACON_FLAG_*                                |
+  | 4      | 1    | 最近一次事件的 GPIO，沒有事件時為 0                   |
+  | 5      | 5    | GPIO 10 ~ 14 的事件次數 (各 1 byte，超過 255 後從 0 繼續) |
+  | 10     | 4    | 事件紀錄的長度 (bytes, little endian)，可作為匯出的起始位置 |
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADV_BEACON_COMPANY_ID       0x02E5  // Espressif Inc.
+#define ADV_BEACON_VERSION          1
+#define ADV_BEACON_EVENT_TYPES      5
+#define ADV_BEACON_LEN              14
+
+#define ADV_BEACON_FLAG_LOW_BATTERY (1 << 0)    // 上電後發生過低電量事件
+#define ADV_BEACON_FLAG_ABNORMAL    (1 << 1)    // 上電後發生過設備異常事件
+
+typedef struct {
+    uint8_t  flags;
+    uint8_t  latest_gpio;
+    uint8_t  counters[ADV_BEACON_EVENT_TYPES];
+    uint32_t log_len;
+} adv_beacon_t;
+
+/*
+  由上電後的事件總數 (ADV_BEACON_EVENT_TYPES 個) 填入 counters，超過 255 後從 0 繼續。
+  gateway 以 (uint8_t)(新值 - 舊值) 計算兩次掃描之間的新事件數 (間隔內少於 256 次)
+*/
+void adv_beacon_set_counters(adv_beacon_t *beacon, const uint32_t *totals);
+
+/* 編碼到 out，cap 不足 ADV_BEACON_LEN 時回傳 0 */
+size_t adv_beacon_encode(const adv_beacon_t *beacon, uint8_t *out, size_t cap);
+
+/* 解碼 manufacturer specific data，company id 或版本不符時回傳 false */
+bool adv_beacon_decode(const uint8_t *data, size_t len, adv_beacon_t *beacon);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,351 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  喚醒流程的平台實作: light sleep、GPIO 喚醒、事件紀錄與 BLE 啟動 (經由 ble_host.h，與 host 無關)
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_system.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "driver/uart.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "adv_beacon.h"
+#include "ble_host.h"
+#include "diag.h"
+#include "diag_console.h"
+#include "event_aggregator.h"
+#include "event_store.h"
+#include "fast_boot.h"
+#include "flash_meter.h"
+#include "light_sleep_example.h"
+#include "mem_budget.h"
+#include "power_model.h"
+#include "task_profiler.h"
+#include "temp_sampler.h"
+#include "wake_fsm.h"
+#include "wake_session.h"
+
+static const char *TAG = "app_main";
+
+static uint8_t wakeup_gpio;
+
+static char record[MEM_BUDGET_EVENT_RECORD];
+
+/* 將已結束 (all 為 true 時全部) 的重複事件摘要寫入事件紀錄，沒有摘要時不存取 flash */
+static void write_event_summaries(bool all)
+{
+    event_agg_summary_t summaries[EVENT_AGG_TYPES];
+    size_t num = event_aggregator_take(summaries, EVENT_AGG_TYPES, all);
+
+    for (size_t i = 0; i < num; i++) {
+        if (event_store_format_summary(wake_fsm_event_name(summaries[i].gpio), summaries[i].first_ms,
+                                       summaries[i].last_ms, summaries[i].count,
+                                       summaries[i].min_interval_ms, record, sizeof(record)) == ESP_OK) {
+            event_store_append(record);
+        }
+    }
+}
+
+/*
+  將上電後的事件次數與事件紀錄長度放入廣播封包 (見 adv_beacon.h)，
+  gateway 掃描即可得知是否有新事件，紀錄長度沒有增加時不需連線匯出
+*/
+static void update_adv_beacon(void)
+{
+    uint32_t totals[EVENT_AGG_TYPES];
+    adv_beacon_t beacon = {
+        .latest_gpio = event_aggregator_counts(totals),
+    };
+    uint8_t data[ADV_BEACON_LEN];
+
+    adv_beacon_set_counters(&beacon, totals);
+    if (totals[LOW_BATTERY_WAKEUP_GPIO - TEMPERATURE_WAKEUP_GPIO1]) {
+        beacon.flags |= ADV_BEACON_FLAG_LOW_BATTERY;
+    }
+    if (totals[DEVICE_ABNORMAL_WAKEUP_GPIO - TEMPERATURE_WAKEUP_GPIO1]) {
+        beacon.flags |= ADV_BEACON_FLAG_ABNORMAL;
+    }
+    event_store_size(&beacon.log_len);
+    ble_host_set_adv_beacon(data, adv_beacon_encode(&beacon, data, sizeof(data)));
+}
+
+/*
+  將事件寫入事件紀錄 (SPIFFS 或 LittleFS，見 event_store.h)，
+  檔案系統在第一次寫入時掛載並保持掛載，每筆事件只需一次 append。
+  同一種事件在 EVENT_AGG_WINDOW_MS 內重複時只計數，window 結束後寫入一筆摘要
+*/
+static void event_log_start(void *ctx)
+{
+    uint8_t gpio = *(const uint8_t *)ctx;
+
+    mem_budget_phase_begin(MEM_PHASE_EVENT_LOG);
+    // 先寫入前一個 window 的摘要，再開始新的 window
+    write_event_summaries(false);
+    if (event_aggregator_feed(gpio) == EVENT_AGG_WRITE) {
+        const char *str = wake_fsm_event_name(gpio);
+        if (str == NULL) {
+            str = "";
+        }
+        // 上電後經過的時間，與摘要使用相同的時間基準
+        if (event_store_format(str, event_aggregator_now_ms(), record, sizeof(record)) == ESP_OK) {
+            event_store_append(record);
+        }
+    }
+    mem_budget_phase_end(MEM_PHASE_EVENT_LOG);
+}
+
+/* 掛載時容量資訊不合理會在背景檢查，檢查結束前不重新啟動 */
+static bool event_log_done(void *ctx)
+{
+    return !event_store_busy();
+}
+
+/* 事件喚醒後的工作，全部完成 (最長 WAKE_SESSION_DEADLINE_MS) 後返回並重新啟動 */
+static void platform_write_event(uint8_t gpio)
+{
+    const wake_work_t works[] = {
+        { .name = "event_log", .start = event_log_start, .done = event_log_done, .ctx = &gpio },
+    };
+
+    task_profiler_begin(TASK_PROFILER_WAKE_EVENT);
+    wake_session_run(gpio, works, sizeof(works) / sizeof(works[0]));
+    task_profiler_end(TASK_PROFILER_WAKE_EVENT);
+}
+
+static bool pending_boot;       // 新的 OTA 映像第一次啟動，只為了確認映像而廣播 (見 app_main())
+static bool ble_has_conn;
+
+static void ble_connected(uint16_t conn_id)
+{
+    ble_has_conn = true;
+    wake_fsm_set_state(WAKE_STATE_BLE_CONN);
+}
+
+static void ble_disconnected(uint16_t conn_id, int conn_num)
+{
+    ble_has_conn = conn_num > 0;
+    if (conn_num == 0) {
+        task_profiler_end(TASK_PROFILER_BLE);
+        // 所有連線都斷開後重新啟動以進入 light sleep
+        wake_fsm_restart();
+    }
+}
+
+/*
+  新的 OTA 映像在第一次開始廣播後標記為有效，確認可以再次 OTA。
+  這次啟動不是由 GPIO 9 喚醒，沒有 central 連線時重新啟動，回到 light sleep 與 GPIO 10 ~ 14 的事件處理
+*/
+static void ble_advertising(void)
+{
+    fast_boot_confirm();
+    if (pending_boot && !ble_has_conn) {
+        pending_boot = false;
+        task_profiler_end(TASK_PROFILER_BLE);
+        wake_fsm_restart();
+    }
+}
+
+static const ble_host_callbacks_t ble_callbacks = {
+    .connected = ble_connected,
+    .disconnected = ble_disconnected,
+    .advertising = ble_advertising,
+};
+
+/*
+  每次啟動都初始化 NVS: 事件紀錄的更新中旗標在第一次掛載時由 NVS 讀取，
+  flash_meter_init() 在 RTC 保留計量時不初始化 NVS，BLE host 也需要 NVS
+*/
+static void nvs_init(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK( ret );
+}
+
+/* 開始藍芽廣播，之後由 host 處理連線，所有連線斷開後重新啟動 */
+static void platform_start_ble(void)
+{
+    // BLE 喚醒的次數少，在此將 flash 計量存到 NVS
+    flash_meter_save();
+    flash_meter_report();
+    mem_budget_report();
+    wake_session_report();
+    temp_sampler_report();
+    fast_boot_report();
+    // 匯出事件紀錄前寫入尚未結束的重複事件摘要
+    write_event_summaries(true);
+    update_adv_beacon();
+
+    task_profiler_begin(TASK_PROFILER_BLE);
+    mem_budget_phase_begin(MEM_PHASE_BLE_INIT);
+    esp_err_t ret = ble_host_start(&ble_callbacks);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "%s host start failed (%s)", BLE_HOST_NAME, esp_err_to_name(ret));
+    }
+    mem_budget_phase_end(MEM_PHASE_BLE_INIT);
+}
+
+static int64_t platform_now_us(void)
+{
+    return esp_timer_get_time();
+}
+
+/* 下一次 timer 喚醒: 溫度取樣週期與重複事件 hold-off 結束中較早者，都沒有時不以 timer 喚醒 */
+static void arm_timer_wakeup(void)
+{
+    int64_t ms = -1;
+#if TEMP_SAMPLER_ENABLE
+    ms = temp_sampler_period_ms();
+#endif
+    int64_t holdoff_ms = event_aggregator_holdoff_ms();
+    if (holdoff_ms >= 0 && (ms < 0 || holdoff_ms < ms)) {
+        ms = holdoff_ms;
+    }
+    if (ms < 0) {
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+        return;
+    }
+    esp_sleep_enable_timer_wakeup((ms > 0 ? ms : 1) * 1000);
+}
+
+static void platform_light_sleep(void)
+{
+    arm_timer_wakeup();
+    printf("Entering light sleep\n");
+
+    // 等待 UART tx 記憶體清空並且最後一個字元發送成功（輪詢模式）
+    uart_wait_tx_idle_polling(CONFIG_ESP_CONSOLE_UART_NUM);
+
+    /* Enter sleep mode */
+    esp_light_sleep_start();
+}
+
+static bool platform_woken_by_gpio(void)
+{
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO;
+}
+
+static bool platform_woken_by_uart(void)
+{
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UART;
+}
+
+static bool platform_woken_by_timer(void)
+{
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+}
+
+/* timer 喚醒: hold-off 結束時重新啟動以恢復 GPIO 喚醒，否則取樣溫度 */
+static wake_sample_t platform_sample(uint8_t *gpio)
+{
+    if (event_aggregator_holdoff_ms() == 0) {
+        return WAKE_SAMPLE_RESTART;
+    }
+#if TEMP_SAMPLER_ENABLE
+    *gpio = temp_sampler_run();
+    return *gpio ? WAKE_SAMPLE_EVENT : WAKE_SAMPLE_SLEEP;
+#else
+    return WAKE_SAMPLE_RESTART;
+#endif
+}
+
+/* 由 UART 喚醒，開始診斷 console，閒置後由 console 重新啟動 */
+static void platform_start_console(void)
+{
+    esp_err_t ret = diag_console_start();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "console start failed (%s)", esp_err_to_name(ret));
+        wake_fsm_restart();
+    }
+}
+
+static uint8_t platform_wait_gpio_inactive(void)
+{
+    wakeup_gpio = example_wait_gpio_inactive();
+    printf("wakeup_gpio = %u\n", wakeup_gpio);
+    return wakeup_gpio;
+}
+
+/* 各狀態累計的時間，重新啟動後仍保留，斷電後清除 */
+static __NOINIT_ATTR power_stats_t power_stats;
+
+static size_t power_stats_diag_read(uint32_t offset, uint8_t *buf, size_t cap)
+{
+    if (offset >= sizeof(power_stats)) {
+        return 0;
+    }
+    size_t len = sizeof(power_stats) - offset;
+    if (len > cap) {
+        len = cap;
+    }
+    memcpy(buf, (const uint8_t *)&power_stats + offset, len);
+    return len;
+}
+
+static const wake_platform_t wake_platform = {
+    .now_us = platform_now_us,
+    .light_sleep = platform_light_sleep,
+    .woken_by_gpio = platform_woken_by_gpio,
+    .woken_by_uart = platform_woken_by_uart,
+    .woken_by_timer = platform_woken_by_timer,
+    .sample = platform_sample,
+    .wait_gpio_inactive = platform_wait_gpio_inactive,
+    .start_ble = platform_start_ble,
+    .write_event = platform_write_event,
+    .start_console = platform_start_console,
+    .restart = esp_restart,
+    .stats = &power_stats,
+};
+
+void app_main(void)
+{
+    /* Enable wakeup from light sleep by gpio */
+    example_register_gpio_wakeup(); 
+    /* Hold off wakeup from gpio with repeated events */
+    event_aggregator_init();
+    /* Enable wakeup from light sleep by uart, bench tools talk to diag_console */
+    example_register_uart_wakeup();
+#if TEMP_SAMPLER_ENABLE
+    /* Enable wakeup from light sleep by timer, the period is adjusted before each sleep */
+    example_register_timer_wakeup();
+#endif
+
+    mem_budget_init();
+    mem_budget_phase_begin(MEM_PHASE_BOOT);
+    flash_meter_init();
+    nvs_init();
+    fast_boot_init();
+    task_profiler_init();
+    wake_session_init();
+#if TEMP_SAMPLER_ENABLE
+    temp_sampler_init(NULL);
+#endif
+    diag_register(DIAG_ID_POWER_STATS, power_stats_diag_read);
+
+    mem_budget_phase_end(MEM_PHASE_BOOT);
+
+    /* Verify a new image once before the first sleep */
+    fast_boot_verify();
+
+    if (fast_boot_pending()) {
+        /* A new OTA image is confirmed once advertising starts, any restart before that rolls back */
+        pending_boot = true;
+        wake_fsm_run_ble(&wake_platform);
+        return;
+    }
+    wake_fsm_run(&wake_platform);
+}
@@ -0,0 +1,103 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  連線狀態表，只在 BTC task 的 GATT 事件中存取
+*/
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ble_conn.h"
+#include "diag.h"
+
+static const char *TAG = "ble_conn";
+
+static ble_conn_t conn_tab[BLE_CONN_MAX];
+
+ble_conn_t *ble_conn_find(uint16_t conn_id)
+{
+    for (int i = 0; i < BLE_CONN_MAX; i++) {
+        if (conn_tab[i].in_use && conn_tab[i].conn_id == conn_id) {
+            return &conn_tab[i];
+        }
+    }
+    return NULL;
+}
+
+ble_conn_t *ble_conn_find_bda(const esp_bd_addr_t remote_bda)
+{
+    for (int i = 0; i < BLE_CONN_MAX; i++) {
+        if (conn_tab[i].in_use && memcmp(conn_tab[i].remote_bda, remote_bda, sizeof(esp_bd_addr_t)) == 0) {
+            return &conn_tab[i];
+        }
+    }
+    return NULL;
+}
+
+ble_conn_t *ble_conn_open(uint16_t conn_id, const esp_bd_addr_t remote_bda)
+{
+    ble_conn_t *conn = ble_conn_find(conn_id);
+    for (int i = 0; conn == NULL && i < BLE_CONN_MAX; i++) {
+        if (!conn_tab[i].in_use) {
+            conn = &conn_tab[i];
+        }
+    }
+    if (conn == NULL) {
+        ESP_LOGE(TAG, "no free context for conn %d", conn_id);
+        return NULL;
+    }
+    memset(conn, 0, sizeof(*conn));
+    conn->in_use = true;
+    conn->conn_id = conn_id;
+    memcpy(conn->remote_bda, remote_bda, sizeof(esp_bd_addr_t));
+    conn->mtu = ESP_GATT_DEF_BLE_MTU_SIZE;
+    conn->connect_time_us = esp_timer_get_time();
+    conn->diag_id = DIAG_ID_FLASH_METER;
+    return conn;
+}
+
+void ble_conn_ready(ble_conn_t *conn)
+{
+    if (conn->ready_time_us) {
+        return;
+    }
+    conn->ready_time_us = esp_timer_get_time();
+    int64_t ready_ms = (conn->ready_time_us - conn->connect_time_us) / 1000;
+    if (conn->encrypt_time_us) {
+        ESP_LOGI(TAG, "conn %d ready %lld ms after connect (%s keys, encrypted at %lld ms)",
+                 conn->conn_id, ready_ms, conn->paired ? "new" : "bonded",
+                 (conn->encrypt_time_us - conn->connect_time_us) / 1000);
+    } else {
+        ESP_LOGI(TAG, "conn %d ready %lld ms after connect (not encrypted)", conn->conn_id, ready_ms);
+    }
+}
+
+void ble_conn_close(uint16_t conn_id)
+{
+    ble_conn_t *conn = ble_conn_find(conn_id);
+    if (conn == NULL) {
+        return;
+    }
+    int64_t duration_ms = (esp_timer_get_time() - conn->connect_time_us) / 1000;
+    ESP_LOGI(TAG, "conn %d closed after %lld ms: mtu %d, %lu writes, %lu bytes (%lu B/s)",
+             conn_id, duration_ms, conn->mtu, conn->rx_writes, conn->rx_bytes,
+             duration_ms > 0 ? (uint32_t)(conn->rx_bytes * 1000ULL / duration_ms) : 0);
+    conn->in_use = false;
+}
+
+int ble_conn_count(void)
+{
+    int count = 0;
+    for (int i = 0; i < BLE_CONN_MAX; i++) {
+        if (conn_tab[i].in_use) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,71 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/param.h>
+#include "sdkconfig.h"
+#include "esp_bt_defs.h"
+#include "esp_gatt_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  同時連線數: Bluedroid host (CONFIG_BT_ACL_CONNECTIONS) 與 controller
+  (CONFIG_BT_LE_MAX_CONNECTIONS) 的上限取較小者，controller 無法建立更多連線
+*/
+#ifdef CONFIG_BT_LE_MAX_CONNECTIONS
+#define BLE_CONN_MAX        MIN(CONFIG_BT_ACL_CONNECTIONS, CONFIG_BT_LE_MAX_CONNECTIONS)
+#else
+#define BLE_CONN_MAX        CONFIG_BT_ACL_CONNECTIONS
+#endif
+
+/* 每個連線各自的狀態，長寫入緩衝區與送出佇列另外以 conn_id 對應 */
+typedef struct {
+    bool          in_use;
+    uint16_t      conn_id;
+    esp_bd_addr_t remote_bda;
+    uint16_t      mtu;
+    uint16_t      temperature_cccd;  // 溫度 characteristic 的 CCCD 值 (每個連線各自訂閱)
+    uint32_t      log_offset;        // 事件紀錄匯出的讀取位置
+    uint8_t       diag_id;           // 診斷 characteristic 選擇的資料 (DIAG_ID_*)
+    int64_t       connect_time_us;
+    int64_t       encrypt_time_us;   // 加密完成的時間，未加密時為 0
+    int64_t       ready_time_us;     // 第一次存取 OTA / 溫度 service 的時間 (探索服務之後)
+    bool          paired;            // 本次連線新配對，否則使用已綁定的金鑰
+    uint32_t      rx_bytes;          // 收到的寫入資料量
+    uint32_t      rx_writes;         // 收到的寫入次數
+} ble_conn_t;
+
+/* ESP_GATTS_CONNECT_EVT 時建立連線狀態，連線數已滿時回傳 NULL */
+ble_conn_t *ble_conn_open(uint16_t conn_id, const esp_bd_addr_t remote_bda);
+
+ble_conn_t *ble_conn_find(uint16_t conn_id);
+
+/* 以對方位址尋找連線，用於只帶位址的 GAP 安全性事件 */
+ble_conn_t *ble_conn_find_bda(const esp_bd_addr_t remote_bda);
+
+/*
+  GATT 讀寫事件時呼叫，第一次呼叫時印出連線到開始存取的時間 (包含服務探索與加密)，
+  可比較已綁定且使用快取的 client 與新 client 的連線建立時間
+*/
+void ble_conn_ready(ble_conn_t *conn);
+
+/* ESP_GATTS_DISCONNECT_EVT 時釋放連線狀態並印出統計 */
+void ble_conn_close(uint16_t conn_id);
+
+/* 目前的連線數 */
+int ble_conn_count(void);
+
+#ifdef __cplusplus
+}
+#endif
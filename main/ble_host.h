@@ -0,0 +1,69 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  BLE host 抽象層: GATT server (OTA service、溫度 service)、廣播與連線管理，
+  依 sdkconfig 選擇 Bluedroid (gatts_table_creat_demo.c) 或 NimBLE (ble_host_nimble.c) 實作
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/param.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_BT_NIMBLE_ENABLED
+#define BLE_HOST_NAME       "nimble"
+#define BLE_HOST_CONN_NUM   CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#else
+#define BLE_HOST_NAME       "bluedroid"
+#define BLE_HOST_CONN_NUM   CONFIG_BT_ACL_CONNECTIONS
+#endif
+
+/* host 設定的連線數不能超過 controller 的上限，與 BLE_CONN_MAX 相同取較小者 */
+#ifdef CONFIG_BT_LE_MAX_CONNECTIONS
+#define BLE_HOST_MAX_CONN   MIN(BLE_HOST_CONN_NUM, CONFIG_BT_LE_MAX_CONNECTIONS)
+#else
+#define BLE_HOST_MAX_CONN   BLE_HOST_CONN_NUM
+#endif
+
+#define BLE_HOST_MAX_MTU    517     // ATT MTU 上限，與 ESP_GATT_MAX_MTU_SIZE 相同
+
+typedef struct {
+    void (*connected)(uint16_t conn_id);
+    void (*disconnected)(uint16_t conn_id, int conn_num);  // conn_num 為斷線後剩餘的連線數
+    void (*advertising)(void);                              // ble_host_start() 後第一次開始廣播成功，可為 NULL
+} ble_host_callbacks_t;
+
+/*
+  初始化 controller 與 host，建立 GATT 服務並開始廣播 (NVS 需已初始化)。
+  從呼叫到開始廣播的時間會印在 log 中 (`ble_host` tag)，可用於比較兩種 host
+*/
+esp_err_t ble_host_start(const ble_host_callbacks_t *callbacks);
+
+/*
+  對連線送出 notification (need_confirm = false) 或 indication (need_confirm = true)
+  @return ESP_ERR_NO_MEM 表示送出緩衝已滿，封包被丟棄
+*/
+esp_err_t ble_host_notify(uint16_t conn_id, uint16_t attr_handle, const uint8_t *data, uint16_t len, bool need_confirm);
+
+/*
+  設定廣播封包中的 manufacturer specific data (見 adv_beacon.h)，最長 ADV_BEACON_LEN bytes。
+  ble_host_start() 之前呼叫時用於第一次廣播，廣播中呼叫時更新廣播內容
+*/
+void ble_host_set_adv_beacon(const uint8_t *data, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
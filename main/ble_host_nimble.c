@@ -0,0 +1,548 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  NimBLE 實作的 GATT server，服務、characteristic 與行為與 Bluedroid 版本 (gatts_table_creat_demo.c) 相同:
+  OTA service (OTA Control / OTA Data) 與溫度 service (溫度通知 / 事件紀錄匯出 / 診斷資料)。
+
+  與 Bluedroid 版本的差異:
+  - CCCD、長寫入 (Prepare Write) 與 long read 的 offset 由 NimBLE 處理，不需 prepare_write 與 gatts_dispatch
+  - notification/indication 直接交給 NimBLE 的 mbuf，不經過 gatts_send_queue
+  - 長寫入的長度上限為 BLE_ATT_ATTR_MAX_LEN (512 bytes)
+*/
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nimble/nimble_port.h"
+#include "nimble/nimble_port_freertos.h"
+#include "host/ble_hs.h"
+#include "host/util/util.h"
+#include "host/ble_store.h"
+#include "services/gap/ble_svc_gap.h"
+#include "services/gatt/ble_svc_gatt.h"
+#include "gatts_table_creat_demo.h"
+#include "adv_beacon.h"
+#include "ble_host.h"
+#include "diag.h"
+#include "event_store.h"
+#include "ota_l2cap.h"
+#include "ota_update.h"
+#include "temperature_stream.h"
+
+static const char *TAG = "ble_host";
+
+/* 每個連線各自的狀態 */
+typedef struct {
+    bool     in_use;
+    uint16_t conn_handle;
+    uint32_t log_offset;    // 事件紀錄匯出的讀取位置
+    uint8_t  diag_id;       // 診斷 characteristic 選擇的資料 (DIAG_ID_*)
+    bool     paired;        // 連線時沒有對方的綁定資料，本次連線新配對
+    int64_t  connect_time_us;
+    int64_t  encrypt_time_us;   // 加密完成的時間，未加密時為 0
+    int64_t  ready_time_us;     // 第一次存取 OTA / 溫度 service 的時間 (探索服務之後)
+} nimble_conn_t;
+
+static nimble_conn_t conn_tab[BLE_HOST_MAX_CONN];
+static const ble_host_callbacks_t *host_callbacks;
+static int64_t host_start_us;   // ble_host_start() 呼叫的時間，用於量測到開始廣播的耗時
+static uint8_t own_addr_type;
+static uint8_t write_buf[BLE_ATT_ATTR_MAX_LEN];     // 寫入資料攤平，只在 host task 中使用
+static uint8_t read_buf[BLE_ATT_ATTR_MAX_LEN];
+static uint8_t temperature_value[TEMPERATURE_VAL_LEN] = {0x11, 0x22, 0x33, 0x44};
+static uint8_t adv_beacon[ADV_BEACON_LEN];  // 事件摘要 (manufacturer specific data)
+static uint8_t adv_beacon_len;
+
+static uint16_t temperature_handle;
+
+static const ble_uuid128_t ota_service_uuid = BLE_UUID128_INIT(OTA_SERVICE_UUID128);
+static const ble_uuid128_t ota_control_uuid = BLE_UUID128_INIT(OTA_CONTROL_UUID128);
+static const ble_uuid128_t ota_data_uuid = BLE_UUID128_INIT(OTA_DATA_UUID128);
+
+static void advertise(void);
+void ble_store_config_init(void);
+
+static nimble_conn_t *conn_find(uint16_t conn_handle)
+{
+    for (int i = 0; i < BLE_HOST_MAX_CONN; i++) {
+        if (conn_tab[i].in_use && conn_tab[i].conn_handle == conn_handle) {
+            return &conn_tab[i];
+        }
+    }
+    return NULL;
+}
+
+/* 第一次存取 OTA / 溫度 service 時印出連線到開始存取的時間 (包含服務探索與加密) */
+static void conn_ready(uint16_t conn_handle)
+{
+    nimble_conn_t *conn = conn_find(conn_handle);
+    if (conn == NULL || conn->ready_time_us) {
+        return;
+    }
+    conn->ready_time_us = esp_timer_get_time();
+    int64_t ready_ms = (conn->ready_time_us - conn->connect_time_us) / 1000;
+    if (conn->encrypt_time_us) {
+        ESP_LOGI(TAG, "conn %d ready %lld ms after connect (%s keys, encrypted at %lld ms)",
+                 conn_handle, ready_ms, conn->paired ? "new" : "bonded",
+                 (conn->encrypt_time_us - conn->connect_time_us) / 1000);
+    } else {
+        ESP_LOGI(TAG, "conn %d ready %lld ms after connect (not encrypted)", conn_handle, ready_ms);
+    }
+}
+
+static int conn_count(void)
+{
+    int n = 0;
+    for (int i = 0; i < BLE_HOST_MAX_CONN; i++) {
+        n += conn_tab[i].in_use;
+    }
+    return n;
+}
+
+/* 將寫入的資料攤平到 write_buf，長度不在 [min_len, max_len] 時回傳 ATT 錯誤碼 */
+static int write_flat(struct ble_gatt_access_ctxt *ctxt, uint16_t min_len, uint16_t max_len, uint16_t *len)
+{
+    uint16_t om_len = OS_MBUF_PKTLEN(ctxt->om);
+    if (om_len < min_len || om_len > max_len) {
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    if (ble_hs_mbuf_to_flat(ctxt->om, write_buf, sizeof(write_buf), len) != 0) {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+    return 0;
+}
+
+static int ota_control_access(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+    conn_ready(conn_handle);
+    if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        uint8_t value[OTA_CONTROL_VAL_LEN];
+        ota_update_control_value(value);
+        return os_mbuf_append(ctxt->om, value, sizeof(value)) == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    uint16_t len;
+    int rc = write_flat(ctxt, 1, OTA_CONTROL_WRITE_LEN, &len);
+    if (rc == 0 && ota_update_control(conn_handle, write_buf, len) != ESP_OK) {
+        rc = ota_update_get_status(conn_handle);
+    }
+    return rc;
+}
+
+/* 寫入的資料在單一 mbuf 中時直接交給 OTA，分散在多個 mbuf 時才攤平到 write_buf */
+static int ota_data_access(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+    conn_ready(conn_handle);
+    struct os_mbuf *om = ctxt->om;
+    esp_err_t err;
+
+    if (om->om_len == OS_MBUF_PKTLEN(om)) {
+        if (om->om_len == 0 || om->om_len > sizeof(write_buf)) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        err = ota_update_data(conn_handle, om->om_data, om->om_len);
+    } else {
+        uint16_t len;
+        int rc = write_flat(ctxt, 1, sizeof(write_buf), &len);
+        if (rc != 0) {
+            return rc;
+        }
+        ota_update_count_copy(conn_handle, len);
+        err = ota_update_data(conn_handle, write_buf, len);
+    }
+    return err == ESP_OK ? 0 : ota_update_get_status(conn_handle);
+}
+
+static int temperature_access(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+    conn_ready(conn_handle);
+    if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        return os_mbuf_append(ctxt->om, temperature_value, sizeof(temperature_value)) == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    uint16_t len;
+    int rc = write_flat(ctxt, 1, sizeof(temperature_value), &len);
+    if (rc == 0) {
+        memcpy(temperature_value, write_buf, len);
+    }
+    return rc;
+}
+
+/*
+  事件紀錄匯出: 寫入 4 bytes (little endian) 的起始位置，讀取從該位置開始的資料。
+  long read 的 offset 由 NimBLE 從完整的值中截取
+*/
+static int log_export_access(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+    conn_ready(conn_handle);
+    nimble_conn_t *conn = conn_find(conn_handle);
+    if (conn == NULL) {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+    if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        uint16_t len = 0;
+        if (event_store_read(conn->log_offset, read_buf, sizeof(read_buf), &len) != ESP_OK) {
+            return BLE_ATT_ERR_UNLIKELY;
+        }
+        return os_mbuf_append(ctxt->om, read_buf, len) == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    uint16_t len;
+    int rc = write_flat(ctxt, LOG_EXPORT_VAL_LEN, LOG_EXPORT_VAL_LEN, &len);
+    if (rc == 0) {
+        conn->log_offset = write_buf[0] | write_buf[1] << 8 | write_buf[2] << 16 | (uint32_t)write_buf[3] << 24;
+    }
+    return rc;
+}
+
+/* 診斷資料: 寫入 1 byte 的資料編號 (DIAG_ID_*) 後讀取 */
+static int diag_access(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+    conn_ready(conn_handle);
+    nimble_conn_t *conn = conn_find(conn_handle);
+    if (conn == NULL) {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+    if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        size_t len = 0;
+        if (diag_read(conn->diag_id, 0, read_buf, sizeof(read_buf), &len) != ESP_OK) {
+            return BLE_ATT_ERR_ATTR_NOT_FOUND;
+        }
+        return os_mbuf_append(ctxt->om, read_buf, len) == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    uint16_t len;
+    int rc = write_flat(ctxt, DIAG_VAL_LEN, DIAG_VAL_LEN, &len);
+    if (rc == 0) {
+        conn->diag_id = write_buf[0];
+    }
+    return rc;
+}
+
+static const struct ble_gatt_svc_def gatt_svcs[] = {
+    {
+        /* Silicon Labs OTA service */
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = &ota_service_uuid.u,
+        .characteristics = (struct ble_gatt_chr_def[]) {
+            {
+                .uuid = &ota_control_uuid.u,
+                .access_cb = ota_control_access,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+            },
+            {
+                .uuid = &ota_data_uuid.u,
+                .access_cb = ota_data_access,
+                .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP,
+            },
+            { 0 },
+        },
+    },
+    {
+        /* 溫度通知與事件紀錄匯出，CCCD 由 NimBLE 依 NOTIFY/INDICATE 自動加入 */
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = BLE_UUID16_DECLARE(TEMPERATURE_SERVICE_UUID16),
+        .characteristics = (struct ble_gatt_chr_def[]) {
+            {
+                .uuid = BLE_UUID16_DECLARE(TEMPERATURE_CHAR_UUID16),
+                .access_cb = temperature_access,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_NOTIFY | BLE_GATT_CHR_F_INDICATE,
+                .val_handle = &temperature_handle,
+            },
+            {
+                .uuid = BLE_UUID16_DECLARE(LOG_EXPORT_CHAR_UUID16),
+                .access_cb = log_export_access,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+            },
+            {
+                .uuid = BLE_UUID16_DECLARE(DIAG_CHAR_UUID16),
+                .access_cb = diag_access,
+                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+            },
+            { 0 },
+        },
+    },
+    { 0 },
+};
+
+static void conn_connected(uint16_t conn_handle)
+{
+    nimble_conn_t *conn = NULL;
+    for (int i = 0; conn == NULL && i < BLE_HOST_MAX_CONN; i++) {
+        if (!conn_tab[i].in_use) {
+            conn = &conn_tab[i];
+        }
+    }
+    if (conn == NULL) {
+        ESP_LOGW(TAG, "conn %d rejected, too many connections", conn_handle);
+        ble_gap_terminate(conn_handle, BLE_ERR_REM_USER_CONN_TERM);
+        return;
+    }
+    *conn = (nimble_conn_t) {
+        .in_use = true,
+        .conn_handle = conn_handle,
+        .diag_id = DIAG_ID_FLASH_METER,
+        .connect_time_us = esp_timer_get_time(),
+    };
+    struct ble_gap_conn_desc desc;
+    struct ble_store_key_sec key_sec = { 0 };
+    struct ble_store_value_sec value_sec;
+    bool bonded = false;
+    if (ble_gap_conn_find(conn_handle, &desc) == 0) {
+        key_sec.peer_addr = desc.peer_id_addr;
+        bonded = ble_store_read_peer_sec(&key_sec, &value_sec) == 0;
+    }
+    conn->paired = !bonded;
+    host_callbacks->connected(conn_handle);
+    // 連線後協議棧會停止廣播，尚未達到連線上限時繼續廣播讓其他裝置連線
+    if (conn_count() < BLE_HOST_MAX_CONN) {
+        advertise();
+    }
+    struct ble_gap_upd_params conn_params = {
+        .itvl_min = 0x10,               // 0x10*1.25ms = 20ms
+        .itvl_max = 0x20,               // 0x20*1.25ms = 40ms
+        .latency = 0,
+        .supervision_timeout = 1000,    // 1000*10ms = 10s
+    };
+    ble_gap_update_params(conn_handle, &conn_params);
+    // 已綁定的 client 以儲存在 NVS 的密鑰加密；新的 client 不強制配對，由 client 發起時配對並綁定
+    if (bonded) {
+        ble_gap_security_initiate(conn_handle);
+    }
+}
+
+static void conn_disconnected(uint16_t conn_handle)
+{
+    nimble_conn_t *conn = conn_find(conn_handle);
+    temperature_stream_stop(conn_handle);
+    ota_update_conn_close(conn_handle);
+    if (conn == NULL) {
+        return;
+    }
+    conn->in_use = false;
+    int remaining = conn_count();
+    host_callbacks->disconnected(conn_handle, remaining);
+    if (remaining == BLE_HOST_MAX_CONN - 1) {
+        // 原本已達連線上限而停止廣播，重新開始廣播
+        advertise();
+    }
+}
+
+static int gap_event(struct ble_gap_event *event, void *arg)
+{
+    switch (event->type) {
+    case BLE_GAP_EVENT_CONNECT:
+        ESP_LOGI(TAG, "connect, status %d, conn %d", event->connect.status, event->connect.conn_handle);
+        if (event->connect.status != 0) {
+            advertise();
+        } else {
+            conn_connected(event->connect.conn_handle);
+        }
+        break;
+    case BLE_GAP_EVENT_DISCONNECT:
+        ESP_LOGI(TAG, "disconnect, reason 0x%x, conn %d", event->disconnect.reason, event->disconnect.conn.conn_handle);
+        conn_disconnected(event->disconnect.conn.conn_handle);
+        break;
+    case BLE_GAP_EVENT_ENC_CHANGE: {
+        nimble_conn_t *conn = conn_find(event->enc_change.conn_handle);
+        if (event->enc_change.status != 0) {
+            ESP_LOGW(TAG, "conn %d encryption failed, status %d", event->enc_change.conn_handle, event->enc_change.status);
+        } else if (conn) {
+            conn->encrypt_time_us = esp_timer_get_time();
+            ESP_LOGI(TAG, "conn %d encrypted with %s keys", conn->conn_handle, conn->paired ? "new" : "bonded");
+        }
+        break;
+    }
+    case BLE_GAP_EVENT_REPEAT_PAIRING: {
+        // 對方遺失了綁定資料並重新配對: 刪除舊的綁定後重新配對
+        struct ble_gap_conn_desc desc;
+        if (ble_gap_conn_find(event->repeat_pairing.conn_handle, &desc) == 0) {
+            ble_store_util_delete_peer(&desc.peer_id_addr);
+        }
+        nimble_conn_t *conn = conn_find(event->repeat_pairing.conn_handle);
+        if (conn) {
+            conn->paired = true;
+        }
+        return BLE_GAP_REPEAT_PAIRING_RETRY;
+    }
+    case BLE_GAP_EVENT_MTU:
+        ESP_LOGI(TAG, "conn %d MTU %d", event->mtu.conn_handle, event->mtu.value);
+        temperature_stream_set_mtu(event->mtu.conn_handle, event->mtu.value);
+        break;
+    case BLE_GAP_EVENT_SUBSCRIBE:
+        if (event->subscribe.attr_handle != temperature_handle) {
+            break;
+        }
+        conn_ready(event->subscribe.conn_handle);
+        if (event->subscribe.cur_notify || event->subscribe.cur_indicate) {
+            ESP_LOGI(TAG, "conn %d %s enable", event->subscribe.conn_handle, event->subscribe.cur_notify ? "notify" : "indicate");
+            temperature_stream_start(event->subscribe.conn_handle, temperature_handle, !event->subscribe.cur_notify,
+                                     ble_att_mtu(event->subscribe.conn_handle));
+        } else {
+            ESP_LOGI(TAG, "conn %d notify/indicate disable", event->subscribe.conn_handle);
+            temperature_stream_stop(event->subscribe.conn_handle);
+        }
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+/*
+  廣播封包: flags、tx power、事件摘要與裝置名稱 (3 + 3 + 2 + ADV_BEACON_LEN + 2 + 7 = 31 bytes)；
+  掃描回應: OTA service UUID
+*/
+static int set_adv_fields(void)
+{
+    struct ble_hs_adv_fields fields = {
+        .flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP,
+        .tx_pwr_lvl_is_present = 1,
+        .tx_pwr_lvl = BLE_HS_ADV_TX_PWR_LVL_AUTO,
+        .mfg_data = adv_beacon,
+        .mfg_data_len = adv_beacon_len,
+        .name = (const uint8_t *)SAMPLE_DEVICE_NAME,
+        .name_len = strlen(SAMPLE_DEVICE_NAME),
+        .name_is_complete = 1,
+    };
+    return ble_gap_adv_set_fields(&fields);
+}
+
+static void advertise(void)
+{
+    struct ble_hs_adv_fields rsp_fields = {
+        .uuids128 = &ota_service_uuid,
+        .num_uuids128 = 1,
+        .uuids128_is_complete = 1,
+    };
+    struct ble_gap_adv_params adv_params = {
+        .conn_mode = BLE_GAP_CONN_MODE_UND,
+        .disc_mode = BLE_GAP_DISC_MODE_GEN,
+        .itvl_min = 0x20,
+        .itvl_max = 0x40,
+    };
+
+    int rc = set_adv_fields();
+    if (rc == 0) {
+        rc = ble_gap_adv_rsp_set_fields(&rsp_fields);
+    }
+    if (rc == 0) {
+        rc = ble_gap_adv_start(own_addr_type, NULL, BLE_HS_FOREVER, &adv_params, gap_event, NULL);
+    }
+    if (rc != 0 && rc != BLE_HS_EALREADY) {
+        ESP_LOGE(TAG, "advertising start failed, rc = %d", rc);
+        return;
+    }
+    if (host_start_us) {
+        ESP_LOGI(TAG, "%s advertising %lld ms after start", BLE_HOST_NAME, (esp_timer_get_time() - host_start_us) / 1000);
+        host_start_us = 0;
+        if (host_callbacks->advertising) {
+            host_callbacks->advertising();
+        }
+    }
+}
+
+void ble_host_set_adv_beacon(const uint8_t *data, uint8_t len)
+{
+    if (len > sizeof(adv_beacon)) {
+        len = sizeof(adv_beacon);
+    }
+    memcpy(adv_beacon, data, len);
+    adv_beacon_len = len;
+    // 廣播中直接更新廣播封包，不需重新開始廣播；未廣播時在下一次 advertise() 帶入
+    if (ble_hs_synced() && ble_gap_adv_active()) {
+        int rc = set_adv_fields();
+        if (rc != 0) {
+            ESP_LOGE(TAG, "update adv beacon failed, rc = %d", rc);
+        }
+    }
+}
+
+static void on_sync(void)
+{
+    static bool l2cap_started;
+
+    ble_hs_util_ensure_addr(0);
+    ble_hs_id_infer_auto(0, &own_addr_type);
+    // OTA 的 L2CAP CoC 傳輸。host reset 後會再次同步，server 與 SDU pool 仍在，只建立一次
+    if (!l2cap_started) {
+        l2cap_started = true;
+        ota_l2cap_init();
+    }
+    advertise();
+}
+
+static void on_reset(int reason)
+{
+    ESP_LOGE(TAG, "host reset, reason = %d", reason);
+}
+
+static void host_task(void *param)
+{
+    nimble_port_run();
+    nimble_port_freertos_deinit();
+}
+
+esp_err_t ble_host_notify(uint16_t conn_id, uint16_t attr_handle, const uint8_t *data, uint16_t len, bool need_confirm)
+{
+    struct os_mbuf *om = ble_hs_mbuf_from_flat(data, len);
+    if (om == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    int rc = need_confirm ? ble_gatts_indicate_custom(conn_id, attr_handle, om)
+                          : ble_gatts_notify_custom(conn_id, attr_handle, om);
+    if (rc == BLE_HS_ENOMEM || rc == BLE_HS_EALREADY) {
+        // mbuf 用完或上一個 indication 尚未確認
+        return ESP_ERR_NO_MEM;
+    }
+    return rc == 0 ? ESP_OK : ESP_FAIL;
+}
+
+/* NimBLE: nimble_port_init() 同時初始化 controller，廣播在 host 與 controller 同步後開始 */
+esp_err_t ble_host_start(const ble_host_callbacks_t *callbacks)
+{
+    host_callbacks = callbacks;
+    host_start_us = esp_timer_get_time();
+
+    esp_err_t ret = nimble_port_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "nimble port init failed (%s)", esp_err_to_name(ret));
+        return ret;
+    }
+    ble_hs_cfg.sync_cb = on_sync;
+    ble_hs_cfg.reset_cb = on_reset;
+    // 綁定: Just Works 配對，密鑰存到 NVS (CONFIG_BT_NIMBLE_NVS_PERSIST)，重新啟動後仍可使用
+    ble_hs_cfg.store_status_cb = ble_store_util_status_rr;
+    ble_hs_cfg.sm_io_cap = BLE_HS_IO_NO_INPUT_OUTPUT;
+    ble_hs_cfg.sm_bonding = 1;
+    ble_hs_cfg.sm_sc = 1;
+    ble_hs_cfg.sm_our_key_dist = BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID;
+    ble_hs_cfg.sm_their_key_dist = BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID;
+
+    // GATT service 提供 Service Changed；gatt_svcs 固定，每次啟動的 handle 相同
+    ble_svc_gap_init();
+    ble_svc_gatt_init();
+    int rc = ble_gatts_count_cfg(gatt_svcs);
+    if (rc == 0) {
+        rc = ble_gatts_add_svcs(gatt_svcs);
+    }
+    if (rc != 0) {
+        ESP_LOGE(TAG, "add gatt services failed, rc = %d", rc);
+        return ESP_FAIL;
+    }
+    ble_svc_gap_device_name_set(SAMPLE_DEVICE_NAME);
+    ble_att_set_preferred_mtu(GATTS_LOCAL_MTU);
+    ble_store_config_init();
+
+    // 開始定時取樣溫度，待 client 開啟 notify 後送出
+    ret = temperature_stream_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "temperature stream init failed (%s)", esp_err_to_name(ret));
+    }
+
+    nimble_port_freertos_init(host_task);
+    ESP_LOGI(TAG, "%s init %lld ms", BLE_HOST_NAME, (esp_timer_get_time() - host_start_us) / 1000);
+    return ESP_OK;
+}
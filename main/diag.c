@@ -0,0 +1,44 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  診斷資料來源的註冊表，各模組註冊自己的讀取函數，經由溫度 service 的診斷 characteristic 匯出
+*/
+
+#include "diag.h"
+
+typedef struct {
+    uint8_t        id;
+    diag_read_cb_t read;
+} diag_source_t;
+
+static diag_source_t sources[DIAG_MAX_SOURCES];
+
+esp_err_t diag_register(uint8_t id, diag_read_cb_t read)
+{
+    for (int i = 0; i < DIAG_MAX_SOURCES; i++) {
+        if (sources[i].read == NULL || sources[i].id == id) {
+            sources[i].id = id;
+            sources[i].read = read;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t diag_read(uint8_t id, uint32_t offset, uint8_t *buf, size_t cap, size_t *len)
+{
+    for (int i = 0; i < DIAG_MAX_SOURCES && sources[i].read; i++) {
+        if (sources[i].id == id) {
+            *len = sources[i].read(offset, buf, cap);
+            return ESP_OK;
+        }
+    }
+    *len = 0;
+    return ESP_ERR_NOT_FOUND;
+}
@@ -0,0 +1,40 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DIAG_MAX_SOURCES        8
+
+/* 診斷資料編號，client 寫入診斷 characteristic 選擇後讀取 */
+#define DIAG_ID_FLASH_METER     0x01
+#define DIAG_ID_MEM_BUDGET      0x02    // 各階段的 heap 水位 (mem_phase_stats_t 陣列)
+#define DIAG_ID_TASK_PROFILE    0x03    // 各區段 task 剖析快照，格式見 task_profiler.h
+#define DIAG_ID_WAKE_SESSION    0x04    // 各喚醒事件的清醒時間 (wake_session_stats_t 陣列)
+#define DIAG_ID_POWER_STATS     0x05    // 各喚醒狀態累計的時間 (power_stats_t)
+#define DIAG_ID_TEMP_SAMPLER    0x06    // timer 喚醒溫度取樣的統計 (temp_sampler_stats_t)
+#define DIAG_ID_FAST_BOOT       0x07    // 重新啟動到 app_main 的時間與映像驗證耗時 (fast_boot_stats_t)
+
+/* 將診斷資料從 offset 開始最多 cap 位元組寫入 buf，回傳寫入的長度，小於 cap 表示已到結尾 */
+typedef size_t (*diag_read_cb_t)(uint32_t offset, uint8_t *buf, size_t cap);
+
+esp_err_t diag_register(uint8_t id, diag_read_cb_t read);
+
+/* 讀取編號 id 的診斷資料，id 未註冊時回傳 ESP_ERR_NOT_FOUND */
+esp_err_t diag_read(uint8_t id, uint32_t offset, uint8_t *buf, size_t cap, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,232 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  UART 診斷 console: 文字指令由 esp_console 解析與執行，dump 以二進位 frame 直接寫入 UART driver，
+  主機端可在提高 baud rate 後快速取得事件紀錄與各診斷資料
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_vfs_dev.h"
+#include "driver/uart.h"
+#include "diag.h"
+#include "diag_console.h"
+#include "event_store.h"
+#include "flash_meter.h"
+#include "mem_budget.h"
+#include "wake_fsm.h"
+#include "wake_session.h"
+
+#define DIAG_CONSOLE_RX_BUF     1024
+#define DIAG_CONSOLE_TX_BUF     (2 * (DIAG_FRAME_PAYLOAD_MAX + 8))
+#define DIAG_CONSOLE_PROMPT     "diag> "
+
+static const char *TAG = "diag_console";
+
+static uint8_t frame_buf[DIAG_FRAME_PAYLOAD_MAX + 8];
+
+/* CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) */
+static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    while (len--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/* payload 已放在 frame_buf + 6 */
+static void send_frame(uint8_t type, uint16_t seq, uint16_t len)
+{
+    frame_buf[0] = DIAG_FRAME_SOF;
+    frame_buf[1] = type;
+    frame_buf[2] = seq & 0xff;
+    frame_buf[3] = seq >> 8;
+    frame_buf[4] = len & 0xff;
+    frame_buf[5] = len >> 8;
+    uint16_t crc = crc16(0xffff, &frame_buf[1], len + 5);
+    frame_buf[6 + len] = crc & 0xff;
+    frame_buf[7 + len] = crc >> 8;
+    uart_write_bytes(DIAG_CONSOLE_UART, frame_buf, len + 8);
+}
+
+static void send_u32_frame(uint8_t type, uint16_t seq, uint32_t value)
+{
+    uint8_t *p = &frame_buf[6];
+    p[0] = value & 0xff;
+    p[1] = (value >> 8) & 0xff;
+    p[2] = (value >> 16) & 0xff;
+    p[3] = value >> 24;
+    send_frame(type, seq, 4);
+}
+
+static int silent_vprintf(const char *fmt, va_list args)
+{
+    return 0;
+}
+
+static int cmd_dump(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("ERR usage: dump log|<diag id> [offset]\n");
+        return 1;
+    }
+    bool is_log = strcmp(argv[1], "log") == 0;
+    uint8_t id = is_log ? 0 : strtoul(argv[1], NULL, 0);
+    uint32_t offset = argc > 2 ? strtoul(argv[2], NULL, 0) : 0;
+    uint32_t total = 0;
+    uint16_t seq = 0;
+    esp_err_t err = ESP_OK;
+
+    printf("OK\n");
+    fflush(stdout);
+    // frame 之間不能夾雜 log
+    vprintf_like_t prev = esp_log_set_vprintf(silent_vprintf);
+    for (;;) {
+        uint8_t *payload = &frame_buf[6];
+        size_t len = 0;
+        if (is_log) {
+            uint16_t n = 0;
+            err = event_store_read(offset, payload, DIAG_FRAME_PAYLOAD_MAX, &n);
+            len = n;
+        } else {
+            err = diag_read(id, offset, payload, DIAG_FRAME_PAYLOAD_MAX, &len);
+        }
+        if (err != ESP_OK) {
+            send_u32_frame(DIAG_FRAME_ERROR, seq, err);
+            break;
+        }
+        if (len > 0) {
+            send_frame(DIAG_FRAME_DATA, seq++, len);
+            offset += len;
+            total += len;
+        }
+        if (len < DIAG_FRAME_PAYLOAD_MAX) {
+            send_u32_frame(DIAG_FRAME_END, seq, total);
+            break;
+        }
+    }
+    uart_wait_tx_done(DIAG_CONSOLE_UART, portMAX_DELAY);
+    esp_log_set_vprintf(prev);
+    return err == ESP_OK ? 0 : 1;
+}
+
+static int cmd_baud(int argc, char **argv)
+{
+    uint32_t baud = argc > 1 ? strtoul(argv[1], NULL, 0) : 0;
+    if (baud < 9600 || baud > DIAG_CONSOLE_MAX_BAUD) {
+        printf("ERR baud 9600 ~ %d\n", DIAG_CONSOLE_MAX_BAUD);
+        return 1;
+    }
+    printf("OK %lu\n", (unsigned long)baud);
+    fflush(stdout);
+    uart_wait_tx_done(DIAG_CONSOLE_UART, portMAX_DELAY);
+    uart_set_baudrate(DIAG_CONSOLE_UART, baud);
+    return 0;
+}
+
+static int cmd_stats(int argc, char **argv)
+{
+    flash_meter_report();
+    mem_budget_report();
+    wake_session_report();
+    printf("OK\n");
+    return 0;
+}
+
+static int cmd_exit(int argc, char **argv)
+{
+    printf("OK\n");
+    fflush(stdout);
+    uart_wait_tx_done(DIAG_CONSOLE_UART, portMAX_DELAY);
+    wake_fsm_restart();
+    return 0;
+}
+
+static const esp_console_cmd_t commands[] = {
+    { .command = "stats", .help = "Print flash, memory and wake statistics", .func = cmd_stats },
+    { .command = "baud",  .help = "Switch baud rate after OK", .hint = "<rate>", .func = cmd_baud },
+    { .command = "dump",  .help = "Send event log or diag data as binary frames", .hint = "log|<diag id> [offset]", .func = cmd_dump },
+    { .command = "exit",  .help = "Restart and enter light sleep", .func = cmd_exit },
+};
+
+static void console_task(void *arg)
+{
+    char line[DIAG_CONSOLE_LINE_LEN];
+    size_t line_len = 0;
+    int64_t last_input = esp_timer_get_time();
+
+    printf("\n" DIAG_CONSOLE_PROMPT);
+    fflush(stdout);
+    for (;;) {
+        char c;
+        if (uart_read_bytes(DIAG_CONSOLE_UART, &c, 1, pdMS_TO_TICKS(100)) != 1) {
+            if (esp_timer_get_time() - last_input > DIAG_CONSOLE_IDLE_MS * 1000LL) {
+                ESP_LOGI(TAG, "idle, restart");
+                wake_fsm_restart();
+            }
+            continue;
+        }
+        last_input = esp_timer_get_time();
+        if (c != '\r' && c != '\n') {
+            if (line_len < sizeof(line) - 1) {
+                line[line_len++] = c;
+            }
+            continue;
+        }
+        if (line_len == 0) {
+            continue;
+        }
+        line[line_len] = '\0';
+        line_len = 0;
+        int ret;
+        esp_err_t err = esp_console_run(line, &ret);
+        if (err == ESP_ERR_NOT_FOUND) {
+            printf("ERR unknown command\n");
+        } else if (err != ESP_OK) {
+            printf("ERR %s\n", esp_err_to_name(err));
+        }
+        printf(DIAG_CONSOLE_PROMPT);
+        fflush(stdout);
+    }
+}
+
+esp_err_t diag_console_start(void)
+{
+    esp_err_t err = uart_driver_install(DIAG_CONSOLE_UART, DIAG_CONSOLE_RX_BUF, DIAG_CONSOLE_TX_BUF, 0, NULL, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // stdout 改經由 driver，與 frame 使用同一個 TX 緩衝區，順序不會錯亂
+    esp_vfs_dev_uart_use_driver(DIAG_CONSOLE_UART);
+
+    esp_console_config_t console_config = ESP_CONSOLE_CONFIG_DEFAULT();
+    console_config.max_cmdline_length = DIAG_CONSOLE_LINE_LEN;
+    err = esp_console_init(&console_config);
+    if (err != ESP_OK) {
+        return err;
+    }
+    esp_console_register_help_command();
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        esp_console_cmd_register(&commands[i]);
+    }
+    if (xTaskCreate(console_task, "diag_console", DIAG_CONSOLE_STACK, NULL, tskIDLE_PRIORITY + 2, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "console ready on uart %d", DIAG_CONSOLE_UART);
+    return ESP_OK;
+}
@@ -0,0 +1,53 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  UART 診斷 console: UART 喚醒後以文字指令操作，大量資料以二進位 frame 傳送，主機端見 tools/diag_uart_client.py
+
+  指令 (每行一個，回應 "OK ..." 或 "ERR ..."，之後印出提示字元 "diag> "):
+    help                    列出指令
+    stats                   印出 flash、記憶體與喚醒統計
+    baud <rate>             回應 OK 後切換 baud rate (最高 DIAG_CONSOLE_MAX_BAUD)
+    dump log [offset]       以 frame 傳送事件紀錄
+    dump <diag id> [offset] 以 frame 傳送診斷資料 (main/diag.h 的 DIAG_ID_*)
+    exit                    重新啟動並進入 light sleep
+
+  frame (little endian)，dump 時連續送出 DATA，最後送出 END 或 ERROR，傳送期間不輸出 log:
+  | 0xA5 | type (1) | seq (2) | len (2) | payload (len) | crc16 (2) |
+  crc16 為 CRC-16/CCITT-FALSE，計算範圍為 type 到 payload
+    DIAG_FRAME_DATA   payload 為資料
+    DIAG_FRAME_END    payload 為總長度 (4)
+    DIAG_FRAME_ERROR  payload 為 esp_err_t (4)
+*/
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DIAG_CONSOLE_UART           CONFIG_ESP_CONSOLE_UART_NUM
+#define DIAG_CONSOLE_MAX_BAUD       2000000
+#define DIAG_CONSOLE_IDLE_MS        30000   // 沒有輸入超過此時間後重新啟動並進入 light sleep
+#define DIAG_CONSOLE_LINE_LEN       64
+#define DIAG_CONSOLE_STACK          4096
+
+#define DIAG_FRAME_SOF              0xA5
+#define DIAG_FRAME_PAYLOAD_MAX      1024
+#define DIAG_FRAME_DATA             0x01
+#define DIAG_FRAME_END              0x02
+#define DIAG_FRAME_ERROR            0x03
+
+/* 安裝 UART driver、註冊指令並開始處理輸入，閒置 DIAG_CONSOLE_IDLE_MS 後重新啟動 */
+esp_err_t diag_console_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,151 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  重複事件的合併: 溫度比較器在臨界值附近抖動時，每個邊緣都會喚醒、寫入 flash 並重新啟動。
+  同一種事件在 window 內只寫入第一筆，之後的事件只在 RAM 中計數，window 結束後寫入一筆摘要，
+  並暫停該腳位喚醒 EVENT_AGG_HOLDOFF_MS，抖動期間的 flash 寫入與清醒時間都有上限。
+  時間使用系統時間 (gettimeofday)，重新啟動與 light sleep 期間持續計算
+*/
+
+#include <string.h>
+#include <sys/time.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "event_aggregator.h"
+#include "wake_fsm.h"
+
+#define EVENT_AGG_MAGIC         0x45414732  // "EAG2"
+
+static const char *TAG = "event_agg";
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_interval_ms;
+    int64_t  first_ms;
+    int64_t  last_ms;
+    int64_t  holdoff_until_ms;
+} agg_window_t;
+
+typedef struct {
+    uint32_t     magic;
+    agg_window_t windows[EVENT_AGG_TYPES];
+    uint32_t     totals[EVENT_AGG_TYPES];   // 上電後的事件次數，包含合併的事件
+    uint8_t      latest_gpio;
+} agg_store_t;
+
+static __NOINIT_ATTR agg_store_t store;
+static uint8_t held_mask;   // 本次啟動停止喚醒的腳位 (bit 0 為 GPIO 10)
+
+int64_t event_aggregator_now_ms(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+void event_aggregator_init(void)
+{
+    if (store.magic != EVENT_AGG_MAGIC) {
+        // 上電後 RAM 內容無效
+        memset(&store, 0, sizeof(store));
+        store.magic = EVENT_AGG_MAGIC;
+    }
+    int64_t now = event_aggregator_now_ms();
+    for (int i = 0; i < EVENT_AGG_TYPES; i++) {
+        int64_t remaining = store.windows[i].holdoff_until_ms - now;
+        if (remaining <= 0) {
+            continue;
+        }
+        gpio_wakeup_disable(TEMPERATURE_WAKEUP_GPIO1 + i);
+        held_mask |= 1 << i;
+        ESP_LOGI(TAG, "gpio %d wakeup held off for %lld ms", TEMPERATURE_WAKEUP_GPIO1 + i, remaining);
+    }
+}
+
+int64_t event_aggregator_holdoff_ms(void)
+{
+    int64_t now = event_aggregator_now_ms();
+    int64_t rearm_ms = -1;
+    for (int i = 0; i < EVENT_AGG_TYPES; i++) {
+        if (!(held_mask & (1 << i))) {
+            continue;
+        }
+        int64_t remaining = store.windows[i].holdoff_until_ms - now;
+        if (remaining < 0) {
+            remaining = 0;
+        }
+        if (rearm_ms < 0 || remaining < rearm_ms) {
+            rearm_ms = remaining;
+        }
+    }
+    return rearm_ms;
+}
+
+event_agg_action_t event_aggregator_feed(uint8_t gpio)
+{
+    unsigned idx = gpio - TEMPERATURE_WAKEUP_GPIO1;
+    if (idx >= EVENT_AGG_TYPES) {
+        return EVENT_AGG_WRITE;
+    }
+    agg_window_t *w = &store.windows[idx];
+    int64_t now = event_aggregator_now_ms();
+
+    store.totals[idx]++;
+    store.latest_gpio = gpio;
+
+    if (w->count == 0 || now - w->first_ms >= EVENT_AGG_WINDOW_MS) {
+        // 新的 window，前一個 window 的摘要已由 event_aggregator_take() 取出或沒有合併的事件
+        *w = (agg_window_t) {
+            .count = 1,
+            .min_interval_ms = UINT32_MAX,
+            .first_ms = now,
+            .last_ms = now,
+        };
+        return EVENT_AGG_WRITE;
+    }
+    uint32_t interval = now - w->last_ms;
+    if (interval < w->min_interval_ms) {
+        w->min_interval_ms = interval;
+    }
+    w->count++;
+    w->last_ms = now;
+    w->holdoff_until_ms = now + EVENT_AGG_HOLDOFF_MS;
+    ESP_LOGW(TAG, "gpio %u repeated %lu times in %lld ms, folded", gpio, (unsigned long)w->count, now - w->first_ms);
+    return EVENT_AGG_FOLD;
+}
+
+size_t event_aggregator_take(event_agg_summary_t *out, size_t cap, bool all)
+{
+    int64_t now = event_aggregator_now_ms();
+    size_t n = 0;
+
+    for (int i = 0; i < EVENT_AGG_TYPES && n < cap; i++) {
+        agg_window_t *w = &store.windows[i];
+        if (w->count < 2 || (!all && now - w->first_ms < EVENT_AGG_WINDOW_MS)) {
+            continue;
+        }
+        out[n++] = (event_agg_summary_t) {
+            .gpio = TEMPERATURE_WAKEUP_GPIO1 + i,
+            .count = w->count,
+            .min_interval_ms = w->min_interval_ms,
+            .first_ms = w->first_ms,
+            .last_ms = w->last_ms,
+        };
+        // 下一筆事件開始新的 window，hold-off 保留
+        w->count = 0;
+    }
+    return n;
+}
+
+uint8_t event_aggregator_counts(uint32_t totals[EVENT_AGG_TYPES])
+{
+    memcpy(totals, store.totals, sizeof(store.totals));
+    return store.latest_gpio;
+}
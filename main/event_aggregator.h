@@ -0,0 +1,64 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_AGG_WINDOW_MS     60000   // 同一種事件在第一筆之後這段時間內重複，合併為一筆摘要
+#define EVENT_AGG_HOLDOFF_MS    10000   // 事件被合併後，暫停該腳位喚醒的時間
+#define EVENT_AGG_TYPES         5       // GPIO 10 ~ 14
+
+/* 事件的處理方式 */
+typedef enum {
+    EVENT_AGG_WRITE,        // window 內第一筆，立即寫入事件紀錄
+    EVENT_AGG_FOLD,         // 重複的事件，只計數在 RAM，window 結束後寫入摘要
+} event_agg_action_t;
+
+/* 一個 window 內同一種事件的摘要，時間為上電後的毫秒數 */
+typedef struct {
+    uint8_t  gpio;
+    uint32_t count;             // 包含 window 內第一筆
+    uint32_t min_interval_ms;   // 相鄰兩筆的最短間隔
+    int64_t  first_ms;
+    int64_t  last_ms;
+} event_agg_summary_t;
+
+/*
+  開機時在註冊 GPIO 喚醒之後呼叫: 仍在 hold-off 的腳位停止喚醒，平台依 event_aggregator_holdoff_ms()
+  設定 timer 在 hold-off 結束時喚醒，重新啟動後恢復該腳位的喚醒。統計保留在重新啟動後仍保留的 RAM
+*/
+void event_aggregator_init(void);
+
+/* 本次啟動停止喚醒的腳位中最早結束 hold-off 的剩餘時間 (ms)，已結束時為 0，沒有停止喚醒的腳位時為 -1 */
+int64_t event_aggregator_holdoff_ms(void);
+
+/* 記錄 GPIO gpio 的一次事件，回傳是否需要立即寫入事件紀錄 */
+event_agg_action_t event_aggregator_feed(uint8_t gpio);
+
+/* 上電後的毫秒數 (重新啟動後繼續計算)，用於事件紀錄的時間 */
+int64_t event_aggregator_now_ms(void);
+
+/*
+  取出已結束 (或 all 為 true 時全部) 且有合併事件的 window 的摘要，最多 cap 筆，回傳筆數。
+  取出的 window 即清除，寫入事件紀錄失敗時摘要不會保留
+*/
+size_t event_aggregator_take(event_agg_summary_t *out, size_t cap, bool all);
+
+/* 取出上電後每種事件的次數 (包含合併的事件)，回傳最近一次事件的 GPIO，沒有事件時為 0 */
+uint8_t event_aggregator_counts(uint32_t totals[EVENT_AGG_TYPES]);
+
+#ifdef __cplusplus
+}
+#endif
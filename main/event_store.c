@@ -0,0 +1,410 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  事件紀錄儲存，檔案系統後端可選 SPIFFS 或 LittleFS (EVENT_STORE_USE_LITTLEFS)。
+  SPIFFS 掛載時需掃描整個分區，分區越滿掛載與寫入越慢；LittleFS 掛載只讀取 superblock 與 metadata。
+  掛載與寫入的耗時會印在 log 中，可用於比較兩種後端。
+
+  第一次使用時才掛載，之後保持掛載到重新啟動；寫入與匯出的檔案保持開啟，
+  容量資訊在掛載時讀取一次後以寫入量更新，一致性檢查在背景 task 執行，
+  每筆事件只需一次 append。
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "event_store.h"
+#include "flash_meter.h"
+#include "wake_session.h"
+
+static const char *TAG = "event_store";
+
+#if EVENT_STORE_USE_LITTLEFS
+static const event_store_backend_t *backend = &event_store_littlefs;
+#else
+static const event_store_backend_t *backend = &event_store_spiffs;
+#endif
+static bool mounted = false;
+static bool suspended = false;     // 分區內容由 OTA 改寫中，不可掛載
+static bool updating_loaded = false; // 已由 NVS 載入 suspended
+static FILE *append_file;           // 寫入用，保持開啟
+static FILE *read_file;             // 匯出用，保持開啟
+static size_t cached_total, cached_used;
+static TaskHandle_t check_task;
+
+/*
+  讀出整個 data.json 到 *out (呼叫者 free)。沒有紀錄時回傳 ESP_OK 且 *out 為 NULL；
+  超過 EVENT_STORE_MIGRATE_MAX 時回傳 ESP_ERR_INVALID_SIZE (不截斷紀錄)，
+  記憶體不足或讀取不完整時回傳錯誤，都不可再格式化分區
+*/
+static esp_err_t read_log(char **out, size_t *len)
+{
+    struct stat st;
+    *out = NULL;
+    *len = 0;
+    if (stat(EVENT_STORE_FILE, &st) != 0 || st.st_size == 0) {
+        return ESP_OK;
+    }
+    FILE *f = fopen(EVENT_STORE_FILE, "r");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Failed to open %s", EVENT_STORE_FILE);
+        return ESP_FAIL;
+    }
+    size_t size = st.st_size;
+    if (size > EVENT_STORE_MIGRATE_MAX) {
+        ESP_LOGE(TAG, "event log %u bytes exceeds %u bytes", (unsigned)size, (unsigned)EVENT_STORE_MIGRATE_MAX);
+        fclose(f);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    char *buf = malloc(size);
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "no memory for %u bytes of event log", (unsigned)size);
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+    size_t got = fread(buf, 1, size, f);
+    fclose(f);
+    if (got != size) {
+        ESP_LOGE(TAG, "short read of event log (%u of %u bytes)", (unsigned)got, (unsigned)size);
+        free(buf);
+        return ESP_FAIL;
+    }
+    *out = buf;
+    *len = got;
+    return ESP_OK;
+}
+
+/*
+  格式化為 fs 並寫回 read_log() 讀出的紀錄 (fsync 後才回傳)，完成後保持掛載。
+  格式化後開啟、寫入或關閉失敗時紀錄已遺失，回傳錯誤
+*/
+static esp_err_t restore_log(const event_store_backend_t *fs, const char *buf, size_t len)
+{
+    esp_err_t ret = fs->format();
+    if (ret == ESP_OK) {
+        ret = fs->mount(false);
+    }
+    if (ret != ESP_OK || len == 0) {
+        return ret;
+    }
+    FILE *f = fopen(EVENT_STORE_FILE, "w");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Failed to open %s, %u bytes of event log lost", EVENT_STORE_FILE, (unsigned)len);
+        return ESP_FAIL;
+    }
+    bool ok = fwrite(buf, 1, len, f) == len && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to write back %u bytes of event log", (unsigned)len);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+#if EVENT_STORE_USE_LITTLEFS
+/*
+  分區中仍是 SPIFFS 時 (舊韌體寫入的事件紀錄)，將紀錄搬到 LittleFS，*is_spiffs 表示分區是否為 SPIFFS。
+  整個紀錄先讀到 RAM 再格式化分區，搬移途中斷電會遺失這些紀錄；紀錄超過 EVENT_STORE_MIGRATE_MAX
+  時回傳 ESP_ERR_INVALID_SIZE，讀取失敗時回傳錯誤，兩者都不格式化，分區維持 SPIFFS
+*/
+static esp_err_t migrate_from_spiffs(bool *is_spiffs)
+{
+    *is_spiffs = false;
+    esp_err_t ret = event_store_spiffs.mount(false);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    *is_spiffs = true;
+    size_t len;
+    char *buf;
+    ret = read_log(&buf, &len);
+    event_store_spiffs.unmount();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "spiffs migration aborted (%s), partition left unchanged", esp_err_to_name(ret));
+        return ret;
+    }
+    ESP_LOGW(TAG, "migrating %u bytes of event log from spiffs to %s", (unsigned)len, backend->name);
+    ret = restore_log(backend, buf, len);
+    free(buf);
+    return ret;
+}
+#endif
+
+static void check_task_main(void *arg)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = backend->check();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "%s check failed (%s)", backend->name, esp_err_to_name(ret));
+    } else {
+        backend->info(&cached_total, &cached_used);
+        ESP_LOGI(TAG, "%s check done in %lld us", backend->name, esp_timer_get_time() - start);
+    }
+    check_task = NULL;
+    // 喚醒後等待檢查結束才重新啟動
+    wake_session_notify();
+    vTaskDelete(NULL);
+}
+
+bool event_store_busy(void)
+{
+    return check_task != NULL;
+}
+
+esp_err_t event_store_check(void)
+{
+    if (backend->check == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (!mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (check_task) {
+        return ESP_OK;
+    }
+    if (xTaskCreate(check_task_main, "event_check", EVENT_STORE_CHECK_STACK, NULL, tskIDLE_PRIORITY + 1, &check_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/* 載入 OTA 改寫中的標記，沒有標記或 NVS 無法開啟時視為未改寫 */
+static void load_updating(void)
+{
+    nvs_handle_t handle;
+    uint8_t updating = 0;
+
+    esp_err_t ret = nvs_open(EVENT_STORE_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_get_u8(handle, EVENT_STORE_NVS_UPDATING, &updating);
+        nvs_close(handle);
+    }
+    if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND) {
+        // 無法得知分區是否更新到一半，視為更新中 (不掛載、不格式化)，下次掛載時重新讀取
+        ESP_LOGE(TAG, "Failed to load update flag (%s)", esp_err_to_name(ret));
+        suspended = true;
+        return;
+    }
+    // 沒有旗標 (ESP_ERR_NVS_NOT_FOUND) 表示不曾更新過資料分區
+    suspended = ret == ESP_OK && updating;
+    updating_loaded = true;
+}
+
+static esp_err_t save_updating(bool updating)
+{
+    nvs_handle_t handle;
+
+    esp_err_t ret = nvs_open(EVENT_STORE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = nvs_set_u8(handle, EVENT_STORE_NVS_UPDATING, updating);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+esp_err_t event_store_mount(bool format_if_mount_failed)
+{
+    if (mounted) {
+        return ESP_OK;
+    }
+    if (!updating_loaded) {
+        load_updating();
+    }
+    if (suspended) {
+        // 分區內容可能只寫了一部分，掛載失敗時格式化會清除已傳輸的 block
+        ESP_LOGE(TAG, "%s update in progress, not mounted", EVENT_STORE_PARTITION);
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = backend->mount(false);
+#if EVENT_STORE_USE_LITTLEFS
+    if (ret != ESP_OK) {
+        bool is_spiffs;
+        ret = migrate_from_spiffs(&is_spiffs);
+        if (ret == ESP_ERR_INVALID_SIZE) {
+            // 紀錄太大無法整個搬移，繼續使用 SPIFFS，不截斷紀錄
+            ESP_LOGW(TAG, "event log kept on spiffs");
+            backend = &event_store_spiffs;
+            ret = backend->mount(false);
+        }
+        if (ret != ESP_OK && is_spiffs) {
+            // 分區中仍有 SPIFFS 的紀錄，不可格式化
+            return ret;
+        }
+    }
+#endif
+    if (ret != ESP_OK && format_if_mount_failed) {
+        ESP_LOGW(TAG, "%s mount failed (%s), formatting", backend->name, esp_err_to_name(ret));
+        ret = backend->mount(true);
+    }
+    if (ret != ESP_OK) {
+        if (ret == ESP_ERR_NOT_FOUND) {
+            ESP_LOGE(TAG, "Failed to find partition %s", EVENT_STORE_PARTITION);
+        } else {
+            ESP_LOGE(TAG, "Failed to mount %s (%s)", backend->name, esp_err_to_name(ret));
+        }
+        return ret;
+    }
+    mounted = true;
+    ESP_LOGI(TAG, "%s mounted in %lld us", backend->name, esp_timer_get_time() - start);
+
+    ret = backend->info(&cached_total, &cached_used);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to get partition information (%s)", esp_err_to_name(ret));
+    } else {
+        ESP_LOGI(TAG, "Partition size: total: %u, used: %u", (unsigned)cached_total, (unsigned)cached_used);
+    }
+#ifdef CONFIG_EXAMPLE_SPIFFS_CHECK_ON_START
+    event_store_check();
+#else
+    // Check consistency of reported partiton size info.
+    if (ret == ESP_OK && cached_used > cached_total) {
+        ESP_LOGW(TAG, "Number of used bytes cannot be larger than total, checking in background");
+        event_store_check();
+    }
+#endif
+    return ESP_OK;
+}
+
+void event_store_unmount(void)
+{
+    if (!mounted || check_task) {
+        return;
+    }
+    if (append_file) {
+        fclose(append_file);
+        append_file = NULL;
+    }
+    if (read_file) {
+        fclose(read_file);
+        read_file = NULL;
+    }
+    backend->unmount();
+    mounted = false;
+    ESP_LOGI(TAG, "%s unmounted", backend->name);
+}
+
+esp_err_t event_store_suspend(void)
+{
+    if (check_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    event_store_unmount();
+    if (!suspended || !updating_loaded) {
+        // 因讀不到旗標而停用時 NVS 中不一定有旗標，仍需寫入
+        esp_err_t ret = save_updating(true);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to save update flag (%s)", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    suspended = true;
+    updating_loaded = true;
+    return ESP_OK;
+}
+
+esp_err_t event_store_resume(void)
+{
+    esp_err_t ret = save_updating(false);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to clear update flag (%s)", esp_err_to_name(ret));
+        return ret;
+    }
+    suspended = false;
+    updating_loaded = true;
+    return ESP_OK;
+}
+
+esp_err_t event_store_info(size_t *total, size_t *used)
+{
+    if (!mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *total = cached_total;
+    *used = cached_used;
+    return ESP_OK;
+}
+
+esp_err_t event_store_size(uint32_t *size)
+{
+    *size = 0;
+    esp_err_t ret = event_store_mount(false);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    struct stat st;
+    if (stat(EVENT_STORE_FILE, &st) == 0) {
+        *size = st.st_size;
+    }
+    return ESP_OK;
+}
+
+esp_err_t event_store_append(const char *record)
+{
+    esp_err_t err = event_store_mount(true);
+    if (err != ESP_OK) {
+        return err;
+    }
+    int64_t start = esp_timer_get_time();
+    if (append_file == NULL) {
+        append_file = fopen(EVENT_STORE_FILE, "a");
+        if (append_file == NULL) {
+            ESP_LOGE(TAG, "Failed to open file for writing");
+            return ESP_FAIL;
+        }
+    }
+    int ret = fprintf(append_file, "%s\n", record);
+    // 每筆寫入後即寫到 flash，之後可能直接重新啟動
+    if (ret < 0 || fflush(append_file) != 0 || fsync(fileno(append_file)) != 0) {
+        ESP_LOGE(TAG, "Failed to append record");
+        fclose(append_file);
+        append_file = NULL;
+        return ESP_FAIL;
+    }
+    cached_used += ret;
+    flash_meter_logical(EVENT_STORE_PARTITION, ret);
+    ESP_LOGI(TAG, "append %d bytes in %lld us", ret, esp_timer_get_time() - start);
+    return ESP_OK;
+}
+
+esp_err_t event_store_read(uint32_t offset, uint8_t *buf, uint16_t cap, uint16_t *len)
+{
+    *len = 0;
+    // 匯出時不格式化，避免清掉事件紀錄
+    esp_err_t ret = event_store_mount(false);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (read_file == NULL) {
+        read_file = fopen(EVENT_STORE_FILE, "r");
+        if (read_file == NULL) {
+            // 還沒有任何事件紀錄
+            return ESP_OK;
+        }
+    }
+    if (fseek(read_file, offset, SEEK_SET) == 0) {
+        *len = fread(buf, 1, cap, read_file);
+    }
+    // 讀到檔案結尾後清除 EOF，之後 append 的紀錄仍可讀到
+    clearerr(read_file);
+    return ESP_OK;
+}
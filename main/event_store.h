@@ -0,0 +1,102 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "mem_budget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_STORE_USE_LITTLEFS    1                   // 0: SPIFFS, 1: LittleFS
+#define EVENT_STORE_PARTITION       "storage"           // partitions.csv 中的標籤
+#define EVENT_STORE_BASE_PATH       "/storage"
+#define EVENT_STORE_FILE            EVENT_STORE_BASE_PATH "/data.json"
+#define EVENT_STORE_MAX_FILES       5
+#define EVENT_STORE_MIGRATE_MAX     (16 * 1024)         // 可由 SPIFFS 搬移到 LittleFS 的紀錄大小 (整個讀到 RAM)
+#define EVENT_STORE_CHECK_STACK     MEM_BUDGET_CHECK_STACK  // 背景一致性檢查 task 的 stack 大小
+#define EVENT_STORE_NVS_NAMESPACE   "event_store"
+#define EVENT_STORE_NVS_UPDATING    "updating"          // 分區由 OTA 改寫中，傳輸完成前不可掛載
+
+/* 檔案系統後端，掛載在 EVENT_STORE_BASE_PATH，檔案以 POSIX / C 標準函數存取 */
+typedef struct {
+    const char *name;
+    esp_err_t (*mount)(bool format_if_mount_failed);
+    void      (*unmount)(void);
+    esp_err_t (*info)(size_t *total, size_t *used);
+    esp_err_t (*check)(void);                   // 一致性檢查，不支援時為 NULL
+    esp_err_t (*format)(void);
+} event_store_backend_t;
+
+extern const event_store_backend_t event_store_spiffs;
+extern const event_store_backend_t event_store_littlefs;
+
+/*
+  掛載事件紀錄的檔案系統並讀取容量資訊，已掛載時直接回傳，掛載後保持到重新啟動。
+  使用 LittleFS 且分區中仍是 SPIFFS 時，會讀出整個 data.json，格式化為 LittleFS 後寫回 (fsync 後才算完成)；
+  紀錄超過 EVENT_STORE_MIGRATE_MAX 時不搬移，本次啟動繼續以 SPIFFS 掛載；讀取失敗 (記憶體不足或讀取不完整)
+  時回傳錯誤，即使 format_if_mount_failed 也不格式化；格式化後寫回失敗時回傳錯誤 (紀錄已遺失)。
+  容量資訊不合理時在背景執行一致性檢查
+*/
+esp_err_t event_store_mount(bool format_if_mount_failed);
+
+/* 關閉檔案並卸載，背景檢查進行中時不卸載 */
+void event_store_unmount(void);
+
+/*
+  卸載並禁止再次掛載，供 OTA 直接改寫分區內容 (見 ota_data.h)，之後的掛載回傳 ESP_ERR_INVALID_STATE。
+  改寫中的標記存在 NVS，OTA 中止或傳輸中斷後重新啟動仍不掛載 (也不格式化)，直到有一次傳輸完成。
+  背景檢查進行中時回傳 ESP_ERR_INVALID_STATE，標記無法寫入 NVS 時回傳錯誤並維持掛載前的狀態
+*/
+esp_err_t event_store_suspend(void);
+
+/* 分區內容傳輸完成時呼叫，清除 NVS 的標記並允許再次掛載 */
+esp_err_t event_store_resume(void);
+
+/* 回傳掛載時讀取並隨寫入更新的容量資訊，不存取 flash */
+esp_err_t event_store_info(size_t *total, size_t *used);
+
+/* 在背景 task 執行後端的一致性檢查，後端不支援時回傳 ESP_ERR_NOT_SUPPORTED */
+esp_err_t event_store_check(void);
+
+/* 事件紀錄檔的長度，尚未掛載時以不格式化的方式掛載，還沒有紀錄時為 0 */
+esp_err_t event_store_size(uint32_t *size);
+
+/* 背景一致性檢查進行中 */
+bool event_store_busy(void);
+
+/*
+  將一筆 JSON 格式的事件紀錄寫入 buf (建議 MEM_BUDGET_EVENT_RECORD bytes)
+  @return buf 不足時回傳 ESP_ERR_INVALID_SIZE
+*/
+esp_err_t event_store_format(const char *event, int64_t time_ms, char *buf, size_t len);
+
+/*
+  將一段時間內合併的重複事件寫成一筆摘要 (見 event_aggregator.h)，為節省長度不加縮排
+  @return buf 不足時回傳 ESP_ERR_INVALID_SIZE
+*/
+esp_err_t event_store_format_summary(const char *event, int64_t first_ms, int64_t last_ms,
+                                     uint32_t count, uint32_t min_interval_ms, char *buf, size_t len);
+
+/* 在事件紀錄檔尾端加入一筆紀錄 (自動加上換行) 並寫到 flash，尚未掛載時先掛載 (失敗時格式化) */
+esp_err_t event_store_append(const char *record);
+
+/*
+  讀取事件紀錄從 offset 開始最多 cap 位元組，尚未掛載時以不格式化的方式掛載。
+  *len 小於 cap 表示已讀到檔案結尾
+*/
+esp_err_t event_store_read(uint32_t offset, uint8_t *buf, uint16_t cap, uint16_t *len);
+
+#ifdef __cplusplus
+}
+#endif
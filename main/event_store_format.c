@@ -0,0 +1,53 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  事件紀錄的 JSON 格式，cJSON 的配置由 mem_budget 的 pool 提供。
+  與檔案系統分開，主機端的 bench_perf 可直接量測
+*/
+
+#include <stdbool.h>
+#include "cJSON.h"
+#include "event_store.h"
+
+esp_err_t event_store_format(const char *event, int64_t time_ms, char *buf, size_t len)
+{
+    mem_budget_json_begin();
+    cJSON *json_data = cJSON_CreateObject();
+    if (json_data == NULL) {
+        mem_budget_json_end();
+        return ESP_ERR_NO_MEM;
+    }
+    cJSON_AddStringToObject(json_data, "event", event);
+    cJSON_AddNumberToObject(json_data, "time after startup(ms)", time_ms);
+    // 直接輸出到呼叫者的緩衝區，不另外配置字串
+    bool ok = cJSON_PrintPreallocated(json_data, buf, len, true);
+    cJSON_Delete(json_data);
+    mem_budget_json_end();
+    return ok ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+esp_err_t event_store_format_summary(const char *event, int64_t first_ms, int64_t last_ms,
+                                     uint32_t count, uint32_t min_interval_ms, char *buf, size_t len)
+{
+    mem_budget_json_begin();
+    cJSON *json_data = cJSON_CreateObject();
+    if (json_data == NULL) {
+        mem_budget_json_end();
+        return ESP_ERR_NO_MEM;
+    }
+    cJSON_AddStringToObject(json_data, "event", event);
+    cJSON_AddNumberToObject(json_data, "first(ms)", first_ms);
+    cJSON_AddNumberToObject(json_data, "last(ms)", last_ms);
+    cJSON_AddNumberToObject(json_data, "count", count);
+    cJSON_AddNumberToObject(json_data, "min interval(ms)", min_interval_ms);
+    bool ok = cJSON_PrintPreallocated(json_data, buf, len, false);
+    cJSON_Delete(json_data);
+    mem_budget_json_end();
+    return ok ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
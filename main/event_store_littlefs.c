@@ -0,0 +1,50 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  LittleFS 以 copy-on-write 與 metadata 日誌保證斷電後的一致性，掛載時不需掃描整個分區，
+  因此不提供 check
+*/
+
+#include "esp_littlefs.h"
+#include "event_store.h"
+
+static esp_err_t littlefs_mount(bool format_if_mount_failed)
+{
+    esp_vfs_littlefs_conf_t conf = {
+        .base_path = EVENT_STORE_BASE_PATH,
+        .partition_label = EVENT_STORE_PARTITION,
+        .format_if_mount_failed = format_if_mount_failed,
+        .dont_mount = false,
+    };
+    return esp_vfs_littlefs_register(&conf);
+}
+
+static void littlefs_unmount(void)
+{
+    esp_vfs_littlefs_unregister(EVENT_STORE_PARTITION);
+}
+
+static esp_err_t littlefs_info(size_t *total, size_t *used)
+{
+    return esp_littlefs_info(EVENT_STORE_PARTITION, total, used);
+}
+
+static esp_err_t littlefs_format(void)
+{
+    return esp_littlefs_format(EVENT_STORE_PARTITION);
+}
+
+const event_store_backend_t event_store_littlefs = {
+    .name = "littlefs",
+    .mount = littlefs_mount,
+    .unmount = littlefs_unmount,
+    .info = littlefs_info,
+    .check = NULL,
+    .format = littlefs_format,
+};
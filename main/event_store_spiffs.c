@@ -0,0 +1,51 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "esp_spiffs.h"
+#include "event_store.h"
+
+static esp_err_t spiffs_mount(bool format_if_mount_failed)
+{
+    esp_vfs_spiffs_conf_t conf = {
+      .base_path = EVENT_STORE_BASE_PATH,
+      .partition_label = EVENT_STORE_PARTITION,
+      .max_files = EVENT_STORE_MAX_FILES,
+      .format_if_mount_failed = format_if_mount_failed
+    };
+    return esp_vfs_spiffs_register(&conf);
+}
+
+static void spiffs_unmount(void)
+{
+    esp_vfs_spiffs_unregister(EVENT_STORE_PARTITION);
+}
+
+static esp_err_t spiffs_info(size_t *total, size_t *used)
+{
+    return esp_spiffs_info(EVENT_STORE_PARTITION, total, used);
+}
+
+static esp_err_t spiffs_check(void)
+{
+    // More info at https://github.com/pellepl/spiffs/wiki/FAQ#powerlosses-contd-when-should-i-run-spiffs_check
+    return esp_spiffs_check(EVENT_STORE_PARTITION);
+}
+
+static esp_err_t spiffs_format(void)
+{
+    return esp_spiffs_format(EVENT_STORE_PARTITION);
+}
+
+const event_store_backend_t event_store_spiffs = {
+    .name = "spiffs",
+    .mount = spiffs_mount,
+    .unmount = spiffs_unmount,
+    .info = spiffs_info,
+    .check = spiffs_check,
+    .format = spiffs_format,
+};
@@ -0,0 +1,209 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdbool.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_image_format.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_private/esp_clk.h"
+#include "nvs.h"
+#include "diag.h"
+#include "fast_boot.h"
+
+#define FAST_BOOT_MAGIC     0x46424f54  // "FBOT"
+#define FAST_BOOT_NVS_KEY   "verified"
+
+static const char *TAG = "fast_boot";
+
+/* 已完整驗證的映像，以分區位置與 ELF SHA-256 辨識 */
+typedef struct {
+    uint32_t address;
+    uint8_t  elf_sha256[32];
+} verified_image_t;
+
+typedef struct {
+    uint32_t          magic;
+    uint64_t          restart_rtc_us;   // esp_restart() 時的 RTC 時間 (軟體重新啟動不會清除 RTC 計時)，0 表示沒有
+    bool              verified_valid;   // verified 有效，斷電後由 NVS 載入
+    verified_image_t  verified;
+    fast_boot_stats_t stats;
+} fast_boot_store_t;
+
+static __NOINIT_ATTR fast_boot_store_t store;
+
+static size_t fast_boot_diag_read(uint32_t offset, uint8_t *buf, size_t cap)
+{
+    if (offset >= sizeof(store.stats)) {
+        return 0;
+    }
+    size_t len = sizeof(store.stats) - offset;
+    if (len > cap) {
+        len = cap;
+    }
+    memcpy(buf, (const uint8_t *)&store.stats + offset, len);
+    return len;
+}
+
+/* esp_restart() 的 shutdown handler，記錄重新啟動的時間 */
+static void fast_boot_shutdown(void)
+{
+    store.restart_rtc_us = esp_clk_rtc_time();
+}
+
+static void load_verified(void)
+{
+    nvs_handle_t handle;
+    size_t size = sizeof(store.verified);
+
+    if (nvs_open(FAST_BOOT_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    store.verified_valid = nvs_get_blob(handle, FAST_BOOT_NVS_KEY, &store.verified, &size) == ESP_OK &&
+                           size == sizeof(store.verified);
+    nvs_close(handle);
+}
+
+static esp_err_t save_verified(const esp_partition_t *part, const uint8_t *elf_sha256)
+{
+    nvs_handle_t handle;
+
+    store.verified.address = part->address;
+    memcpy(store.verified.elf_sha256, elf_sha256, sizeof(store.verified.elf_sha256));
+    store.verified_valid = true;
+
+    esp_err_t ret = nvs_open(FAST_BOOT_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "nvs open failed (%s), %s verified until power off", esp_err_to_name(ret), part->label);
+        return ret;
+    }
+    ret = nvs_set_blob(handle, FAST_BOOT_NVS_KEY, &store.verified, sizeof(store.verified));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+static bool image_verified(const esp_partition_t *part, const esp_app_desc_t *desc)
+{
+    if (!store.verified_valid) {
+        load_verified();
+    }
+    return store.verified_valid && store.verified.address == part->address &&
+           memcmp(store.verified.elf_sha256, desc->app_elf_sha256, sizeof(store.verified.elf_sha256)) == 0;
+}
+
+esp_err_t fast_boot_init(void)
+{
+    uint64_t now = esp_clk_rtc_time();
+    fast_boot_stats_t *stats = &store.stats;
+
+    if (store.magic != FAST_BOOT_MAGIC) {
+        // 上電後 RAM 內容無效
+        memset(&store, 0, sizeof(store));
+        store.magic = FAST_BOOT_MAGIC;
+        stats->min_us = UINT32_MAX;
+    } else if (store.restart_rtc_us && esp_reset_reason() == ESP_RST_SW && now > store.restart_rtc_us) {
+        uint32_t us = now - store.restart_rtc_us;
+        stats->boots++;
+        stats->last_us = us;
+        stats->total_us += us;
+        if (us < stats->min_us) {
+            stats->min_us = us;
+        }
+        if (us > stats->max_us) {
+            stats->max_us = us;
+        }
+    }
+    store.restart_rtc_us = 0;
+    ESP_ERROR_CHECK(esp_register_shutdown_handler(fast_boot_shutdown));
+    return diag_register(DIAG_ID_FAST_BOOT, fast_boot_diag_read);
+}
+
+/* 目前映像在 otadata 的狀態，以纜線燒錄時 otadata 沒有這個分區的紀錄，為 UNDEFINED */
+static esp_ota_img_states_t running_state(void)
+{
+    esp_ota_img_states_t state = ESP_OTA_IMG_UNDEFINED;
+    esp_ota_get_state_partition(esp_ota_get_running_partition(), &state);
+    return state;
+}
+
+void fast_boot_verify(void)
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    const esp_app_desc_t *desc = esp_app_get_description();
+    esp_ota_img_states_t state = running_state();
+
+    if (!image_verified(running, desc)) {
+        esp_partition_pos_t pos = {
+            .offset = running->address,
+            .size = running->size,
+        };
+        esp_image_metadata_t data;
+        int64_t start = esp_timer_get_time();
+        esp_err_t err = esp_image_verify(ESP_IMAGE_VERIFY, &pos, &data);
+        store.stats.verify_us = esp_timer_get_time() - start;
+        store.stats.verifies++;
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "%s image verify failed (%s)", running->label, esp_err_to_name(err));
+            if (state == ESP_OTA_IMG_PENDING_VERIFY) {
+                esp_ota_mark_app_invalid_rollback_and_reboot();
+            }
+            // 沒有可回復的 app，照常執行，下次啟動再驗證
+            return;
+        }
+        ESP_LOGI(TAG, "%s image verified in %lu us", running->label, (unsigned long)store.stats.verify_us);
+        save_verified(running, desc->app_elf_sha256);
+    }
+}
+
+bool fast_boot_pending(void)
+{
+    return running_state() == ESP_OTA_IMG_PENDING_VERIFY;
+}
+
+void fast_boot_confirm(void)
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+
+    if (fast_boot_pending()) {
+        esp_err_t err = esp_ota_mark_app_valid_cancel_rollback();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "mark %s valid failed (%s)", running->label, esp_err_to_name(err));
+        } else {
+            ESP_LOGI(TAG, "%s marked valid, rollback cancelled", running->label);
+        }
+    }
+}
+
+esp_err_t fast_boot_record_verified(const esp_partition_t *part)
+{
+    esp_app_desc_t desc;
+    esp_err_t err = esp_ota_get_partition_description(part, &desc);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return save_verified(part, desc.app_elf_sha256);
+}
+
+void fast_boot_report(void)
+{
+    const fast_boot_stats_t *stats = &store.stats;
+    if (stats->boots == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "restart to app_main: %lu boots, avg %lu us, min %lu us, max %lu us, last %lu us; "
+             "image verify %lu us (%lu times)",
+             (unsigned long)stats->boots, (unsigned long)(stats->total_us / stats->boots),
+             (unsigned long)stats->min_us, (unsigned long)stats->max_us, (unsigned long)stats->last_us,
+             (unsigned long)stats->verify_us, (unsigned long)stats->verifies);
+}
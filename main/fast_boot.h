@@ -0,0 +1,71 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  快速啟動: 每次事件與藍芽斷線後都會重新啟動，bootloader 設為不驗證 app 映像
+  (CONFIG_BOOTLOADER_SKIP_VALIDATE_ALWAYS)，改為每個映像只完整驗證一次並記錄:
+  OTA 結束時由 esp_ota_end() 驗證，以纜線燒錄的映像在第一次啟動時驗證。
+  新的 OTA 映像仍由 otadata 保護 (CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE)，第一次開始藍芽廣播後才標記為有效，
+  在此之前重新啟動或驗證失敗時回到上一個 app，確保新的映像仍能再次 OTA。
+  這兩項 bootloader 設定只在以纜線重新燒錄 bootloader 後生效，只以 OTA 更新的設備沒有這兩項功能
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FAST_BOOT_NVS_NAMESPACE     "fast_boot"
+
+/* 啟動時間統計，重新啟動後保留，斷電後清除 */
+typedef struct {
+    uint32_t boots;             // 量測到的軟體重新啟動次數
+    uint32_t last_us;           // 最近一次由 esp_restart() 到 app_main 的時間
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t verifies;          // app 完整驗證的次數
+    uint32_t verify_us;         // 最近一次完整驗證的耗時，約為 bootloader 每次啟動省下的時間
+} fast_boot_stats_t;
+
+/*
+  app_main 開頭 (flash_meter_init() 之後) 呼叫，計算上次 esp_restart() 到現在的時間，
+  以 DIAG_ID_FAST_BOOT 提供統計 (fast_boot_stats_t)
+*/
+esp_err_t fast_boot_init(void);
+
+/*
+  初始化完成、第一次進入 light sleep 前呼叫: 目前的映像尚未驗證時完整驗證一次並記錄，
+  驗證失敗且可 rollback 時回到上一個 app。不標記映像為有效 (見 fast_boot_confirm())
+*/
+void fast_boot_verify(void);
+
+/* 目前的映像是新的 OTA 映像 (otadata 為 PENDING_VERIFY)，尚未標記為有效，重新啟動會回到上一個 app */
+bool fast_boot_pending(void);
+
+/*
+  第一次開始藍芽廣播後呼叫: 目前的映像為 PENDING_VERIFY 時標記為有效並取消 rollback，
+  其他狀態不做任何事
+*/
+void fast_boot_confirm(void);
+
+/* esp_ota_end() 驗證通過後呼叫，記錄 part 中的映像已驗證，重新啟動後不再驗證。需已 nvs_flash_init() */
+esp_err_t fast_boot_record_verified(const esp_partition_t *part);
+
+/* 印出啟動時間與驗證耗時 */
+void fast_boot_report(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,214 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  flash 寫入量與抹除次數計量
+
+  以 linker 的 --wrap (見 CMakeLists.txt) 攔截 esp_partition_write、esp_partition_write_raw 與
+  esp_partition_erase_range，OTA (esp_ota_*)、SPIFFS / LittleFS 與 NVS 都經由這些函數存取 flash，
+  因此不需修改各元件即可依分區統計實際寫入的資料量、抹除的 sector 數與耗時。
+*/
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "diag.h"
+#include "flash_meter.h"
+
+#define FLASH_METER_MAGIC       0x464d5452  // "FMTR"
+#define FLASH_METER_NVS_KEY     "totals"
+
+static const char *TAG = "flash_meter";
+
+typedef struct {
+    uint32_t            magic;
+    flash_meter_entry_t entries[FLASH_METER_MAX_PARTS];
+} flash_meter_t;
+
+static portMUX_TYPE meter_lock = portMUX_INITIALIZER_UNLOCKED;
+static __NOINIT_ATTR flash_meter_t meter;
+
+esp_err_t __real_esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size);
+esp_err_t __real_esp_partition_write_raw(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size);
+esp_err_t __real_esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+/* 需在 meter_lock 中呼叫，找不到時配置新的項目，已滿時回傳 NULL */
+static flash_meter_entry_t *find_entry(const char *label)
+{
+    for (int i = 0; i < FLASH_METER_MAX_PARTS; i++) {
+        flash_meter_entry_t *entry = &meter.entries[i];
+        if (entry->label[0] == '\0') {
+            strncpy(entry->label, label, FLASH_METER_LABEL_LEN - 1);
+            return entry;
+        }
+        if (strncmp(entry->label, label, FLASH_METER_LABEL_LEN - 1) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void meter_add(const esp_partition_t *partition, uint32_t programmed, uint32_t erased, int64_t busy_us)
+{
+    taskENTER_CRITICAL(&meter_lock);
+    if (meter.magic != FLASH_METER_MAGIC) {
+        // flash_meter_init() 之前的寫入
+        memset(&meter, 0, sizeof(meter));
+        meter.magic = FLASH_METER_MAGIC;
+    }
+    flash_meter_entry_t *entry = find_entry(partition->label);
+    if (entry) {
+        entry->programmed_bytes += programmed;
+        entry->erased_sectors += erased;
+        entry->busy_us += busy_us;
+        if (programmed) {
+            entry->write_calls++;
+        }
+    }
+    taskEXIT_CRITICAL(&meter_lock);
+}
+
+esp_err_t __wrap_esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = __real_esp_partition_write(partition, dst_offset, src, size);
+    if (err == ESP_OK) {
+        meter_add(partition, size, 0, esp_timer_get_time() - start);
+    }
+    return err;
+}
+
+esp_err_t __wrap_esp_partition_write_raw(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = __real_esp_partition_write_raw(partition, dst_offset, src, size);
+    if (err == ESP_OK) {
+        meter_add(partition, size, 0, esp_timer_get_time() - start);
+    }
+    return err;
+}
+
+esp_err_t __wrap_esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = __real_esp_partition_erase_range(partition, offset, size);
+    if (err == ESP_OK) {
+        meter_add(partition, 0, size / partition->erase_size, esp_timer_get_time() - start);
+    }
+    return err;
+}
+
+void flash_meter_logical(const char *label, uint32_t bytes)
+{
+    taskENTER_CRITICAL(&meter_lock);
+    flash_meter_entry_t *entry = find_entry(label);
+    if (entry) {
+        entry->logical_bytes += bytes;
+    }
+    taskEXIT_CRITICAL(&meter_lock);
+}
+
+/* 將 NVS 中上次儲存的累計值加到目前的統計 */
+static void load_totals(void)
+{
+    static flash_meter_entry_t saved[FLASH_METER_MAX_PARTS];
+    size_t size = sizeof(saved);
+    nvs_handle_t handle;
+
+    if (nvs_open(FLASH_METER_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    esp_err_t err = nvs_get_blob(handle, FLASH_METER_NVS_KEY, saved, &size);
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        return;
+    }
+    taskENTER_CRITICAL(&meter_lock);
+    for (int i = 0; i < size / sizeof(saved[0]) && saved[i].label[0]; i++) {
+        flash_meter_entry_t *entry = find_entry(saved[i].label);
+        if (entry) {
+            entry->logical_bytes += saved[i].logical_bytes;
+            entry->programmed_bytes += saved[i].programmed_bytes;
+            entry->erased_sectors += saved[i].erased_sectors;
+            entry->write_calls += saved[i].write_calls;
+            entry->busy_us += saved[i].busy_us;
+        }
+    }
+    taskEXIT_CRITICAL(&meter_lock);
+}
+
+static size_t flash_meter_diag_read(uint32_t offset, uint8_t *buf, size_t cap)
+{
+    if (offset >= sizeof(meter.entries)) {
+        return 0;
+    }
+    size_t len = sizeof(meter.entries) - offset;
+    if (len > cap) {
+        len = cap;
+    }
+    taskENTER_CRITICAL(&meter_lock);
+    memcpy(buf, (const uint8_t *)meter.entries + offset, len);
+    taskEXIT_CRITICAL(&meter_lock);
+    return len;
+}
+
+esp_err_t flash_meter_init(void)
+{
+    diag_register(DIAG_ID_FLASH_METER, flash_meter_diag_read);
+    if (meter.magic == FLASH_METER_MAGIC) {
+        return ESP_OK;
+    }
+    // 上電後 RAM 內容無效，由 NVS 載入 (初始化 NVS 的寫入也會計入)
+    taskENTER_CRITICAL(&meter_lock);
+    memset(&meter, 0, sizeof(meter));
+    meter.magic = FLASH_METER_MAGIC;
+    taskEXIT_CRITICAL(&meter_lock);
+
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_OK) {
+        load_totals();
+    } else {
+        ESP_LOGW(TAG, "nvs init failed (%s), totals start from zero", esp_err_to_name(ret));
+    }
+    return ESP_OK;
+}
+
+esp_err_t flash_meter_save(void)
+{
+    static flash_meter_entry_t snapshot[FLASH_METER_MAX_PARTS];
+    nvs_handle_t handle;
+
+    esp_err_t ret = nvs_open(FLASH_METER_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    taskENTER_CRITICAL(&meter_lock);
+    memcpy(snapshot, meter.entries, sizeof(snapshot));
+    taskEXIT_CRITICAL(&meter_lock);
+    ret = nvs_set_blob(handle, FLASH_METER_NVS_KEY, snapshot, sizeof(snapshot));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+void flash_meter_report(void)
+{
+    for (int i = 0; i < FLASH_METER_MAX_PARTS && meter.entries[i].label[0]; i++) {
+        const flash_meter_entry_t *entry = &meter.entries[i];
+        ESP_LOGI(TAG, "%-8s logical %lu, programmed %lu, erased %lu sectors, %lu writes, %llu ms",
+                 entry->label, (unsigned long)entry->logical_bytes, (unsigned long)entry->programmed_bytes,
+                 (unsigned long)entry->erased_sectors, (unsigned long)entry->write_calls, entry->busy_us / 1000);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FLASH_METER_MAX_PARTS       8
+#define FLASH_METER_LABEL_LEN       16
+#define FLASH_METER_NVS_NAMESPACE   "flash_meter"
+
+/*
+  每個分區的累計統計，也是診斷資料 DIAG_ID_FLASH_METER 的格式 (little endian，依序排列)。
+  write amplification = programmed_bytes / logical_bytes
+*/
+typedef struct {
+    char     label[FLASH_METER_LABEL_LEN];
+    uint64_t busy_us;           // 寫入與抹除耗時
+    uint32_t logical_bytes;     // 上層 (OTA、事件紀錄) 要求寫入的資料量
+    uint32_t programmed_bytes;  // 實際寫入 flash 的資料量
+    uint32_t erased_sectors;
+    uint32_t write_calls;
+} flash_meter_entry_t;
+
+/*
+  app_main 開頭呼叫。統計保存在重新啟動後仍保留的 RAM，斷電後 (RAM 內容無效) 由 NVS 載入
+*/
+esp_err_t flash_meter_init(void);
+
+/* 上層記錄要求寫入的資料量，用於計算 write amplification */
+void flash_meter_logical(const char *label, uint32_t bytes);
+
+/* 將統計存到 NVS，需已 nvs_flash_init() */
+esp_err_t flash_meter_save(void);
+
+/* 印出各分區的統計 */
+void flash_meter_report(void);
+
+#ifdef __cplusplus
+}
+#endif
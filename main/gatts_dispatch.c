@@ -0,0 +1,61 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  attribute handle 對應處理函數的查表，建立屬性表時建立一次，之後每個 GATT 事件只需一次查表，
+  不會因為 service 或 characteristic 增加而變慢
+*/
+
+#include <string.h>
+#include "esp_log.h"
+#include "gatts_dispatch.h"
+
+static const char *TAG = "gatts_dispatch";
+
+/* handle -> attr_ops 的索引，0 表示未註冊 (索引從 1 開始) */
+static uint8_t handle_index[GATTS_DISPATCH_MAX_HANDLE];
+static gatts_attr_ops_t attr_ops[GATTS_DISPATCH_MAX_ATTRS + 1];
+static uint8_t attr_num;
+
+esp_err_t gatts_dispatch_register(const uint16_t *handles, const gatts_attr_ops_t *ops, uint16_t num)
+{
+    for (uint16_t i = 0; i < num; i++) {
+        if (ops[i].write == NULL && ops[i].read == NULL) {
+            continue;
+        }
+        if (handles[i] >= GATTS_DISPATCH_MAX_HANDLE) {
+            ESP_LOGE(TAG, "handle %d out of range", handles[i]);
+            return ESP_ERR_INVALID_ARG;
+        }
+        uint8_t idx = handle_index[handles[i]];
+        if (idx == 0) {
+            if (attr_num == GATTS_DISPATCH_MAX_ATTRS) {
+                ESP_LOGE(TAG, "dispatch table full");
+                return ESP_ERR_NO_MEM;
+            }
+            idx = ++attr_num;
+            handle_index[handles[i]] = idx;
+        }
+        attr_ops[idx] = ops[i];
+    }
+    return ESP_OK;
+}
+
+void gatts_dispatch_reset(void)
+{
+    memset(handle_index, 0, sizeof(handle_index));
+    attr_num = 0;
+}
+
+const gatts_attr_ops_t *gatts_dispatch_lookup(uint16_t handle)
+{
+    if (handle >= GATTS_DISPATCH_MAX_HANDLE || handle_index[handle] == 0) {
+        return NULL;
+    }
+    return &attr_ops[handle_index[handle]];
+}
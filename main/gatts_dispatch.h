@@ -0,0 +1,51 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_gatts_api.h"
+#include "ble_conn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GATTS_DISPATCH_MAX_HANDLE   256     // 可查表的 attribute handle 上限
+#define GATTS_DISPATCH_MAX_ATTRS    32      // 可註冊處理函數的 attribute 數
+
+/* 處理 ESP_GATTS_WRITE_EVT (非長寫入)，回傳值用於 need_rsp 時的回應 */
+typedef esp_gatt_status_t (*gatts_write_cb_t)(esp_gatt_if_t gatts_if, ble_conn_t *conn,
+                                              esp_ble_gatts_cb_param_t *param, void *ctx);
+
+/* 處理 ESP_GATTS_READ_EVT，需要回應時由處理函數自行呼叫 esp_ble_gatts_send_response() */
+typedef void (*gatts_read_cb_t)(esp_gatt_if_t gatts_if, ble_conn_t *conn,
+                                esp_ble_gatts_cb_param_t *param, void *ctx);
+
+typedef struct {
+    gatts_write_cb_t write;
+    gatts_read_cb_t  read;
+    void            *ctx;
+} gatts_attr_ops_t;
+
+/*
+  ESP_GATTS_CREAT_ATTR_TAB_EVT 時呼叫，handles 與 ops 以同一個屬性索引 (例如 IDX_CHAR_VAL_A) 對應，
+  ops 中 write 與 read 皆為 NULL 的屬性不會佔用表格
+*/
+esp_err_t gatts_dispatch_register(const uint16_t *handles, const gatts_attr_ops_t *ops, uint16_t num);
+
+/* 清除所有註冊 */
+void gatts_dispatch_reset(void);
+
+/* 以 handle 直接查表，沒有註冊時回傳 NULL */
+const gatts_attr_ops_t *gatts_dispatch_lookup(uint16_t handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,287 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  notification/indication 送出佇列
+
+  - 每個連線各自一個 FIFO，封包資料放在所有連線共用的 pool 中
+  - Bluedroid 對每個 esp_ble_gatts_send_indicate() 都會回報一次 ESP_GATTS_CONF_EVT
+    (notification 在交給 L2CAP 後、indication 在收到 client 確認後)，因此 FIFO 前段
+    inflight 個封包即為已送出、等待 CONF 的封包
+  - notification 最多同時 GATTS_SEND_QUEUE_WINDOW 個在途，indication 一次只送一個
+  - 收到 ESP_GATTS_CONGEST_EVT (congested = true) 時暫停，解除壅塞後繼續送
+*/
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "gatts_send_queue.h"
+
+#define GATTS_SEND_QUEUE_WINDOW     4
+
+static const char *TAG = "send_queue";
+
+typedef struct {
+    bool          in_use;
+    bool          need_confirm;
+    esp_gatt_if_t gatts_if;
+    uint8_t       retries;
+    uint16_t      attr_handle;
+    uint16_t      len;
+    uint8_t       data[GATTS_SEND_QUEUE_MAX_LEN];
+} send_slot_t;
+
+typedef struct {
+    bool     in_use;
+    bool     congested;
+    bool     ind_inflight;  // 有一個 indication 在等待確認
+    uint16_t conn_id;
+    uint8_t  fifo[GATTS_SEND_QUEUE_POOL_SIZE];
+    uint8_t  head;
+    uint8_t  count;
+    uint8_t  inflight;
+    gatts_send_queue_stats_t stats;
+} send_conn_t;
+
+static send_slot_t slot_pool[GATTS_SEND_QUEUE_POOL_SIZE];
+static send_conn_t conn_tab[GATTS_SEND_QUEUE_MAX_CONN];
+static SemaphoreHandle_t queue_mutex;
+static esp_timer_handle_t retry_timer;
+
+static send_conn_t *find_conn(uint16_t conn_id)
+{
+    for (int i = 0; i < GATTS_SEND_QUEUE_MAX_CONN; i++) {
+        if (conn_tab[i].in_use && conn_tab[i].conn_id == conn_id) {
+            return &conn_tab[i];
+        }
+    }
+    return NULL;
+}
+
+static uint8_t fifo_at(const send_conn_t *conn, uint8_t pos)
+{
+    return conn->fifo[(conn->head + pos) % GATTS_SEND_QUEUE_POOL_SIZE];
+}
+
+/* 移除 FIFO 中第 pos 個封包並釋放其 slot */
+static void fifo_remove(send_conn_t *conn, uint8_t pos)
+{
+    slot_pool[fifo_at(conn, pos)].in_use = false;
+    for (uint8_t i = pos; i + 1 < conn->count; i++) {
+        conn->fifo[(conn->head + i) % GATTS_SEND_QUEUE_POOL_SIZE] = fifo_at(conn, i + 1);
+    }
+    conn->count--;
+    conn->stats.depth = conn->count;
+}
+
+static void fifo_pop(send_conn_t *conn)
+{
+    slot_pool[fifo_at(conn, 0)].in_use = false;
+    conn->head = (conn->head + 1) % GATTS_SEND_QUEUE_POOL_SIZE;
+    conn->count--;
+    conn->stats.depth = conn->count;
+}
+
+/* 在不壅塞且在途數量允許時送出待送封包，呼叫前需持有 queue_mutex */
+static void conn_pump(send_conn_t *conn)
+{
+    while (conn->count > conn->inflight && !conn->congested && !conn->ind_inflight
+           && conn->inflight < GATTS_SEND_QUEUE_WINDOW) {
+        send_slot_t *slot = &slot_pool[fifo_at(conn, conn->inflight)];
+        if (slot->need_confirm && conn->inflight > 0) {
+            // indication 等前面的 notification 都完成後再送
+            break;
+        }
+        esp_err_t ret = esp_ble_gatts_send_indicate(slot->gatts_if, conn->conn_id, slot->attr_handle,
+                                                    slot->len, slot->data, slot->need_confirm);
+        if (ret != ESP_OK) {
+            if (++slot->retries > GATTS_SEND_QUEUE_MAX_RETRY) {
+                ESP_LOGW(TAG, "conn %d drop packet for handle %d (%s)", conn->conn_id, slot->attr_handle, esp_err_to_name(ret));
+                fifo_remove(conn, conn->inflight);
+                conn->stats.dropped++;
+                continue;
+            }
+            conn->stats.retries++;
+            if (!esp_timer_is_active(retry_timer)) {
+                esp_timer_start_once(retry_timer, GATTS_SEND_QUEUE_RETRY_MS * 1000);
+            }
+            break;
+        }
+        conn->inflight++;
+        conn->ind_inflight = slot->need_confirm;
+    }
+}
+
+static void retry_timer_cb(void *arg)
+{
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+    for (int i = 0; i < GATTS_SEND_QUEUE_MAX_CONN; i++) {
+        if (conn_tab[i].in_use) {
+            conn_pump(&conn_tab[i]);
+        }
+    }
+    xSemaphoreGive(queue_mutex);
+}
+
+static void handle_conf(uint16_t conn_id, esp_gatt_status_t status)
+{
+    send_conn_t *conn = find_conn(conn_id);
+    if (conn == NULL || conn->inflight == 0) {
+        return;
+    }
+    send_slot_t *slot = &slot_pool[fifo_at(conn, 0)];
+    conn->inflight--;
+    if (slot->need_confirm) {
+        conn->ind_inflight = false;
+    }
+
+    // ESP_GATT_CONGESTED 表示封包已交給 L2CAP，但鏈路目前壅塞
+    if (status == ESP_GATT_OK || status == ESP_GATT_CONGESTED) {
+        conn->stats.sent++;
+        fifo_pop(conn);
+    } else if (slot->need_confirm && ++slot->retries <= GATTS_SEND_QUEUE_MAX_RETRY) {
+        // indication 發送時在途只有它一個，留在 FIFO 頭等待重送
+        conn->stats.retries++;
+    } else {
+        ESP_LOGW(TAG, "conn %d packet for handle %d failed, status 0x%x", conn_id, slot->attr_handle, status);
+        conn->stats.dropped++;
+        fifo_pop(conn);
+    }
+    conn_pump(conn);
+}
+
+esp_err_t gatts_send_queue_init(void)
+{
+    if (queue_mutex != NULL) {
+        return ESP_OK;
+    }
+    queue_mutex = xSemaphoreCreateMutex();
+    if (queue_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    const esp_timer_create_args_t retry_args = {
+        .callback = retry_timer_cb,
+        .name = "send_retry",
+    };
+    return esp_timer_create(&retry_args, &retry_timer);
+}
+
+void gatts_send_queue_conn_open(uint16_t conn_id)
+{
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+    send_conn_t *conn = find_conn(conn_id);
+    for (int i = 0; conn == NULL && i < GATTS_SEND_QUEUE_MAX_CONN; i++) {
+        if (!conn_tab[i].in_use) {
+            conn = &conn_tab[i];
+        }
+    }
+    if (conn != NULL) {
+        memset(conn, 0, sizeof(*conn));
+        conn->in_use = true;
+        conn->conn_id = conn_id;
+    } else {
+        ESP_LOGE(TAG, "no free queue for conn %d", conn_id);
+    }
+    xSemaphoreGive(queue_mutex);
+}
+
+void gatts_send_queue_conn_close(uint16_t conn_id)
+{
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+    send_conn_t *conn = find_conn(conn_id);
+    if (conn != NULL) {
+        conn->stats.dropped += conn->count;
+        while (conn->count > 0) {
+            fifo_pop(conn);
+        }
+        ESP_LOGI(TAG, "conn %d closed: queued %lu, sent %lu, dropped %lu, retries %lu, congested %lu, max depth %u",
+                 conn_id, conn->stats.queued, conn->stats.sent, conn->stats.dropped, conn->stats.retries,
+                 conn->stats.congested, conn->stats.max_depth);
+        conn->in_use = false;
+    }
+    xSemaphoreGive(queue_mutex);
+}
+
+esp_err_t gatts_send_queue_push(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                const uint8_t *data, uint16_t len, bool need_confirm)
+{
+    if (len > GATTS_SEND_QUEUE_MAX_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+    send_conn_t *conn = find_conn(conn_id);
+    send_slot_t *slot = NULL;
+    for (int i = 0; conn != NULL && i < GATTS_SEND_QUEUE_POOL_SIZE; i++) {
+        if (!slot_pool[i].in_use) {
+            slot = &slot_pool[i];
+            conn->fifo[(conn->head + conn->count) % GATTS_SEND_QUEUE_POOL_SIZE] = i;
+            break;
+        }
+    }
+    if (conn == NULL) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else if (slot == NULL) {
+        conn->stats.dropped++;
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        slot->in_use = true;
+        slot->gatts_if = gatts_if;
+        slot->attr_handle = attr_handle;
+        slot->need_confirm = need_confirm;
+        slot->retries = 0;
+        slot->len = len;
+        memcpy(slot->data, data, len);
+        conn->count++;
+        conn->stats.queued++;
+        conn->stats.depth = conn->count;
+        if (conn->count > conn->stats.max_depth) {
+            conn->stats.max_depth = conn->count;
+        }
+        conn_pump(conn);
+    }
+    xSemaphoreGive(queue_mutex);
+    return ret;
+}
+
+void gatts_send_queue_handle_event(esp_gatts_cb_event_t event, esp_ble_gatts_cb_param_t *param)
+{
+    if (event != ESP_GATTS_CONGEST_EVT && event != ESP_GATTS_CONF_EVT) {
+        return;
+    }
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+    if (event == ESP_GATTS_CONGEST_EVT) {
+        send_conn_t *conn = find_conn(param->congest.conn_id);
+        if (conn != NULL) {
+            conn->congested = param->congest.congested;
+            if (conn->congested) {
+                conn->stats.congested++;
+            } else {
+                conn_pump(conn);
+            }
+        }
+    } else {
+        handle_conf(param->conf.conn_id, param->conf.status);
+    }
+    xSemaphoreGive(queue_mutex);
+}
+
+esp_err_t gatts_send_queue_get_stats(uint16_t conn_id, gatts_send_queue_stats_t *stats)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(queue_mutex, portMAX_DELAY);
+    send_conn_t *conn = find_conn(conn_id);
+    if (conn != NULL) {
+        *stats = conn->stats;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(queue_mutex);
+    return ret;
+}
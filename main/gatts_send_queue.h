@@ -0,0 +1,57 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_gatts_api.h"
+#include "mem_budget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GATTS_SEND_QUEUE_MAX_CONN       CONFIG_BT_ACL_CONNECTIONS
+#define GATTS_SEND_QUEUE_POOL_SIZE      MEM_BUDGET_SEND_QUEUE_PACKETS   // 所有連線共用的待送封包數
+#define GATTS_SEND_QUEUE_MAX_LEN        (ESP_GATT_MAX_MTU_SIZE - 3)
+#define GATTS_SEND_QUEUE_MAX_RETRY      3       // 送出失敗或 indication 未確認時的重送次數
+#define GATTS_SEND_QUEUE_RETRY_MS       20
+
+typedef struct {
+    uint32_t queued;        // 成功排入佇列的封包數
+    uint32_t sent;          // 交給協議棧的封包數 (indication 則為收到確認的數量)
+    uint32_t dropped;       // 佇列已滿、超過重送次數或斷線時丟棄的封包數
+    uint32_t retries;       // 重送次數
+    uint32_t congested;     // 收到 ESP_GATTS_CONGEST_EVT (congested = true) 的次數
+    uint8_t  depth;         // 目前佇列深度
+    uint8_t  max_depth;     // 佇列深度的最大值
+} gatts_send_queue_stats_t;
+
+esp_err_t gatts_send_queue_init(void);
+
+/* ESP_GATTS_CONNECT_EVT / ESP_GATTS_DISCONNECT_EVT 時呼叫，斷線時丟棄該連線尚未送出的封包 */
+void gatts_send_queue_conn_open(uint16_t conn_id);
+void gatts_send_queue_conn_close(uint16_t conn_id);
+
+/*
+  將 notification (need_confirm = false) 或 indication (need_confirm = true) 排入佇列
+  @return ESP_ERR_NO_MEM 表示佇列已滿，封包被丟棄
+*/
+esp_err_t gatts_send_queue_push(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                const uint8_t *data, uint16_t len, bool need_confirm);
+
+/* 處理 ESP_GATTS_CONGEST_EVT 與 ESP_GATTS_CONF_EVT，其餘事件忽略 */
+void gatts_send_queue_handle_event(esp_gatts_cb_event_t event, esp_ble_gatts_cb_param_t *param);
+
+esp_err_t gatts_send_queue_get_stats(uint16_t conn_id, gatts_send_queue_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -22,7 +22,6 @@
 #include "freertos/event_groups.h"
 #include "esp_system.h"
 #include "esp_log.h"
-#include "nvs_flash.h"
 #include "esp_bt.h"
 
 #include "esp_gap_ble_api.h"
@@ -30,74 +29,46 @@
 #include "esp_bt_main.h"
 #include "gatts_table_creat_demo.h"
 #include "esp_gatt_common_api.h"
+#include "esp_timer.h"
+#include "ble_host.h"
+#include "adv_beacon.h"
 
 // for ota 
-#include "esp_ota_ops.h"
-#include "esp_flash_partitions.h"
-#include "esp_partition.h"
-#include "errno.h"
-
-// for light sleep
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-#include <time.h>
-#include <sys/time.h>
-#include "driver/uart.h"
-#include "esp_sleep.h"
-#include "esp_timer.h"
-#include "light_sleep_example.h"
+#include "ota_update.h"
+#include "ota_l2cap.h"
+#include "prepare_write.h"
 
-// for spiffs
-#include <sys/unistd.h>
-#include <sys/stat.h>
-#include "esp_err.h"
-#include "esp_spiffs.h"
+// for multiple connections
+#include "ble_conn.h"
+#include "gatts_dispatch.h"
+#include "event_store.h"
+#include "diag.h"
 
-// for json
-#include "cJSON.h"
+// for temperature notification
+#include "gatts_send_queue.h"
+#include "temperature_stream.h"
 
 #define GATTS_TABLE_TAG "GATTS_TABLE_DEMO"
 
 #define PROFILE_NUM                 1
 #define PROFILE_APP_IDX             0
 #define ESP_APP_ID                  0x55
-#define SAMPLE_DEVICE_NAME          "OTA-BLE"
-#define SVC_INST_ID                 0
-#define SVC_INST_ID1                1 // add the instance id of the service for new service
 
-/* 
-   The max length of characteristic value. When the GATT client performs a write or prepare write  
-   operation, the data length must be less than GATTS_DEMO_CHAR_VAL_LEN_MAX.
-*/
-#define GATTS_DEMO_CHAR_VAL_LEN_MAX 500
-#define PREPARE_BUF_MAX_SIZE        1024
+#define OTA_DATA_PREPARE_CAPACITY   2048 // OTA Data 長寫入可接受的長度
+#define BOND_LIST_MAX               15   // Bluedroid 綁定紀錄的上限 (BTM_SEC_MAX_DEVICE_RECORDS)
 #define CHAR_DECLARATION_SIZE       (sizeof(uint8_t))
 
 #define ADV_CONFIG_FLAG             (1 << 0)
 #define SCAN_RSP_CONFIG_FLAG        (1 << 1)
 
-#define BLE_WAKEUP_GPIO                   9
-#define TEMPERATURE_WAKEUP_GPIO1          10
-#define TEMPERATURE_WAKEUP_GPIO2          11
-#define TEMPERATURE_WAKEUP_GPIO3          12
-#define LOW_BATTERY_WAKEUP_GPIO           13
-#define DEVICE_ABNORMAL_WAKEUP_GPIO       14
-
 static uint8_t adv_config_done       = 0;
 
-uint16_t ota_handle_table[HRS_IDX_NB];
-uint16_t temperature_handle_table[HRS_IDX_NB2];// add the handle table for new service
-
-static uint8_t wakeup_gpio;
-
-/* 為了處理長特徵值寫入，定義並實例化了一個準備緩衝區結構 */
-typedef struct {
-    uint8_t                 *prepare_buf;
-    int                     prepare_len;
-} prepare_type_env_t;
+static const ble_host_callbacks_t *host_callbacks;
+static int64_t host_start_us;           // ble_host_start() 呼叫的時間，用於量測到開始廣播的耗時
 
-static prepare_type_env_t prepare_write_env;
+/* 每個 service 的 handle 表 (ota_handle_table、temperature_handle_table)，以屬性索引取得 handle */
+#define SCHEMA_HANDLE_TABLE(name, schema, idx_nb, on_created)   uint16_t name##_handle_table[idx_nb];
+GATTS_SERVICE_LIST(SCHEMA_HANDLE_TABLE)
 
 //#define CONFIG_SET_RAW_ADV_DATA
 // 直接定義廣播封包與廣播掃描回應封包內容
@@ -122,14 +93,6 @@ static uint8_t raw_scan_rsp_data[] = {
 };
 
 #else
-esp_err_t err;
-/* 
-   update handle : set by esp_ota_begin(), must be freed via esp_ota_end(); esp_ota_begin()回傳的hundle，後續用於esp_ota_write()和esp_ota_end() 
-*/
-esp_ota_handle_t update_handle = 0 ;
-/*update_partition: 要進行放置更新韌體的分區*/
-const esp_partition_t *update_partition = NULL;
-	
 // 利用參數設定來產生廣播封包與廣播掃描回應封包內容
 /*
    Type: com.silabs.service.ota
@@ -140,7 +103,7 @@ static uint8_t service_uuid[16] = {
     /* LSB <--------------------------------------------------------------------------------> MSB */
     // first uuid, 16bit, [12],[13] is the value
     //0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00,
-    0xf0, 0x19, 0x21, 0xb4, 0x47, 0x8f, 0xa4, 0xbf, 0xa1, 0x4f, 0x63, 0xfd, 0xee, 0xd6, 0x14, 0x1d,
+    OTA_SERVICE_UUID128,
 };
 
 /*
@@ -149,7 +112,7 @@ static uint8_t service_uuid[16] = {
    Silicon Labs OTA Control.
    Property requirements: 
 	   Notify - Excluded
-	   Read - Excluded
+	   Read - Excluded (本專案開放讀取 OTA 中止的狀態碼)
 	   Write Without Response - Excluded
 	   Write - Mandatory
 	   Reliable write - Excluded
@@ -160,7 +123,7 @@ static uint8_t char_ota_control_uuid[16] = {
     /* LSB <--------------------------------------------------------------------------------> MSB */
     // first uuid, 16bit, [12],[13] is the value
     //0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00,
-    0x63, 0x60, 0x32, 0xe0, 0x37, 0x5e, 0xa4, 0x88, 0x53, 0x4e, 0x6d, 0xfb, 0x64, 0x35, 0xbf, 0xf7,
+    OTA_CONTROL_UUID128,
 };
 
 
@@ -181,24 +144,32 @@ static uint8_t char_ota_data_uuid[16] = {
     /* LSB <--------------------------------------------------------------------------------> MSB */
     // first uuid, 16bit, [12],[13] is the value
     //0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00,
-    0x53, 0xa1, 0x81, 0x1f, 0x58, 0x2c, 0xd0, 0xa5, 0x45, 0x40, 0xfc, 0x34, 0xf3, 0x27, 0x42, 0x98,
+    OTA_DATA_UUID128,
 };
 
+static uint8_t adv_beacon[ADV_BEACON_LEN];   // 事件摘要 (manufacturer specific data)
+static bool adv_configured;                 // 已設定過廣播封包
+static uint8_t beacon_refresh;              // 廣播中更新廣播封包的次數，設定完成後不需重新開始廣播
+
 // 定义BLE广播中的广播数据
-/* The length of adv data must be less than 31 bytes */
+/*
+  The length of adv data must be less than 31 bytes
+  flags (3) + tx power (3) + 事件摘要 (2 + ADV_BEACON_LEN) + 裝置名稱 (2 + 7) = 31 bytes，
+  OTA service UUID 與連線間隔放在掃描回應
+*/
 static esp_ble_adv_data_t adv_data = {
     .set_scan_rsp        = false,// 是否为扫描响应数据，这里设置为广播数据
     .include_name        = true,// 是否包含设备名称
     .include_txpower     = true,// 是否包含广播信号强度值
-    .min_interval        = 0x0006,// 从设备在两次广播之间最短的时间间隔，单位为 1.25 毫秒，这里设置为 7.5 毫秒
-    .max_interval        = 0x0010,// 从设备在两次广播之间最长的时间间隔，单位为 1.25 毫秒，这里设置为 20 毫秒
+    .min_interval        = 0x0000,// 连接间隔放在扫描响应
+    .max_interval        = 0x0000,
     .appearance          = 0x00,// 设备外观，这里设置为默认值 0
-    .manufacturer_len    = 0,// 厂商数据长度，这里设置为 0，TEST_MANUFACTURER_DATA_LEN,
-    .p_manufacturer_data = NULL,// 厂商数据指针，这里设置为 NULL
+    .manufacturer_len    = 0,// 厂商数据长度，由 ble_host_set_adv_beacon() 设置
+    .p_manufacturer_data = adv_beacon,// 厂商数据指针，事件摘要
     .service_data_len    = 0,// 服务数据长度，这里设置为 0
     .p_service_data      = NULL,// 服务数据指针，这里设置为 NULL
-    .service_uuid_len    = sizeof(service_uuid),// 服务 UUID 长度，这里设置为Silicon Labs OTA service UUID的长度
-    .p_service_uuid      = service_uuid,// 服务 UUID 指针，这里设置为Silicon Labs OTA service UUID
+    .service_uuid_len    = 0,// 服务 UUID 放在扫描响应
+    .p_service_uuid      = NULL,
     .flag = (ESP_BLE_ADV_FLAG_GEN_DISC | ESP_BLE_ADV_FLAG_BREDR_NOT_SPT),// 广播标志，这里设置为一般发现模式和不支持 BR/EDR
 };
 
@@ -206,10 +177,10 @@ static esp_ble_adv_data_t adv_data = {
 // scan response data
 static esp_ble_adv_data_t scan_rsp_data = {
     .set_scan_rsp        = true,// 标记这个结构体是否用于扫描响应数据（true 为扫描响应数据，false 为广播数据）
-    .include_name        = true,// 是否在广播中包含设备名
-    .include_txpower     = true,// 是否在广播中包含发送功率
-    .min_interval        = 0x0006,
-    .max_interval        = 0x0010,
+    .include_name        = false,// 设备名已在广播数据中
+    .include_txpower     = false,// 发送功率已在广播数据中
+    .min_interval        = 0x0006,// 从设备在两次广播之间最短的时间间隔，单位为 1.25 毫秒，这里设置为 7.5 毫秒
+    .max_interval        = 0x0010,// 从设备在两次广播之间最长的时间间隔，单位为 1.25 毫秒，这里设置为 20 毫秒
     .appearance          = 0x00,// 设备的外观类别
     .manufacturer_len    = 0,// 制造商数据的长度（单位为字节）
     .p_manufacturer_data = NULL,// 指向包含制造商
@@ -217,7 +188,7 @@ static esp_ble_adv_data_t scan_rsp_data = {
     .p_service_data      = NULL,
     .service_uuid_len    = sizeof(service_uuid),// 服务 UUID 长度，这里设置为Silicon Labs OTA service UUID的长度
     .p_service_uuid      = service_uuid,// 服务 UUID 指针，这里设置为Silicon Labs OTA service UUID
-    .flag = (ESP_BLE_ADV_FLAG_GEN_DISC | ESP_BLE_ADV_FLAG_BREDR_NOT_SPT),// 广播标志，可以指定多个广播标志（如通用发现标志和 BR/EDR 不支持标志）。
+    .flag                = 0,// 扫描响应不需要广播标志
 };
 #endif /* CONFIG_SET_RAW_ADV_DATA */
 
@@ -266,9 +237,10 @@ static struct gatts_profile_inst heart_rate_profile_tab[PROFILE_NUM] = {
 };
 
 /* Service */
-static const uint16_t GATTS_SERVICE_UUID_TEST2      = 0x00EE;// add the service uuid for new service
-static const uint16_t GATTS_CHAR_UUID_TEST_A2       = 0xEE01;// add the characteristic uuid for new service's characteristic A2
-static const uint16_t GATTS_CHAR_UUID_TEST_B2       = 0xEE02;// add the characteristic uuid for new service's characteristic B2
+static const uint16_t GATTS_SERVICE_UUID_TEST2      = TEMPERATURE_SERVICE_UUID16;// add the service uuid for new service
+static const uint16_t GATTS_CHAR_UUID_TEST_A2       = TEMPERATURE_CHAR_UUID16;// add the characteristic uuid for new service's characteristic A2
+static const uint16_t GATTS_CHAR_UUID_TEST_B2       = LOG_EXPORT_CHAR_UUID16;// add the characteristic uuid for new service's characteristic B2
+static const uint16_t GATTS_CHAR_UUID_DIAG          = DIAG_CHAR_UUID16;// 診斷資料 (flash 計量等)
 
 static const uint16_t primary_service_uuid         = ESP_GATT_UUID_PRI_SERVICE;
 static const uint16_t character_declaration_uuid   = ESP_GATT_UUID_CHAR_DECLARE;
@@ -279,87 +251,48 @@ ESP_GATT_CHAR_PROP_BIT_WRITE;// add this for new service's characteristic B2
 static const uint8_t char_prop_write_writenorsp    =  ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_WRITE_NR;
 static const uint8_t temperature_measurement_ccc[2]      = {0x00, 0x00};// add this for new service's characteristic A2
 static const uint8_t char_value[4]                 = {0x11, 0x22, 0x33, 0x44};
-
-bool create_tab = false;// add this for new service
-
-/* Full Database Description - Used to add attributes into the database */
-/* 透過定義esp_gatts_attr_db_t類型的數組來定義GATT服務 */
-static const esp_gatts_attr_db_t gatt_db[HRS_IDX_NB] =
-{
-    // Service Declaration
-    /*
-       [IDX_SVC]: 屬性索引
-       ESP_GATT_AUTO_RSP: BLE堆棧在讀取或寫入事件到達時自動進行響應
-       ESP_UUID_LEN_16: UUID長度設置為16-bit
-       (uint8_t *)&primary_service_uuid: 將服務標示為主要服務的UUID(0x2800)
-       ESP_GATT_PERM_READ: 服務的讀取權限
-       sizeof(service_uuid): 服務UUID的最大長度，此處為Silicon Labs OTA service UUID的長度
-       sizeof(service_uuid): 當前服務長度設置為Silicon Labs OTA service UUID的長度
-       (uint8_t *)&service_uuid: 服務屬性值設置為Silicon Labs OTA service UUID
-    */
-    [IDX_SVC]        =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&primary_service_uuid, ESP_GATT_PERM_READ,
-      sizeof(service_uuid), sizeof(service_uuid), (uint8_t *)&service_uuid}},
-
-    /* Characteristic Declaration */
-    [IDX_CHAR_A]     =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
-      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_write_writenorsp}},
-
-    /* Characteristic Value */
-    [IDX_CHAR_VAL_A] =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_128, (uint8_t *)&char_ota_control_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
-      GATTS_DEMO_CHAR_VAL_LEN_MAX, sizeof(char_value), (uint8_t *)char_value}},
-
-
-    /* Characteristic Declaration */
-    [IDX_CHAR_B]      =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,
-      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_write_writenorsp}},
-
-    /* Characteristic Value */
-    [IDX_CHAR_VAL_B]  =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_128, (uint8_t *)&char_ota_data_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
-      GATTS_DEMO_CHAR_VAL_LEN_MAX, sizeof(char_value), (uint8_t *)char_value}},
-
-};
+static const uint8_t ota_control_value[OTA_CONTROL_VAL_LEN] = {OTA_STATUS_OK, OTA_TRANSPORT_GATT};
+static const uint8_t diag_id_value[1]              = {DIAG_ID_FLASH_METER};
 
 /*
-  the new service
+  由 gatts_table_creat_demo.h 的服務定義展開屬性表
+  ESP_GATT_AUTO_RSP: BLE堆棧在讀取或寫入事件到達時自動進行響應
+  服務宣告的屬性值為服務 UUID，特徵宣告的屬性值為特徵屬性 (property)，
+  特徵值的儲存空間大小為 max_len，寫入超過 max_len 時堆棧回應 ESP_GATT_INVALID_ATTR_LEN
 */
-static const esp_gatts_attr_db_t gatt_db2[HRS_IDX_NB2] = 
-{
-    // Service Declaration
-    [IDX_SVC2]        =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&primary_service_uuid, ESP_GATT_PERM_READ, 
-      sizeof(uint16_t), sizeof(GATTS_SERVICE_UUID_TEST2), (uint8_t *)&GATTS_SERVICE_UUID_TEST2}},
-
-    /* Characteristic Declaration */
-    [IDX_CHAR_A2]     =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ,   
-      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_read_write_notify}},
-
-    /* Characteristic Value */
-    [IDX_CHAR_VAL_A2] =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&GATTS_CHAR_UUID_TEST_A2, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, 
-      GATTS_DEMO_CHAR_VAL_LEN_MAX, sizeof(char_value), (uint8_t *)char_value}},
-
-    /* Client Characteristic Configuration Descriptor */
-    [IDX_CHAR_CFG_A2]  =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_client_config_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
-      sizeof(uint16_t), sizeof(temperature_measurement_ccc), (uint8_t *)temperature_measurement_ccc}},
-
-    /* Characteristic Declaration */
-    [IDX_CHAR_B2]      =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ, 
-      CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&char_prop_read_write}},
-
-    /* Characteristic Value */
-    [IDX_CHAR_VAL_B2]  =
-    {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&GATTS_CHAR_UUID_TEST_B2, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, 
-      GATTS_DEMO_CHAR_VAL_LEN_MAX, sizeof(char_value), (uint8_t *)char_value}},
+#define SCHEMA_ATTR_SVC(idx, uuid)                                                                  \
+    [idx] = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&primary_service_uuid, ESP_GATT_PERM_READ, \
+             sizeof(uuid), sizeof(uuid), (uint8_t *)&uuid}},
+#define SCHEMA_ATTR_CHAR(decl_idx, val_idx, uuid, prop, perm, rsp, max_len, value, on_write, on_read) \
+    [decl_idx] = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid, ESP_GATT_PERM_READ, \
+                  CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE, (uint8_t *)&prop}},                 \
+    [val_idx] = {{rsp}, {sizeof(uuid), (uint8_t *)&uuid, perm, max_len, sizeof(value), (uint8_t *)&value}},
+#define SCHEMA_ATTR_DESCR(idx, uuid, perm, rsp, max_len, value, on_write, on_read)                  \
+    [idx] = {{rsp}, {sizeof(uuid), (uint8_t *)&uuid, perm, max_len, sizeof(value), (uint8_t *)&value}},
+
+/* 編譯時檢查 UUID 長度與初始值長度 */
+#define SCHEMA_CHECK_UUID(idx, uuid)                                                                \
+    _Static_assert(sizeof(uuid) == ESP_UUID_LEN_16 || sizeof(uuid) == ESP_UUID_LEN_128, #idx " uuid length");
+#define SCHEMA_CHECK_CHAR(decl_idx, val_idx, uuid, prop, perm, rsp, max_len, value, on_write, on_read) \
+    SCHEMA_CHECK_UUID(val_idx, uuid)                                                                \
+    _Static_assert(sizeof(value) <= (max_len), #val_idx " initial value exceeds max length");
+#define SCHEMA_CHECK_DESCR(idx, uuid, perm, rsp, max_len, value, on_write, on_read)                 \
+    SCHEMA_CHECK_UUID(idx, uuid)                                                                    \
+    _Static_assert(sizeof(value) <= (max_len), #idx " initial value exceeds max length");
+
+#define SCHEMA_CHECK_SERVICE(name, schema, idx_nb, on_created)                                     \
+    schema(SCHEMA_CHECK_UUID, SCHEMA_CHECK_CHAR, SCHEMA_CHECK_DESCR)
+
+GATTS_SERVICE_LIST(SCHEMA_CHECK_SERVICE)
 
-};
+/* Full Database Description - Used to add attributes into the database */
+/* 透過定義esp_gatts_attr_db_t類型的數組來定義GATT服務 (ota_attr_db、temperature_attr_db) */
+#define SCHEMA_ATTR_SERVICE(name, schema, idx_nb, on_created)                                      \
+    static const esp_gatts_attr_db_t name##_attr_db[idx_nb] = {                                     \
+        schema(SCHEMA_ATTR_SVC, SCHEMA_ATTR_CHAR, SCHEMA_ATTR_DESCR)                                \
+    };
+
+GATTS_SERVICE_LIST(SCHEMA_ATTR_SERVICE)
 
 /*
   处理 BLE GAP事件
@@ -390,6 +323,11 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
         //广播数据设置完成事件标志
         case ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT:
         // 表示广播数据设置完毕的事件
+            if (beacon_refresh) {
+                // 广播中更新事件摘要，广播不需重新开始
+                beacon_refresh--;
+                break;
+            }
             adv_config_done &= (~ADV_CONFIG_FLAG);
             if (adv_config_done == 0){
                 // 启用广播
@@ -413,6 +351,14 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
                 ESP_LOGE(GATTS_TABLE_TAG, "advertising start failed");
             }else{
                 ESP_LOGI(GATTS_TABLE_TAG, "advertising start successfully");
+                if (host_start_us) {
+                    ESP_LOGI("ble_host", "%s advertising %lld ms after start", BLE_HOST_NAME,
+                             (esp_timer_get_time() - host_start_us) / 1000);
+                    host_start_us = 0;
+                    if (host_callbacks->advertising) {
+                        host_callbacks->advertising();
+                    }
+                }
             }
             break;
         //停止广播事件标志
@@ -436,85 +382,303 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
                   param->update_conn_params.latency,
                   param->update_conn_params.timeout);
             break;
+        // 对方发起配对，无输入输出能力时直接接受 (Just Works)
+        case ESP_GAP_BLE_SEC_REQ_EVT:
+            esp_ble_gap_security_rsp(param->ble_security.ble_req.bd_addr, true);
+            break;
+        // 配对时交换的密钥，已绑定的设备重新连线时只加密，不会收到此事件
+        case ESP_GAP_BLE_KEY_EVT:{
+            ble_conn_t *conn = ble_conn_find_bda(param->ble_security.ble_key.bd_addr);
+            if (conn){
+                conn->paired = true;
+            }
+        }
+            break;
+        // 配对或以绑定的密钥加密完成
+        case ESP_GAP_BLE_AUTH_CMPL_EVT:{
+            ble_conn_t *conn = ble_conn_find_bda(param->ble_security.auth_cmpl.bd_addr);
+            if (!param->ble_security.auth_cmpl.success){
+                ESP_LOGW(GATTS_TABLE_TAG, "authentication failed, reason 0x%x", param->ble_security.auth_cmpl.fail_reason);
+            }else if (conn){
+                conn->encrypt_time_us = esp_timer_get_time();
+                ESP_LOGI(GATTS_TABLE_TAG, "conn %d encrypted with %s keys", conn->conn_id, conn->paired ? "new" : "bonded");
+            }
+        }
+            break;
         default:
             break;
     }
 }
 
 /*
-  实现 BLE GATT Server 在接收到 characteristic write请求时的处理函数
+  長特徵值寫入執行後，將完整資料交給 OTA 處理
 */
-/* 長特徵值寫入 */
-/* 
-  客戶端透過發送執行寫入請求來完成長寫入序列。該命令會觸發一個ESP_GATTS_EXEC_WRITE_EVT事件。伺服器透過發送回應並執行函數來處理此事件example_exec_write_event_env()
+/* 自動回應時將 OTA 狀態寫入 OTA Control 的屬性值 (由應用程式回應時讀取事件即時產生) */
+static void ota_update_attr_value(void)
+{
+#if !OTA_RSP_BY_APP
+    uint8_t value[OTA_CONTROL_VAL_LEN];
+    ota_update_control_value(value);
+    esp_ble_gatts_set_attr_value(ota_handle_table[IDX_CHAR_VAL_A], sizeof(value), value);
+#endif
+}
+
+/*
+  OTA 寫入被拒絕時回傳狀態碼作為寫入回應，client 讀取 OTA Control 也可得知失敗原因。
+  OTA 由其他連線進行中時回應 OTA_STATUS_NOT_STARTED，不改變 OTA 的狀態
 */
-void example_prepare_write_event_env(esp_gatt_if_t gatts_if, prepare_type_env_t *prepare_write_env, esp_ble_gatts_cb_param_t *param)
+static esp_gatt_status_t ota_report_status(uint16_t conn_id)
+{
+    ota_update_attr_value();
+    return (esp_gatt_status_t)ota_update_get_status(conn_id);
+}
+
+static esp_gatt_status_t ota_control_long_write(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t handle, const uint8_t *data, uint16_t len)
+{
+    if (len > 0 && ota_update_control(conn_id, data, len) != ESP_OK) {
+        return ota_report_status(conn_id);
+    }
+    return ESP_GATT_OK;
+}
+
+static esp_gatt_status_t ota_data_long_write(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t handle, const uint8_t *data, uint16_t len)
 {
-    ESP_LOGI(GATTS_TABLE_TAG, "prepare write, handle = %d, value len = %d", param->write.handle, param->write.len);
+    // prepare_write_event() 已將每段資料複製到緩衝池
+    ota_update_count_copy(conn_id, len);
+    if (ota_update_data(conn_id, data, len) != ESP_OK) {
+        return ota_report_status(conn_id);
+    }
+    return ESP_GATT_OK;
+}
+
+/*
+  事件紀錄匯出: client 先寫入 4 bytes (little endian) 的起始位置，再讀取 characteristic B2
+  (可用 long read 讀取最多 ESP_GATT_MAX_ATTR_LEN bytes)，讀到的長度不足 ESP_GATT_MAX_ATTR_LEN 表示已到檔案結尾
+*/
+static void log_export_read_event(esp_gatt_if_t gatts_if, ble_conn_t *conn, esp_ble_gatts_cb_param_t *param, void *ctx)
+{
+    static esp_gatt_rsp_t log_rsp;
     esp_gatt_status_t status = ESP_GATT_OK;
-    if (prepare_write_env->prepare_buf == NULL) {
-        //為了使用準備緩衝區，為其分配了一些內存空間
-        prepare_write_env->prepare_buf = (uint8_t *)malloc(PREPARE_BUF_MAX_SIZE * sizeof(uint8_t));
-        prepare_write_env->prepare_len = 0;
-        if (prepare_write_env->prepare_buf == NULL) {
-            ESP_LOGE(GATTS_TABLE_TAG, "%s, Gatt_server prep no mem", __func__);
-            status = ESP_GATT_NO_RESOURCES;
-        }
+    uint16_t len = 0;
+
+    if (param->read.offset > ESP_GATT_MAX_ATTR_LEN) {
+        status = ESP_GATT_INVALID_OFFSET;
     } else {
-        //如果由於內存不足導致分配失敗，則會打印錯誤
-        if(param->write.offset > PREPARE_BUF_MAX_SIZE) {
-            status = ESP_GATT_INVALID_OFFSET;
-        } else if ((param->write.offset + param->write.len) > PREPARE_BUF_MAX_SIZE) {
-            status = ESP_GATT_INVALID_ATTR_LEN;
+        uint16_t cap = ESP_GATT_MAX_ATTR_LEN - param->read.offset;
+        if (cap > conn->mtu - 1) {
+            cap = conn->mtu - 1;
+        }
+        if (event_store_read(conn->log_offset + param->read.offset, log_rsp.attr_value.value, cap, &len) != ESP_OK) {
+            status = ESP_GATT_ERROR;
         }
     }
-    /*send response when param->write.need_rsp is true 
-    發送寫請求或準備寫請求時，服務器是否響應*/
-    if (param->write.need_rsp){
-        /*準備esp_gatt_rsp_t要發送回客戶端的類型響應。它使用寫入請求的相同參數構造的響應，例如長度、句柄和偏移量。*/
-        esp_gatt_rsp_t *gatt_rsp = (esp_gatt_rsp_t *)malloc(sizeof(esp_gatt_rsp_t));
-        if (gatt_rsp != NULL){
-            gatt_rsp->attr_value.len = param->write.len;
-            gatt_rsp->attr_value.handle = param->write.handle;
-            gatt_rsp->attr_value.offset = param->write.offset;
-            gatt_rsp->attr_value.auth_req = ESP_GATT_AUTH_REQ_NONE;//寫入該特性所需的GATT認證類型設置為ESP_GATT_AUTH_REQ_NONE，這意味著客戶端可以寫入該特性而無需先進行身分驗證。
-            memcpy(gatt_rsp->attr_value.value, param->write.value, param->write.len);
-            esp_err_t response_err = esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, status, gatt_rsp);
-            if (response_err != ESP_OK){
-               ESP_LOGE(GATTS_TABLE_TAG, "Send response error");
-            }
-            free(gatt_rsp);//一旦發送響應，分配給它使用的內存就會被釋放。
-        }else{
-            ESP_LOGE(GATTS_TABLE_TAG, "%s, malloc failed", __func__);
+    log_rsp.attr_value.handle = param->read.handle;
+    log_rsp.attr_value.offset = param->read.offset;
+    log_rsp.attr_value.len = len;
+    log_rsp.attr_value.auth_req = ESP_GATT_AUTH_REQ_NONE;
+    esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id, status, &log_rsp);
+}
+
+/* 設定事件紀錄匯出的起始位置 */
+static esp_gatt_status_t log_export_write_event(esp_gatt_if_t gatts_if, ble_conn_t *conn, esp_ble_gatts_cb_param_t *param, void *ctx)
+{
+    if (param->write.len != sizeof(uint32_t)) {
+        return ESP_GATT_INVALID_ATTR_LEN;
+    }
+    conn->log_offset = param->write.value[0] | param->write.value[1] << 8 | param->write.value[2] << 16 | (uint32_t)param->write.value[3] << 24;
+    return ESP_GATT_OK;
+}
+
+/* 選擇診斷 characteristic 要讀取的資料 (DIAG_ID_*) */
+static esp_gatt_status_t diag_write_event(esp_gatt_if_t gatts_if, ble_conn_t *conn, esp_ble_gatts_cb_param_t *param, void *ctx)
+{
+    if (param->write.len != sizeof(conn->diag_id)) {
+        return ESP_GATT_INVALID_ATTR_LEN;
+    }
+    conn->diag_id = param->write.value[0];
+    return ESP_GATT_OK;
+}
+
+/* 讀取選擇的診斷資料，可用 long read 讀取，讀到的長度不足表示已到結尾 */
+static void diag_read_event(esp_gatt_if_t gatts_if, ble_conn_t *conn, esp_ble_gatts_cb_param_t *param, void *ctx)
+{
+    static esp_gatt_rsp_t diag_rsp;
+    esp_gatt_status_t status = ESP_GATT_OK;
+    size_t len = 0;
+
+    if (param->read.offset > ESP_GATT_MAX_ATTR_LEN) {
+        status = ESP_GATT_INVALID_OFFSET;
+    } else {
+        uint16_t cap = ESP_GATT_MAX_ATTR_LEN - param->read.offset;
+        if (cap > conn->mtu - 1) {
+            cap = conn->mtu - 1;
+        }
+        if (diag_read(conn->diag_id, param->read.offset, diag_rsp.attr_value.value, cap, &len) != ESP_OK) {
+            status = ESP_GATT_NOT_FOUND;
         }
     }
-    if (status != ESP_GATT_OK){
-        return;
+    diag_rsp.attr_value.handle = param->read.handle;
+    diag_rsp.attr_value.offset = param->read.offset;
+    diag_rsp.attr_value.len = len;
+    diag_rsp.attr_value.auth_req = ESP_GATT_AUTH_REQ_NONE;
+    esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id, status, &diag_rsp);
+}
+
+static esp_gatt_status_t ota_control_write_event(esp_gatt_if_t gatts_if, ble_conn_t *conn, esp_ble_gatts_cb_param_t *param, void *ctx)
+{
+    if (param->write.len > OTA_CONTROL_WRITE_LEN) {
+        return ESP_GATT_INVALID_ATTR_LEN;
+    }
+    if (param->write.len > 0 && ota_update_control(param->write.conn_id, param->write.value, param->write.len) != ESP_OK) {
+        return ota_report_status(param->write.conn_id);
     }
-    /*最後，傳入的數據被複製到創建的準備緩衝區中，其長度按偏移量遞增*/
-    memcpy(prepare_write_env->prepare_buf + param->write.offset, param->write.value, param->write.len);
-    prepare_write_env->prepare_len += param->write.len;
+    return ESP_GATT_OK;
+}
 
+/* 讀取 OTA Control: 狀態碼與支援的傳輸方式 */
+static void ota_control_read_event(esp_gatt_if_t gatts_if, ble_conn_t *conn, esp_ble_gatts_cb_param_t *param, void *ctx)
+{
+    static esp_gatt_rsp_t control_rsp;
+    esp_gatt_status_t status = ESP_GATT_OK;
+    uint16_t len = 0;
+
+    if (param->read.offset > OTA_CONTROL_VAL_LEN) {
+        status = ESP_GATT_INVALID_OFFSET;
+    } else {
+        uint8_t value[OTA_CONTROL_VAL_LEN];
+        ota_update_control_value(value);
+        len = OTA_CONTROL_VAL_LEN - param->read.offset;
+        memcpy(control_rsp.attr_value.value, value + param->read.offset, len);
+    }
+    control_rsp.attr_value.handle = param->read.handle;
+    control_rsp.attr_value.offset = param->read.offset;
+    control_rsp.attr_value.len = len;
+    control_rsp.attr_value.auth_req = ESP_GATT_AUTH_REQ_NONE;
+    esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id, status, &control_rsp);
 }
 
-/*
-  处理BLE GATT协议中的Prepare Write操作的回调函数
-*/
-/* 執行寫入用於確認或取消先前由長特徵寫入過程完成的寫入過程 */
-void example_exec_write_event_env(prepare_type_env_t *prepare_write_env, esp_ble_gatts_cb_param_t *param){
-    //此函數檢查exec_write_flag隨事件接收的參數中的。如果該標誌等於表示的執行標誌exec_write_flag，則確認寫入並將準備緩衝區列印在日誌中；如果不是，則表示取消寫入，並且刪除所有已寫入的資料。
-    if (param->exec_write.exec_write_flag == ESP_GATT_PREP_WRITE_EXEC && prepare_write_env->prepare_buf){
-        esp_log_buffer_hex(GATTS_TABLE_TAG, prepare_write_env->prepare_buf, prepare_write_env->prepare_len);
+/* 寫入的資料直接由事件參數交給 OTA，由應用程式回應時屬性值不保留資料 */
+static esp_gatt_status_t ota_data_write_event(esp_gatt_if_t gatts_if, ble_conn_t *conn, esp_ble_gatts_cb_param_t *param, void *ctx)
+{
+    if (param->write.len > OTA_DATA_VAL_LEN) {
+        return ESP_GATT_INVALID_ATTR_LEN;
+    }
+#if !OTA_RSP_BY_APP
+    // 自動回應時堆棧先將寫入的資料存入屬性值
+    ota_update_count_copy(param->write.conn_id, param->write.len);
+#endif
+    if (ota_update_data(param->write.conn_id, param->write.value, param->write.len) != ESP_OK) {
+        return ota_report_status(param->write.conn_id);
+    }
+    // 以寫入命令送出或自動回應時，block header 的結果由 OTA Control 讀取，成功時也需更新屬性值
+    ota_update_attr_value();
+    return ESP_GATT_OK;
+}
+
+/* add notification for new service's characteristic A2 */
+static esp_gatt_status_t temperature_cccd_write_event(esp_gatt_if_t gatts_if, ble_conn_t *conn, esp_ble_gatts_cb_param_t *param, void *ctx)
+{
+    if (param->write.len != 2) {
+        return ESP_GATT_INVALID_ATTR_LEN;
+    }
+    uint16_t descr_value = param->write.value[1]<<8 | param->write.value[0];
+    conn->temperature_cccd = descr_value;
+    if (descr_value == 0x0001){
+        ESP_LOGI(GATTS_TABLE_TAG, "conn %d notify enable", param->write.conn_id);
+        // 開始送出打包後的溫度樣本
+        temperature_stream_start(param->write.conn_id, temperature_handle_table[IDX_CHAR_VAL_A2], false, conn->mtu);
+    }else if (descr_value == 0x0002){
+        ESP_LOGI(GATTS_TABLE_TAG, "conn %d indicate enable", param->write.conn_id);
+        temperature_stream_start(param->write.conn_id, temperature_handle_table[IDX_CHAR_VAL_A2], true, conn->mtu);
+    }
+    else if (descr_value == 0x0000){
+        ESP_LOGI(GATTS_TABLE_TAG, "conn %d notify/indicate disable ", param->write.conn_id);
+        temperature_stream_stop(param->write.conn_id);
     }else{
-        ESP_LOGI(GATTS_TABLE_TAG,"ESP_GATT_PREP_WRITE_CANCEL");
+        ESP_LOGE(GATTS_TABLE_TAG, "unknown descr value");
+        esp_log_buffer_hex(GATTS_TABLE_TAG, param->write.value, param->write.len);
+    }
+    return ESP_GATT_OK;
+}
+
+/* OTA 屬性表建立後註冊長寫入 */
+static void ota_service_created(void)
+{
+    prepare_write_register(ota_handle_table[IDX_CHAR_VAL_A], OTA_CONTROL_WRITE_LEN, ota_control_long_write);
+    prepare_write_register(ota_handle_table[IDX_CHAR_VAL_B], OTA_DATA_PREPARE_CAPACITY, ota_data_long_write);
+#if !OTA_RSP_BY_APP
+    // 讀取 OTA Control 可得知是否支援 L2CAP CoC 傳輸
+    ota_update_attr_value();
+#endif
+}
+
+/* 各屬性的讀寫處理函數 (ota_attr_ops、temperature_attr_ops)，建立屬性表後以 handle 註冊到 gatts_dispatch */
+#define SCHEMA_OPS_SVC(idx, uuid)
+#define SCHEMA_OPS_CHAR(decl_idx, val_idx, uuid, prop, perm, rsp, max_len, value, on_write, on_read) \
+    [val_idx] = { .write = on_write, .read = on_read },
+#define SCHEMA_OPS_DESCR(idx, uuid, perm, rsp, max_len, value, on_write, on_read)                   \
+    [idx] = { .write = on_write, .read = on_read },
+#define SCHEMA_OPS_SERVICE(name, schema, idx_nb, on_created)                                       \
+    static const gatts_attr_ops_t name##_attr_ops[idx_nb] = {                                       \
+        schema(SCHEMA_OPS_SVC, SCHEMA_OPS_CHAR, SCHEMA_OPS_DESCR)                                   \
+    };
+
+GATTS_SERVICE_LIST(SCHEMA_OPS_SERVICE)
+
+typedef struct {
+    const char                *name;
+    const esp_gatts_attr_db_t *attr_db;
+    const gatts_attr_ops_t    *attr_ops;
+    uint16_t                  *handle_table;
+    uint16_t                   attr_num;
+    void                     (*on_created)(void);
+} gatts_service_t;
+
+#define SCHEMA_SERVICE_ENTRY(name, schema, idx_nb, on_created)                                     \
+    { #name, name##_attr_db, name##_attr_ops, name##_handle_table, idx_nb, on_created },
+
+static const gatts_service_t gatts_services[] = {
+    GATTS_SERVICE_LIST(SCHEMA_SERVICE_ENTRY)
+};
+
+#define GATTS_SERVICE_NUM   (sizeof(gatts_services) / sizeof(gatts_services[0]))
+
+static uint8_t service_creating;    // 正在建立屬性表的 service (gatts_services 的索引)
+
+/* 建立第 idx 個 service 的屬性表 (instance id 為 idx)，完成後產生 ESP_GATTS_CREAT_ATTR_TAB_EVT */
+static void gatts_service_create(esp_gatt_if_t gatts_if, uint8_t idx)
+{
+    const gatts_service_t *svc = &gatts_services[idx];
+
+    service_creating = idx;
+    esp_err_t ret = esp_ble_gatts_create_attr_tab(svc->attr_db, gatts_if, svc->attr_num, idx);
+    if (ret){
+        ESP_LOGE(GATTS_TABLE_TAG, "create %s attr table failed, error code = %x", svc->name, ret);
     }
-    // 将之前分配的缓存释放掉，并将缓存长度清零
-    //最後，為存儲來自長寫操作的數據塊而創建的準備緩衝區結構進行釋放，並將其指針設置為NULL，以使其為下一個長寫過程做好準備。
-    if (prepare_write_env->prepare_buf) {
-        free(prepare_write_env->prepare_buf);
-        prepare_write_env->prepare_buf = NULL;
+}
+
+/* ESP_GATTS_CREAT_ATTR_TAB_EVT: 保存 handle、註冊讀寫處理函數並啟動 service */
+static void gatts_service_table_created(esp_ble_gatts_cb_param_t *param)
+{
+    const gatts_service_t *svc = &gatts_services[service_creating];
+
+    if (param->add_attr_tab.status != ESP_GATT_OK){
+        ESP_LOGE(GATTS_TABLE_TAG, "create %s attribute table failed, error code=0x%x", svc->name, param->add_attr_tab.status);
+        return;
     }
-    prepare_write_env->prepare_len = 0;
+    if (param->add_attr_tab.num_handle != svc->attr_num){
+        ESP_LOGE(GATTS_TABLE_TAG, "create %s attribute table abnormally, num_handle (%d) doesn't equal to %d",
+                 svc->name, param->add_attr_tab.num_handle, svc->attr_num);
+        return;
+    }
+    ESP_LOGI(GATTS_TABLE_TAG, "create %s attribute table successfully, the number handle = %d", svc->name, param->add_attr_tab.num_handle);
+    memcpy(svc->handle_table, param->add_attr_tab.handles, svc->attr_num * sizeof(uint16_t));
+    gatts_dispatch_register(svc->handle_table, svc->attr_ops, svc->attr_num);
+    if (svc->on_created){
+        svc->on_created();
+    }
+    // 每份清單的第一個屬性為 service 宣告
+    esp_ble_gatts_start_service(svc->handle_table[0]);
 }
 
 /*
@@ -523,6 +687,23 @@ void example_exec_write_event_env(prepare_type_env_t *prepare_write_env, esp_ble
   @param gatts_if: GATT 接口标识符
   @param param: BLE GATT 事件回调参数的指针
 */
+/* 對方是否已綁定 (NVS 中有密鑰)，只在 BTC task 中呼叫，綁定列表放在靜態緩衝區 */
+static bool peer_is_bonded(const esp_bd_addr_t bda)
+{
+    static esp_ble_bond_dev_t bond_list[BOND_LIST_MAX];
+    int num = BOND_LIST_MAX;
+
+    if (esp_ble_get_bond_device_list(&num, bond_list) != ESP_OK) {
+        return false;
+    }
+    for (int i = 0; i < num; i++) {
+        if (memcmp(bond_list[i].bd_addr, bda, sizeof(esp_bd_addr_t)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static void gatts_profile_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param)
 {
     switch (event) {
@@ -558,158 +739,130 @@ static void gatts_profile_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_
                 ESP_LOGE(GATTS_TABLE_TAG, "config scan response data failed, error code = %x", ret);
             }
             adv_config_done |= SCAN_RSP_CONFIG_FLAG;
+            adv_configured = true;
     #endif
             // 創建一個服務Attribute表，包含服務與特徵等
             /*
-              使用esp_ble_gatts_create_attr_tab來創建屬性表，執行成功後，會進行ESP_GATTS_CREAT_ATTR_TAB_EVT事件，將屬性句柄保存在數組heart_rate_handle_table中。
+              使用esp_ble_gatts_create_attr_tab來創建屬性表，執行成功後，會進行ESP_GATTS_CREAT_ATTR_TAB_EVT事件，將屬性句柄保存在該 service 的 handle 表中。
+              GATTS_SERVICE_LIST 中的 service 依序建立，屬性表的順序與內容固定，每次啟動的 handle 相同，
+              已綁定的 client 可沿用快取的 handle；屬性表改變時 Database Hash 隨之改變，client 重新探索
             */
-            esp_err_t create_attr_ret = esp_ble_gatts_create_attr_tab(gatt_db, gatts_if, HRS_IDX_NB, SVC_INST_ID);
-            if (create_attr_ret){
-                ESP_LOGE(GATTS_TABLE_TAG, "create attr table failed, error code = %x", create_attr_ret);
-            }
+            gatts_service_create(gatts_if, 0);
         }
        	    break;
         // 读取事件，从外设读取数据
-        case ESP_GATTS_READ_EVT:
-            ESP_LOGI(GATTS_TABLE_TAG, "ESP_GATTS_READ_EVT");
+        case ESP_GATTS_READ_EVT:{
+            ESP_LOGI(GATTS_TABLE_TAG, "ESP_GATTS_READ_EVT, conn_id = %d, handle = %d, offset = %d", param->read.conn_id, param->read.handle, param->read.offset);
+            ble_conn_t *conn = ble_conn_find(param->read.conn_id);
+            const gatts_attr_ops_t *ops = gatts_dispatch_lookup(param->read.handle);
+            if (conn){
+                ble_conn_ready(conn);
+            }
+            if (conn && param->read.need_rsp && ops && ops->read){
+                ops->read(gatts_if, conn, param, ops->ctx);
+            } else if (conn == NULL && param->read.need_rsp){
+                esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id, ESP_GATT_ERROR, NULL);
+            }
+        }
        	    break;
         // 写请求事件，GATT写事件，手机给开发板的发送数据
         case ESP_GATTS_WRITE_EVT:
             // 不是寫入長特徵值
             if (!param->write.is_prep){
-                // the data length of gattc write  must be less than GATTS_DEMO_CHAR_VAL_LEN_MAX.
-                ESP_LOGI(GATTS_TABLE_TAG, "GATT_WRITE_EVT, handle = %d, value len = %d, value :", param->write.handle, param->write.len);
-                //esp_log_buffer_hex(GATTS_TABLE_TAG, param->write.value, param->write.len);
-
-				if (ota_handle_table[IDX_CHAR_VAL_A] == param->write.handle && param->write.len == 1){
-                    uint8_t value = param->write.value[0];
-					ESP_LOGI(GATTS_TABLE_TAG, "ota-control = %d",value);
-					if(0x00 == value){
-						ESP_LOGI(GATTS_TABLE_TAG, "======beginota======");
-                         // 讀取目前正在運行partition內容，例如: type: 0, subtype 16, address: 10000, size: 180000, erase size: 1000, label: ota_0, encrypted: 0
-                        //  update_partition = esp_ota_get_running_partition();
-                        //  ESP_LOGI(GATTS_TABLE_TAG, "type: %d, subtype %d, address: %lx, size: %lx, erase size: %lx, label: %s, encrypted: %u", update_partition->type, update_partition->subtype, update_partition->address, update_partition->size, update_partition->erase_size, update_partition->label, update_partition->encrypted);
-						 // 讀取下一個partition內容，例如: type: 0, subtype 17, address: 190000, size: 180000, erase size: 1000, label: ota_1, encrypted: 0
-                         update_partition = esp_ota_get_next_update_partition(NULL);
-                         ESP_LOGI(GATTS_TABLE_TAG, "type: %d, subtype %d, address: %lx, size: %lx, erase size: %lx, label: %s, encrypted: %u", update_partition->type, update_partition->subtype, update_partition->address, update_partition->size, update_partition->erase_size, update_partition->label, update_partition->encrypted);
-                        /*
-                          update_partition->subtype: partition subtype;
-                          update_partition->address: starting address of the partition in flash
-                        */
- 					     ESP_LOGI(GATTS_TABLE_TAG, "Writing to partition subtype %d at offset 0x%lx", update_partition->subtype, update_partition->address);
- 					     assert(update_partition != NULL);
-                         // OTA_WITH_SEQUENTIAL_WRITES: Used for esp_ota_begin() if new image size is unknown and erase can be done in incremental manner (assuming write operation is in continuous sequence)
-						 err = esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &update_handle);
-						  if (err != ESP_OK) {
-		                        ESP_LOGE(GATTS_TABLE_TAG, "esp_ota_begin failed (%s)", esp_err_to_name(err));
-		                        esp_ota_abort(update_handle);
-		                  }
-					}
-					else if(0x03 == value){
-						ESP_LOGI(GATTS_TABLE_TAG, "======endota======");
-						err = esp_ota_end(update_handle);
-					    if (err != ESP_OK) {
-					        if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
-					            ESP_LOGE(GATTS_TABLE_TAG, "Image validation failed, image is corrupted");
-					        }
-					        ESP_LOGE(GATTS_TABLE_TAG, "esp_ota_end failed (%s)!", esp_err_to_name(err));
-					    }
-
-					    err = esp_ota_set_boot_partition(update_partition);
-					    if (err != ESP_OK) {
-					        ESP_LOGE(GATTS_TABLE_TAG, "esp_ota_set_boot_partition failed (%s)!", esp_err_to_name(err));
-	
-					    }
-					    ESP_LOGI(GATTS_TABLE_TAG, "Prepare to restart system!");
-					    esp_restart();
-					    return ;
-					}
-					
-                }
-				if (ota_handle_table[IDX_CHAR_VAL_B] == param->write.handle){
-                    uint16_t length = param->write.len;// modify uint8_t to uint16_t when mtu larger than 255
-					ESP_LOGI(GATTS_TABLE_TAG, "ota-data = %d",length);
-					err = esp_ota_write( update_handle, (const void *)param->write.value, length);
-		            if (err != ESP_OK) {
-		                esp_ota_abort(update_handle);
-						ESP_LOGI(GATTS_TABLE_TAG, "esp_ota_write error!");
-		            }
-                }
-                // add notification for new service's characteristic A2
-                if (temperature_handle_table[IDX_CHAR_CFG_A2] == param->write.handle && param->write.len == 2){
-                    uint16_t descr_value = param->write.value[1]<<8 | param->write.value[0];
-                    if (descr_value == 0x0001){
-                        ESP_LOGI(GATTS_TABLE_TAG, "notify enable");
-                        uint8_t notify_data[15];
-                        for (int i = 0; i < sizeof(notify_data); ++i)
-                        {
-                            notify_data[i] = i % 0xff;
-                        }
-                        // the size of notify_data[] need less than MTU size
-                        esp_ble_gatts_send_indicate(gatts_if, param->write.conn_id, temperature_handle_table[IDX_CHAR_VAL_A2], sizeof(notify_data), notify_data, false);
-                    }else if (descr_value == 0x0002){
-                        ESP_LOGI(GATTS_TABLE_TAG, "indicate enable");
-                        uint8_t indicate_data[15];
-                        for (int i = 0; i < sizeof(indicate_data); ++i)
-                        {
-                            indicate_data[i] = i % 0xff;
-                        }
-                        // the size of indicate_data[] need less than MTU size
-                        esp_ble_gatts_send_indicate(gatts_if, param->write.conn_id, temperature_handle_table[IDX_CHAR_VAL_A2], sizeof(indicate_data), indicate_data, true);
-                    }
-                    else if (descr_value == 0x0000){
-                        ESP_LOGI(GATTS_TABLE_TAG, "notify/indicate disable ");
-                    }else{
-                        ESP_LOGE(GATTS_TABLE_TAG, "unknown descr value");
-                        esp_log_buffer_hex(GATTS_TABLE_TAG, param->write.value, param->write.len);
+                // the data length of gattc write must not exceed the attribute's max_len in the service schema.
+                ESP_LOGD(GATTS_TABLE_TAG, "GATT_WRITE_EVT, handle = %d, value len = %d", param->write.handle, param->write.len);
+                esp_gatt_status_t write_status = ESP_GATT_OK;
+                ble_conn_t *conn = ble_conn_find(param->write.conn_id);
+                if (conn == NULL){
+                    // 連線表已滿時沒有記錄這個連線，仍需回應，否則 client 要等到 ATT 逾時
+                    if (param->write.need_rsp){
+                        esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, ESP_GATT_ERROR, NULL);
                     }
+                    break;
+                }
+                ble_conn_ready(conn);
+                conn->rx_writes++;
+                conn->rx_bytes += param->write.len;
+
+                // 以 handle 直接查表找到屬性的處理函數
+                const gatts_attr_ops_t *ops = gatts_dispatch_lookup(param->write.handle);
+                if (ops && ops->write){
+                    write_status = ops->write(gatts_if, conn, param, ops->ctx);
                 }
 
 				/* send response when param->write.need_rsp is true */
                 if (param->write.need_rsp){
-                    esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, ESP_GATT_OK, NULL);
+                    esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, write_status, NULL);
                 }
             // 寫入長特徵值
             }else{
                 /* 
                   handle prepare write 
-                  如果寫入常特徵值則執行example_prepare_write_event_env
+                  如果寫入長特徵值則交給 prepare_write 暫存，待 ESP_GATTS_EXEC_WRITE_EVT 時交給屬性處理
                 */
-                example_prepare_write_event_env(gatts_if, &prepare_write_env, param);
+                ble_conn_t *conn = ble_conn_find(param->write.conn_id);
+                if (conn){
+                    ble_conn_ready(conn);
+                }
+                prepare_write_event(gatts_if, param);
             }
       	    break;
         // GATT写事件，手机给开发板的发送数据，收到远程设备的Prepare Write Request后，当远程设备完成所有Write请求并发送Execute Write Request时触发的事件
         case ESP_GATTS_EXEC_WRITE_EVT:
-            // the length of gattc prepare write data must be less than GATTS_DEMO_CHAR_VAL_LEN_MAX.
+            // the length of gattc prepare write data must not exceed the capacity set by prepare_write_register().
             ESP_LOGI(GATTS_TABLE_TAG, "ESP_GATTS_EXEC_WRITE_EVT");
-            example_exec_write_event_env(&prepare_write_env, param);
+            prepare_write_exec(gatts_if, param);
             break;
         // 当GATT客户端和服务器连接并协商MTU大小时的事件
         case ESP_GATTS_MTU_EVT:
-            ESP_LOGI(GATTS_TABLE_TAG, "ESP_GATTS_MTU_EVT, MTU %d", param->mtu.mtu);
+        {
+            ESP_LOGI(GATTS_TABLE_TAG, "ESP_GATTS_MTU_EVT, conn_id %d, MTU %d", param->mtu.conn_id, param->mtu.mtu);
+            ble_conn_t *conn = ble_conn_find(param->mtu.conn_id);
+            if (conn){
+                conn->mtu = param->mtu.mtu;
+            }
+            temperature_stream_set_mtu(param->mtu.conn_id, param->mtu.mtu);
+        }
             break;
         // GATT配置事件
         case ESP_GATTS_CONF_EVT:
-            ESP_LOGI(GATTS_TABLE_TAG, "ESP_GATTS_CONF_EVT, status = %d, attr_handle %d", param->conf.status, param->conf.handle);
+            ESP_LOGD(GATTS_TABLE_TAG, "ESP_GATTS_CONF_EVT, status = %d, attr_handle %d", param->conf.status, param->conf.handle);
+            // notification/indication 完成，送出佇列中的下一個封包
+            gatts_send_queue_handle_event(event, param);
+            break;
+        // GATT因为传输过多数据而处于拥塞状态
+        case ESP_GATTS_CONGEST_EVT:
+            ESP_LOGI(GATTS_TABLE_TAG, "ESP_GATTS_CONGEST_EVT, conn_id = %d, congested = %d", param->congest.conn_id, param->congest.congested);
+            gatts_send_queue_handle_event(event, param);
             break;
         // GATT 通用属性 服务器成功启动
         case ESP_GATTS_START_EVT:
-            if (create_tab == false){
-                ESP_LOGI(GATTS_TABLE_TAG, "SERVICE_START_EVT1, status %d, service_handle %d", param->start.status, param->start.service_handle);
-                esp_err_t create_attr_ret1 = esp_ble_gatts_create_attr_tab(gatt_db2, gatts_if, HRS_IDX_NB2, SVC_INST_ID1);
-                if (create_attr_ret1){
-                    ESP_LOGE(GATTS_TABLE_TAG, "create attr table2 failed, error code = %x", create_attr_ret1);
-                }
-                create_tab = true;
-            }else{
-                ESP_LOGI(GATTS_TABLE_TAG, "SERVICE_START_EVT2, status %d, service_handle %d", param->start.status, param->start.service_handle);
-            }           
+            ESP_LOGI(GATTS_TABLE_TAG, "SERVICE_START_EVT, status %d, service_handle %d", param->start.status, param->start.service_handle);
+            // 前一個 service 啟動後建立下一個
+            if (param->start.status == ESP_GATT_OK && service_creating + 1 < GATTS_SERVICE_NUM){
+                gatts_service_create(gatts_if, service_creating + 1);
+            }
             break;
         // GATT服务器已确认对于某个客户端发送的数据的接收。
         // 表示有一个BLE中央设备连接到该 GATT 服务器
         case ESP_GATTS_CONNECT_EVT:
             ESP_LOGI(GATTS_TABLE_TAG, "ESP_GATTS_CONNECT_EVT, conn_id = %d", param->connect.conn_id);
             esp_log_buffer_hex(GATTS_TABLE_TAG, param->connect.remote_bda, 6);
+            if (ble_conn_open(param->connect.conn_id, param->connect.remote_bda) == NULL){
+                esp_ble_gatts_close(gatts_if, param->connect.conn_id);
+                break;
+            }
+            gatts_send_queue_conn_open(param->connect.conn_id);
+            host_callbacks->connected(param->connect.conn_id);
+            // 已綁定的 client 以儲存在 NVS 的密鑰加密，加密後才能使用 GATT 快取 (Service Changed / Database Hash)。
+            // 新的 client 不強制配對 (屬性不需加密)，由 client 發起時以 Just Works 配對並綁定
+            if (peer_is_bonded(param->connect.remote_bda)){
+                esp_ble_set_encryption(param->connect.remote_bda, ESP_BLE_SEC_ENCRYPT_NO_MITM);
+            }
+            // 連線後協議棧會停止廣播，尚未達到連線上限時繼續廣播讓其他裝置連線
+            if (ble_conn_count() < BLE_CONN_MAX){
+                esp_ble_gap_start_advertising(&adv_params);
+            }
             esp_ble_conn_update_params_t conn_params = {0};
             memcpy(conn_params.bda, param->connect.remote_bda, sizeof(esp_bd_addr_t));
             /* 
@@ -727,40 +880,20 @@ static void gatts_profile_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_
         // 一个客户端设备断开
         case ESP_GATTS_DISCONNECT_EVT:
             ESP_LOGI(GATTS_TABLE_TAG, "ESP_GATTS_DISCONNECT_EVT, reason = 0x%x", param->disconnect.reason);
-            // esp_ble_gap_start_advertising(&adv_params);
-            esp_restart();
-            break;
-        case ESP_GATTS_CREAT_ATTR_TAB_EVT:{
-            if (create_tab == false){
-                if (param->add_attr_tab.status != ESP_GATT_OK){
-                    ESP_LOGE(GATTS_TABLE_TAG, "create attribute table1 failed, error code=0x%x", param->add_attr_tab.status);
-                }
-                else if (param->add_attr_tab.num_handle != HRS_IDX_NB){
-                    ESP_LOGE(GATTS_TABLE_TAG, "create attribute table1 abnormally, num_handle (%d) \
-                            doesn't equal to HRS_IDX_NB(%d)", param->add_attr_tab.num_handle, HRS_IDX_NB);
-                }
-                else {
-                    ESP_LOGI(GATTS_TABLE_TAG, "create attribute table1 successfully, the number handle = %d\n",param->add_attr_tab.num_handle);
-                    memcpy(ota_handle_table, param->add_attr_tab.handles, sizeof(ota_handle_table));
-                    esp_ble_gatts_start_service(ota_handle_table[IDX_SVC]);
-                }
-            }else{
-                if (param->add_attr_tab.status != ESP_GATT_OK){
-                    ESP_LOGE(GATTS_TABLE_TAG, "create attribute table2 failed, error code=0x%x", param->add_attr_tab.status);
-                }
-                else if (param->add_attr_tab.num_handle != HRS_IDX_NB2){
-                    ESP_LOGE(GATTS_TABLE_TAG, "create attribute table2 abnormally, num_handle (%d) \
-                            doesn't equal to HRS_IDX_NB2(%d)", param->add_attr_tab.num_handle, HRS_IDX_NB2);
-                }
-                else {
-                    ESP_LOGI(GATTS_TABLE_TAG, "create attribute table2 successfully, the number handle = %d\n",param->add_attr_tab.num_handle);
-                    memcpy(temperature_handle_table, param->add_attr_tab.handles, sizeof(temperature_handle_table));
-                    esp_ble_gatts_start_service(temperature_handle_table[IDX_SVC2]);
-                }
+            temperature_stream_stop(param->disconnect.conn_id);
+            gatts_send_queue_conn_close(param->disconnect.conn_id);
+            prepare_write_conn_close(param->disconnect.conn_id);
+            ota_update_conn_close(param->disconnect.conn_id);
+            ble_conn_close(param->disconnect.conn_id);
+            host_callbacks->disconnected(param->disconnect.conn_id, ble_conn_count());
+            if (ble_conn_count() == BLE_CONN_MAX - 1){
+                // 原本已達連線上限而停止廣播，重新開始廣播
+                esp_ble_gap_start_advertising(&adv_params);
             }
-            
             break;
-        }
+        case ESP_GATTS_CREAT_ATTR_TAB_EVT:
+            gatts_service_table_created(param);
+            break;
         // GATT 服务器停止
         case ESP_GATTS_STOP_EVT:
         // 表示一个新的客户端连接
@@ -771,8 +904,6 @@ static void gatts_profile_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_
         case ESP_GATTS_CLOSE_EVT:
         // GATT 已经开始监听请求
         case ESP_GATTS_LISTEN_EVT:
-        // GATT因为传输过多数据而处于拥塞状态
-        case ESP_GATTS_CONGEST_EVT:
         // GATT 服务器已被注销
         case ESP_GATTS_UNREG_EVT:
         // 删除GATT服务器的服务或属性
@@ -812,247 +943,128 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
     } while (0);
 }
 
-/*
-  將資料寫入SPIFFS
-*/
-void write_to_spiffs(uint8_t gpio)
+esp_err_t ble_host_notify(uint16_t conn_id, uint16_t attr_handle, const uint8_t *data, uint16_t len, bool need_confirm)
 {
-    vTaskDelay(pdMS_TO_TICKS(2500));
-    ESP_LOGI(GATTS_TABLE_TAG, "Initializing SPIFFS");
-
-    // 對spiffs進行配置
-    esp_vfs_spiffs_conf_t conf = {
-      .base_path = "/spiffs",// 文件系统的目录地址
-      .partition_label = NULL,// 在.csv文件中的标签，如果设置为NULL则使用spiffs
-      .max_files = 5,// 同时可以打开最大的文件数
-      .format_if_mount_failed = true// 如果挂载失败，则格式化文件系统
-    };
-
-    // Use settings defined above to initialize and mount SPIFFS filesystem.
-    // Note: esp_vfs_spiffs_register is an all-in-one convenience function.
-    // 注册函数将spiffs 挂载并注册到vfs中
-    esp_err_t ret = esp_vfs_spiffs_register(&conf);
+    return gatts_send_queue_push(heart_rate_profile_tab[PROFILE_APP_IDX].gatts_if, conn_id, attr_handle, data, len, need_confirm);
+}
 
-    if (ret != ESP_OK) {
-        if (ret == ESP_FAIL) {
-            ESP_LOGE(GATTS_TABLE_TAG, "Failed to mount or format filesystem");
-        } else if (ret == ESP_ERR_NOT_FOUND) {
-            ESP_LOGE(GATTS_TABLE_TAG, "Failed to find SPIFFS partition");
-        } else {
-            ESP_LOGE(GATTS_TABLE_TAG, "Failed to initialize SPIFFS (%s)", esp_err_to_name(ret));
-        }
-        return;
+void ble_host_set_adv_beacon(const uint8_t *data, uint8_t len)
+{
+#ifdef CONFIG_SET_RAW_ADV_DATA
+    // 原始广播数据已固定，不加入事件摘要
+    ESP_LOGW(GATTS_TABLE_TAG, "adv beacon not supported with raw adv data");
+#else
+    if (len > sizeof(adv_beacon)) {
+        len = sizeof(adv_beacon);
     }
-
-#ifdef CONFIG_EXAMPLE_SPIFFS_CHECK_ON_START
-    ESP_LOGI(GATTS_TABLE_TAG, "Performing SPIFFS_check().");
-    ret = esp_spiffs_check(conf.partition_label);
-    if (ret != ESP_OK) {
-        ESP_LOGE(GATTS_TABLE_TAG, "SPIFFS_check() failed (%s)", esp_err_to_name(ret));
-        return;
-    } else {
-        ESP_LOGI(GATTS_TABLE_TAG, "SPIFFS_check() successful");
+    memcpy(adv_beacon, data, len);
+    adv_data.manufacturer_len = len;
+    // 第一次设置尚未完成时，数据会在 ESP_GATTS_REG_EVT 的设置中带入
+    if (adv_configured && adv_config_done == 0) {
+        beacon_refresh++;
+        esp_err_t ret = esp_ble_gap_config_adv_data(&adv_data);
+        if (ret) {
+            beacon_refresh--;
+            ESP_LOGE(GATTS_TABLE_TAG, "update adv beacon failed, error code = %x", ret);
+        }
     }
 #endif
+}
 
-    // 查看spiffs 的信息
-    size_t total = 0, used = 0;
-    ret = esp_spiffs_info(conf.partition_label, &total, &used);
-    if (ret != ESP_OK) {
-        ESP_LOGE(GATTS_TABLE_TAG, "Failed to get SPIFFS partition information (%s). Formatting...", esp_err_to_name(ret));
-        esp_spiffs_format(conf.partition_label);
-        return;
-    } else {
-        ESP_LOGI(GATTS_TABLE_TAG, "Partition size: total: %d, used: %d", total, used);
-    }
+/* Bluedroid: 初始化 controller 與 host，GATT 服務與廣播在 ESP_GATTS_REG_EVT 後建立 */
+esp_err_t ble_host_start(const ble_host_callbacks_t *callbacks)
+{
+    esp_err_t ret;
 
-    // Check consistency of reported partiton size info.
-    if (used > total) {
-        ESP_LOGW(GATTS_TABLE_TAG, "Number of used bytes cannot be larger than total. Performing SPIFFS_check().");
-        ret = esp_spiffs_check(conf.partition_label);
-        // Could be also used to mend broken files, to clean unreferenced pages, etc.
-        // More info at https://github.com/pellepl/spiffs/wiki/FAQ#powerlosses-contd-when-should-i-run-spiffs_check
-        if (ret != ESP_OK) {
-            ESP_LOGE(GATTS_TABLE_TAG, "SPIFFS_check() failed (%s)", esp_err_to_name(ret));
-            return;
-        } else {
-            ESP_LOGI(GATTS_TABLE_TAG, "SPIFFS_check() successful");
-        }
-    }
-    // Use POSIX and C standard library functions to work with files.
-    // First create a file.
-    ESP_LOGI(GATTS_TABLE_TAG, "Opening file");
-    FILE* f = fopen("/spiffs/data.json", "a");
-    if (f == NULL) {
-        ESP_LOGE(GATTS_TABLE_TAG, "Failed to open file for writing");
-        return;
-    }
-    char *str = "";
-    switch (gpio) {
-        case TEMPERATURE_WAKEUP_GPIO1:
-            str = "Temperature1 ≤ 1°C";
-            break;
-        case TEMPERATURE_WAKEUP_GPIO2:
-            str = "Temperature2 ≤ -1°C";
-            break;
-        case TEMPERATURE_WAKEUP_GPIO3:
-            str = "Temperature3 ≤ -5°C";
-            break;
-        case LOW_BATTERY_WAKEUP_GPIO:
-            str = "Low Battery";
-            break;
-        case DEVICE_ABNORMAL_WAKEUP_GPIO:
-            str = "Device Abnormal";
-            break;
-        default:
-            break;
-    }
-    // 获取自启动以来经过的时间
-    int64_t timestamp = esp_timer_get_time();
-    cJSON *json_data = cJSON_CreateObject();
-    cJSON_AddStringToObject(json_data, "event", str);
-    cJSON_AddNumberToObject(json_data, "time after startup(ms)", timestamp / 1000);
-    char *str_data = cJSON_Print(json_data);
-    fprintf(f, "%s\n", str_data);
-    fclose(f);
-    cJSON_Delete(json_data);
-    free(str_data);
-    ESP_LOGI(GATTS_TABLE_TAG, "File written");
-
-
-     // Open renamed file for reading
-    ESP_LOGI(GATTS_TABLE_TAG, "Reading file");
-    f = fopen("/spiffs/data.json", "r");
-    if (f == NULL) {
-        ESP_LOGE(GATTS_TABLE_TAG, "Failed to open file for reading");
-        return;
-    }
-    char line[64];
-    // 多行讀取
-    while (fgets(line, sizeof(line), f) != NULL){
-        // strip newline
-        char* pos = strchr(line, '\n');
-        if (pos) {
-            *pos = '\0';
-        }
-        ESP_LOGI(GATTS_TABLE_TAG, "Read from file: '%s'", line);
-    }
-    fclose(f);
+    host_callbacks = callbacks;
+    host_start_us = esp_timer_get_time();
 
-    // All done, unmount partition and disable SPIFFS
-    esp_vfs_spiffs_unregister(conf.partition_label);
-    ESP_LOGI(GATTS_TABLE_TAG, "SPIFFS unmounted");
-}
+    // 释放经典蓝牙模式下的内存
+    ESP_ERROR_CHECK(esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT));
 
-void app_main(void)
-{
-    /* Enable wakeup from light sleep by gpio */
-    example_register_gpio_wakeup(); 
-    
-    printf("Entering light sleep\n");
-
-    // 等待 UART tx 記憶體清空並且最後一個字元發送成功（輪詢模式）
-    uart_wait_tx_idle_polling(CONFIG_ESP_CONSOLE_UART_NUM);
-
-    /* Enter sleep mode */
-    esp_light_sleep_start();
-
-    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO){
-        /* Waiting for the gpio inactive, or the chip will continously trigger wakeup */
-        wakeup_gpio = example_wait_gpio_inactive();
-        printf("wakeup_gpio = %u\n", wakeup_gpio);
-        
-        if (wakeup_gpio == BLE_WAKEUP_GPIO){
-            esp_err_t ret;
-
-            // 初始化 NVS.
-            ret = nvs_flash_init();
-            if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-                ESP_ERROR_CHECK(nvs_flash_erase());
-                ret = nvs_flash_init();
-            }
-            ESP_ERROR_CHECK( ret );
+    // 初始化蓝牙控制器
+    esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
+    ret = esp_bt_controller_init(&bt_cfg);
+    if (ret) {
+        ESP_LOGE(GATTS_TABLE_TAG, "%s enable controller failed: %s", __func__, esp_err_to_name(ret));
+        return ret;
+    }
 
-            // 释放经典蓝牙模式下的内存
-            ESP_ERROR_CHECK(esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT));
+    // 启用蓝牙控制器的 BLE 模式
+    ret = esp_bt_controller_enable(ESP_BT_MODE_BLE);
+    if (ret) {
+        ESP_LOGE(GATTS_TABLE_TAG, "%s enable controller failed: %s", __func__, esp_err_to_name(ret));
+        return ret;
+    }
 
-            // 初始化蓝牙控制器
-            esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
-            ret = esp_bt_controller_init(&bt_cfg);
-            if (ret) {
-                ESP_LOGE(GATTS_TABLE_TAG, "%s enable controller failed: %s", __func__, esp_err_to_name(ret));
-                return;
-            }
+    // 初始化蓝牙协议栈
+    ret = esp_bluedroid_init();
+    if (ret) {
+        ESP_LOGE(GATTS_TABLE_TAG, "%s init bluetooth failed: %s", __func__, esp_err_to_name(ret));
+        return ret;
+    }
 
-            // 启用蓝牙控制器的 BLE 模式
-            ret = esp_bt_controller_enable(ESP_BT_MODE_BLE);
-            if (ret) {
-                ESP_LOGE(GATTS_TABLE_TAG, "%s enable controller failed: %s", __func__, esp_err_to_name(ret));
-                return;
-            }
+    // 启用蓝牙协议栈
+    ret = esp_bluedroid_enable();
+    if (ret) {
+        ESP_LOGE(GATTS_TABLE_TAG, "%s enable bluetooth failed: %s", __func__, esp_err_to_name(ret));
+        return ret;
+    }
 
-            // 初始化蓝牙协议栈
-            ret = esp_bluedroid_init();
-            if (ret) {
-                ESP_LOGE(GATTS_TABLE_TAG, "%s init bluetooth failed: %s", __func__, esp_err_to_name(ret));
-                return;
-            }
+    // OTA 的 L2CAP CoC 傳輸，目前的 host 不支援時只使用 OTA Data characteristic
+    ota_l2cap_init();
 
-            // 启用蓝牙协议栈
-            ret = esp_bluedroid_enable();
-            if (ret) {
-                ESP_LOGE(GATTS_TABLE_TAG, "%s enable bluetooth failed: %s", __func__, esp_err_to_name(ret));
-                return;
-            }
+    // 初始化 notification/indication 送出佇列
+    ret = gatts_send_queue_init();
+    if (ret) {
+        ESP_LOGE(GATTS_TABLE_TAG, "send queue init failed, error code = %x", ret);
+        return ret;
+    }
 
-            // 注册 GATT 事件回调函数
-            ret = esp_ble_gatts_register_callback(gatts_event_handler);
-            if (ret){
-                ESP_LOGE(GATTS_TABLE_TAG, "gatts register error, error code = %x", ret);
-                return;
-            }
+    // 注册 GATT 事件回调函数
+    ret = esp_ble_gatts_register_callback(gatts_event_handler);
+    if (ret){
+        ESP_LOGE(GATTS_TABLE_TAG, "gatts register error, error code = %x", ret);
+        return ret;
+    }
 
-            // 注册 GAP 事件回调函数
-            ret = esp_ble_gap_register_callback(gap_event_handler);
-            if (ret){
-                ESP_LOGE(GATTS_TABLE_TAG, "gap register error, error code = %x", ret);
-                return;
-            }
+    // 注册 GAP 事件回调函数
+    ret = esp_ble_gap_register_callback(gap_event_handler);
+    if (ret){
+        ESP_LOGE(GATTS_TABLE_TAG, "gap register error, error code = %x", ret);
+        return ret;
+    }
 
-            // 注册 GATT 应用程序
-            ret = esp_ble_gatts_app_register(ESP_APP_ID);
-            if (ret){
-                ESP_LOGE(GATTS_TABLE_TAG, "gatts app register error, error code = %x", ret);
-                return;
-            }
+    // 绑定: Just Works 配对，密钥由协议栈存到 NVS，重新启动后仍可使用
+    esp_ble_auth_req_t auth_req = ESP_LE_AUTH_REQ_SC_BOND;
+    esp_ble_io_cap_t iocap = ESP_IO_CAP_NONE;
+    uint8_t key_size = 16;
+    uint8_t init_key = ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK;
+    uint8_t rsp_key = ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK;
+    esp_ble_gap_set_security_param(ESP_BLE_SM_AUTHEN_REQ_MODE, &auth_req, sizeof(auth_req));
+    esp_ble_gap_set_security_param(ESP_BLE_SM_IOCAP_MODE, &iocap, sizeof(iocap));
+    esp_ble_gap_set_security_param(ESP_BLE_SM_MAX_KEY_SIZE, &key_size, sizeof(key_size));
+    esp_ble_gap_set_security_param(ESP_BLE_SM_SET_INIT_KEY, &init_key, sizeof(init_key));
+    esp_ble_gap_set_security_param(ESP_BLE_SM_SET_RSP_KEY, &rsp_key, sizeof(rsp_key));
+
+    // 注册 GATT 应用程序
+    ret = esp_ble_gatts_app_register(ESP_APP_ID);
+    if (ret){
+        ESP_LOGE(GATTS_TABLE_TAG, "gatts app register error, error code = %x", ret);
+        return ret;
+    }
 
-            // 配置 GATT 层的 MTU
-            esp_err_t local_mtu_ret = esp_ble_gatt_set_local_mtu(500);
-            if (local_mtu_ret){
-                ESP_LOGE(GATTS_TABLE_TAG, "set local  MTU failed, error code = %x", local_mtu_ret);
-            }
-        }else if (wakeup_gpio == TEMPERATURE_WAKEUP_GPIO1) {
-            printf("Temperature1 is equal to or below 1°C\n");
-            write_to_spiffs(wakeup_gpio);
-            esp_restart();
-        }else if (wakeup_gpio == TEMPERATURE_WAKEUP_GPIO2) {
-            printf("Temperature2 is equal to or below -1°C\n");
-            write_to_spiffs(wakeup_gpio);
-            esp_restart();
-        }else if (wakeup_gpio == TEMPERATURE_WAKEUP_GPIO3) {
-            printf("Temperature3 is equal to or below -5°C\n");
-            write_to_spiffs(wakeup_gpio);
-            esp_restart();
-        }else if (wakeup_gpio == LOW_BATTERY_WAKEUP_GPIO) {
-            printf("Low Battery\n");
-            write_to_spiffs(wakeup_gpio);
-            esp_restart();
-        }else if (wakeup_gpio == DEVICE_ABNORMAL_WAKEUP_GPIO) {
-            printf("Device Abnormal\n");
-            write_to_spiffs(wakeup_gpio);
-            esp_restart();
-        }else {
-            esp_restart();
-        }       
+    // 配置 GATT 层的 MTU
+    esp_err_t local_mtu_ret = esp_ble_gatt_set_local_mtu(GATTS_LOCAL_MTU);
+    if (local_mtu_ret){
+        ESP_LOGE(GATTS_TABLE_TAG, "set local  MTU failed, error code = %x", local_mtu_ret);
+    }
+
+    // 開始定時取樣溫度，待 client 開啟 notify 後送出
+    ret = temperature_stream_init();
+    if (ret){
+        ESP_LOGE(GATTS_TABLE_TAG, "temperature stream init failed, error code = %x", ret);
     }
+    ESP_LOGI("ble_host", "%s init %lld ms", BLE_HOST_NAME, (esp_timer_get_time() - host_start_us) / 1000);
+    return ESP_OK;
 }
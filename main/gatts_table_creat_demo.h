@@ -10,32 +10,103 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "ota_update.h"
 
 
-/* Attributes State Machine */
-enum
-{
-    IDX_SVC,
-    IDX_CHAR_A,
-    IDX_CHAR_VAL_A,
+#define SAMPLE_DEVICE_NAME          "OTA-BLE"
+#define GATTS_LOCAL_MTU             500
+#define ATT_WRITE_HEADER_LEN        3       // opcode + handle
 
-    IDX_CHAR_B,
-    IDX_CHAR_VAL_B,
+/* 各屬性值實際需要的長度，屬性表依此配置儲存空間 */
+#define OTA_CONTROL_VAL_LEN         OTA_CONTROL_READ_LEN    // 寫入控制值 (與目標)，讀取為狀態、支援的傳輸方式與目標
+#define OTA_DATA_VAL_LEN            (GATTS_LOCAL_MTU - ATT_WRITE_HEADER_LEN)   // 一次寫入最多 MTU - 3 bytes
+#define TEMPERATURE_VAL_LEN         4
+#define LOG_EXPORT_VAL_LEN          sizeof(uint32_t)    // 寫入事件紀錄匯出的起始位置，讀取由應用程式回應
+#define DIAG_VAL_LEN                sizeof(uint8_t)     // 寫入診斷資料編號，讀取由應用程式回應
 
- 
-    HRS_IDX_NB,
-};
+/*
+  OTA Control/Data 由應用程式回應: 寫入的資料由事件參數直接交給 OTA，堆棧不再更新屬性值，
+  OTA Data 的屬性值只保留初始值的 4 bytes，寫入長度改由應用程式檢查。設為 0 可改回自動回應
+*/
+#define OTA_RSP_BY_APP              1
+#if OTA_RSP_BY_APP
+#define OTA_ATTR_RSP                ESP_GATT_RSP_BY_APP
+#define OTA_DATA_STORE_LEN          4
+#else
+#define OTA_ATTR_RSP                ESP_GATT_AUTO_RSP
+#define OTA_DATA_STORE_LEN          OTA_DATA_VAL_LEN
+#endif
+
+/* Silicon Labs OTA service 與 characteristic 的 128 bit UUID (LSB 在前)，Bluedroid 與 NimBLE 共用 */
+#define OTA_SERVICE_UUID128         0xf0, 0x19, 0x21, 0xb4, 0x47, 0x8f, 0xa4, 0xbf, 0xa1, 0x4f, 0x63, 0xfd, 0xee, 0xd6, 0x14, 0x1d
+#define OTA_CONTROL_UUID128         0x63, 0x60, 0x32, 0xe0, 0x37, 0x5e, 0xa4, 0x88, 0x53, 0x4e, 0x6d, 0xfb, 0x64, 0x35, 0xbf, 0xf7
+#define OTA_DATA_UUID128            0x53, 0xa1, 0x81, 0x1f, 0x58, 0x2c, 0xd0, 0xa5, 0x45, 0x40, 0xfc, 0x34, 0xf3, 0x27, 0x42, 0x98
+
+/* 溫度 service 與 characteristic 的 16 bit UUID */
+#define TEMPERATURE_SERVICE_UUID16  0x00EE
+#define TEMPERATURE_CHAR_UUID16     0xEE01  // 溫度通知 (A2)
+#define LOG_EXPORT_CHAR_UUID16      0xEE02  // 事件紀錄匯出 (B2)
+#define DIAG_CHAR_UUID16            0xEE03  // 診斷資料 (C2)
+
+/*
+  GATT 服務定義: 每個 service 一份清單，展開成屬性索引 (enum)、屬性表 (esp_gatts_attr_db_t)、
+  handle 表與讀寫處理函數的查表 (gatts_dispatch)。
+    SVC(idx, uuid)
+    CHAR(decl_idx, val_idx, uuid, prop, perm, rsp, max_len, value, on_write, on_read)
+    DESCR(idx, uuid, perm, rsp, max_len, value, on_write, on_read)
+  uuid、prop、value 為變數名稱，UUID 長度與初始值長度由 sizeof 取得；
+  on_write/on_read 為 gatts_write_cb_t/gatts_read_cb_t 處理函數，不需要時為 NULL
+*/
+
+#if OTA_RSP_BY_APP
+#define OTA_CONTROL_READ_CB         ota_control_read_event
+#else
+#define OTA_CONTROL_READ_CB         NULL    // 由堆棧回應屬性值
+#endif
+
+/* Silicon Labs OTA service */
+#define OTA_SERVICE_SCHEMA(SVC, CHAR, DESCR)                                                        \
+    SVC(IDX_SVC, service_uuid)                                                                      \
+    CHAR(IDX_CHAR_A, IDX_CHAR_VAL_A, char_ota_control_uuid, char_prop_read_write,                   \
+         ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, OTA_ATTR_RSP, OTA_CONTROL_VAL_LEN, ota_control_value, \
+         ota_control_write_event, OTA_CONTROL_READ_CB)                                               \
+    CHAR(IDX_CHAR_B, IDX_CHAR_VAL_B, char_ota_data_uuid, char_prop_write_writenorsp,                \
+         ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, OTA_ATTR_RSP, OTA_DATA_STORE_LEN, char_value,     \
+         ota_data_write_event, NULL)
+
+/* add a new service: 溫度通知與事件紀錄匯出 */
+#define TEMPERATURE_SERVICE_SCHEMA(SVC, CHAR, DESCR)                                                \
+    SVC(IDX_SVC2, GATTS_SERVICE_UUID_TEST2)                                                         \
+    CHAR(IDX_CHAR_A2, IDX_CHAR_VAL_A2, GATTS_CHAR_UUID_TEST_A2, char_prop_read_write_notify,        \
+         ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, ESP_GATT_AUTO_RSP, TEMPERATURE_VAL_LEN, char_value, \
+         NULL, NULL)                                                                                \
+    DESCR(IDX_CHAR_CFG_A2, character_client_config_uuid,                                            \
+          ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, ESP_GATT_AUTO_RSP, sizeof(uint16_t), temperature_measurement_ccc, \
+          temperature_cccd_write_event, NULL)                                                       \
+    CHAR(IDX_CHAR_B2, IDX_CHAR_VAL_B2, GATTS_CHAR_UUID_TEST_B2, char_prop_read_write,               \
+         ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, ESP_GATT_RSP_BY_APP, LOG_EXPORT_VAL_LEN, char_value, \
+         log_export_write_event, log_export_read_event)                                             \
+    CHAR(IDX_CHAR_C2, IDX_CHAR_VAL_C2, GATTS_CHAR_UUID_DIAG, char_prop_read_write,                  \
+         ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, ESP_GATT_RSP_BY_APP, DIAG_VAL_LEN, diag_id_value, \
+         diag_write_event, diag_read_event)
+
+/*
+  所有 service，依序建立: 前一個 service 啟動 (ESP_GATTS_START_EVT) 後才建立下一個屬性表，
+  每次啟動的 handle 相同。新增 service 只需一份清單與一行 SERVICE。
+    SERVICE(name, schema, idx_nb, on_created)
+  name 產生 name##_handle_table 等變數，idx_nb 為屬性數的 enum 名稱，
+  on_created 在屬性表建立後、service 啟動前呼叫 (例如註冊長寫入)，不需要時為 NULL
+*/
+#define GATTS_SERVICE_LIST(SERVICE)                                                                 \
+    SERVICE(ota, OTA_SERVICE_SCHEMA, HRS_IDX_NB, ota_service_created)                               \
+    SERVICE(temperature, TEMPERATURE_SERVICE_SCHEMA, HRS_IDX_NB2, NULL)
 
-/*add a new service*/
-enum
-{
-    IDX_SVC2,
-    IDX_CHAR_A2,
-    IDX_CHAR_VAL_A2,
-    IDX_CHAR_CFG_A2,
+#define SCHEMA_ENUM_SVC(idx, uuid)                                                          idx,
+#define SCHEMA_ENUM_CHAR(decl_idx, val_idx, uuid, prop, perm, rsp, max_len, value, on_write, on_read)  decl_idx, val_idx,
+#define SCHEMA_ENUM_DESCR(idx, uuid, perm, rsp, max_len, value, on_write, on_read)          idx,
 
-    IDX_CHAR_B2,
-    IDX_CHAR_VAL_B2,
+/* Attributes State Machine: 每個 service 一個 enum，屬性數為 idx_nb */
+#define SCHEMA_ENUM_SERVICE(name, schema, idx_nb, on_created)                                       \
+    enum { schema(SCHEMA_ENUM_SVC, SCHEMA_ENUM_CHAR, SCHEMA_ENUM_DESCR) idx_nb, };
 
-    HRS_IDX_NB2,
-};
+GATTS_SERVICE_LIST(SCHEMA_ENUM_SERVICE)
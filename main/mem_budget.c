@@ -0,0 +1,217 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  記憶體預算與 heap 水位
+
+  - cJSON 的配置改由靜態 pool 依序配置 (bump allocator)，free 不做事，一筆紀錄完成後整個 pool 重設；
+    pool 不足時改用 heap 並計數，可依 report 調整 MEM_BUDGET_JSON_POOL。
+    cJSON 的 hook 是全域設定，只在 mem_budget_json_begin() / end() 之間 (持有 json_lock) 使用 pool，
+    其他時間與其他模組的 cJSON 使用預設的 malloc/free
+  - 各階段開始時記下 heap_caps_get_minimum_free_size()，結束時若比開始時低，表示開機以來的最低水位
+    發生在該階段內，即為該階段的最小可用 heap (不需在每次配置時取樣)
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "cJSON.h"
+#include "diag.h"
+#include "mem_budget.h"
+
+#define MEM_BUDGET_MAGIC        0x4d454d42  // "MEMB"
+#define MEM_BUDGET_HEAP_CAPS    MALLOC_CAP_8BIT
+
+static const char *TAG = "mem_budget";
+
+static const char *phase_names[MEM_PHASE_NUM] = {
+    [MEM_PHASE_BOOT]      = "boot",
+    [MEM_PHASE_BLE_INIT]  = "ble_init",
+    [MEM_PHASE_OTA]       = "ota",
+    [MEM_PHASE_EVENT_LOG] = "event_log",
+};
+
+typedef struct {
+    uint32_t          magic;
+    mem_phase_stats_t phases[MEM_PHASE_NUM];
+} mem_budget_t;
+
+static portMUX_TYPE budget_lock = portMUX_INITIALIZER_UNLOCKED;
+static __NOINIT_ATTR mem_budget_t budget;
+static uint32_t phase_begin_min[MEM_PHASE_NUM];    // 階段開始時開機以來的最低水位
+
+#if MEM_BUDGET_STATIC
+static StaticSemaphore_t json_lock_buf;
+static SemaphoreHandle_t json_lock;     // 同時只有一筆紀錄使用 pool 與 hook
+static uint8_t json_pool[MEM_BUDGET_JSON_POOL] __attribute__((aligned(8)));
+static size_t json_used;
+static size_t json_peak;
+static uint32_t json_fallbacks;     // pool 不足改用 heap 的次數
+
+static void *json_malloc(size_t size)
+{
+    size = (size + 7) & ~7;
+    if (json_used + size > sizeof(json_pool)) {
+        json_fallbacks++;
+        return malloc(size);
+    }
+    void *ptr = &json_pool[json_used];
+    json_used += size;
+    if (json_used > json_peak) {
+        json_peak = json_used;
+    }
+    return ptr;
+}
+
+static void json_free(void *ptr)
+{
+    if ((uint8_t *)ptr < json_pool || (uint8_t *)ptr >= json_pool + sizeof(json_pool)) {
+        free(ptr);
+    }
+}
+#endif
+
+void mem_budget_json_begin(void)
+{
+#if MEM_BUDGET_STATIC
+    if (json_lock == NULL) {
+        // mem_budget_init() 之前使用預設的 malloc/free
+        return;
+    }
+    xSemaphoreTake(json_lock, portMAX_DELAY);
+    cJSON_Hooks hooks = {
+        .malloc_fn = json_malloc,
+        .free_fn = json_free,
+    };
+    cJSON_InitHooks(&hooks);
+#endif
+}
+
+void mem_budget_json_end(void)
+{
+#if MEM_BUDGET_STATIC
+    if (json_lock == NULL) {
+        return;
+    }
+    // 恢復預設的 malloc/free/realloc 後才重設 pool
+    cJSON_InitHooks(NULL);
+    json_used = 0;
+    xSemaphoreGive(json_lock);
+#endif
+}
+
+static void stats_update(mem_phase_stats_t *stats, uint32_t free_bytes, uint32_t largest)
+{
+    if (free_bytes < stats->min_free) {
+        stats->min_free = free_bytes;
+    }
+    if (largest < stats->min_largest_block) {
+        stats->min_largest_block = largest;
+    }
+}
+
+void mem_budget_phase_begin(mem_phase_t phase)
+{
+    uint32_t min_ever = heap_caps_get_minimum_free_size(MEM_BUDGET_HEAP_CAPS);
+    uint32_t free_bytes = heap_caps_get_free_size(MEM_BUDGET_HEAP_CAPS);
+    uint32_t largest = heap_caps_get_largest_free_block(MEM_BUDGET_HEAP_CAPS);
+
+    taskENTER_CRITICAL(&budget_lock);
+    phase_begin_min[phase] = min_ever;
+    budget.phases[phase].runs++;
+    stats_update(&budget.phases[phase], free_bytes, largest);
+    taskEXIT_CRITICAL(&budget_lock);
+}
+
+void mem_budget_sample(mem_phase_t phase)
+{
+    uint32_t free_bytes = heap_caps_get_free_size(MEM_BUDGET_HEAP_CAPS);
+    uint32_t largest = heap_caps_get_largest_free_block(MEM_BUDGET_HEAP_CAPS);
+
+    taskENTER_CRITICAL(&budget_lock);
+    stats_update(&budget.phases[phase], free_bytes, largest);
+    taskEXIT_CRITICAL(&budget_lock);
+}
+
+void mem_budget_phase_end(mem_phase_t phase)
+{
+    uint32_t min_ever = heap_caps_get_minimum_free_size(MEM_BUDGET_HEAP_CAPS);
+    uint32_t free_bytes = heap_caps_get_free_size(MEM_BUDGET_HEAP_CAPS);
+    uint32_t largest = heap_caps_get_largest_free_block(MEM_BUDGET_HEAP_CAPS);
+    uint32_t stack_free = uxTaskGetStackHighWaterMark(NULL);    // ESP-IDF 中單位為 bytes
+
+    taskENTER_CRITICAL(&budget_lock);
+    mem_phase_stats_t *stats = &budget.phases[phase];
+    if (min_ever < phase_begin_min[phase]) {
+        // 開機以來的最低水位在這個階段中更新
+        free_bytes = min_ever;
+    }
+    stats_update(stats, free_bytes, largest);
+    if (stack_free < stats->min_stack_free) {
+        stats->min_stack_free = stack_free;
+    }
+    taskEXIT_CRITICAL(&budget_lock);
+}
+
+static size_t mem_budget_diag_read(uint32_t offset, uint8_t *buf, size_t cap)
+{
+    if (offset >= sizeof(budget.phases)) {
+        return 0;
+    }
+    size_t len = sizeof(budget.phases) - offset;
+    if (len > cap) {
+        len = cap;
+    }
+    taskENTER_CRITICAL(&budget_lock);
+    memcpy(buf, (const uint8_t *)budget.phases + offset, len);
+    taskEXIT_CRITICAL(&budget_lock);
+    return len;
+}
+
+esp_err_t mem_budget_init(void)
+{
+#if MEM_BUDGET_STATIC
+    if (json_lock == NULL) {
+        json_lock = xSemaphoreCreateMutexStatic(&json_lock_buf);
+    }
+#endif
+    diag_register(DIAG_ID_MEM_BUDGET, mem_budget_diag_read);
+    if (budget.magic != MEM_BUDGET_MAGIC) {
+        // 上電後 RAM 內容無效
+        memset(&budget, 0, sizeof(budget));
+        for (int i = 0; i < MEM_PHASE_NUM; i++) {
+            budget.phases[i].min_free = UINT32_MAX;
+            budget.phases[i].min_largest_block = UINT32_MAX;
+            budget.phases[i].min_stack_free = UINT32_MAX;
+        }
+        budget.magic = MEM_BUDGET_MAGIC;
+    }
+    return ESP_OK;
+}
+
+void mem_budget_report(void)
+{
+    for (int i = 0; i < MEM_PHASE_NUM; i++) {
+        const mem_phase_stats_t *stats = &budget.phases[i];
+        if (stats->runs == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-9s min free %lu, min largest block %lu, min stack free %lu, %lu runs",
+                 phase_names[i], (unsigned long)stats->min_free, (unsigned long)stats->min_largest_block,
+                 (unsigned long)stats->min_stack_free, (unsigned long)stats->runs);
+    }
+#if MEM_BUDGET_STATIC
+    ESP_LOGI(TAG, "json pool peak %u / %u, %lu heap fallbacks",
+             (unsigned)json_peak, (unsigned)sizeof(json_pool), (unsigned long)json_fallbacks);
+#endif
+}
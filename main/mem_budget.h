@@ -0,0 +1,70 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  記憶體預算: 應用程式的緩衝區大小集中在此設定，各模組以靜態陣列配置，執行期間不從 heap 配置。
+  例外: LittleFS 由 SPIFFS 搬移紀錄 (只在第一次掛載時發生一次) 與 BLE 協議棧本身。
+*/
+#define MEM_BUDGET_STATIC               1       // 1: cJSON 使用 MEM_BUDGET_JSON_POOL，0: cJSON 使用 heap
+
+#define MEM_BUDGET_JSON_POOL            512     // 產生一筆事件紀錄的 cJSON 節點與字串
+#define MEM_BUDGET_EVENT_RECORD         160     // 一筆事件紀錄 (格式化後的 JSON) 的長度上限
+#define MEM_BUDGET_PREPARE_WRITE_BLOCKS 16      // 長寫入緩衝池，每塊 PREPARE_WRITE_BLOCK_SIZE bytes
+#define MEM_BUDGET_SEND_QUEUE_PACKETS   8       // notification/indication 送出佇列，每包最多 MTU - 3 bytes
+#define MEM_BUDGET_TEMP_SAMPLES         128     // 暫存的溫度樣本數，每筆 8 bytes
+#define MEM_BUDGET_L2CAP_SDUS           2       // OTA L2CAP CoC 接收緩衝，每個 OTA_L2CAP_SDU_SIZE bytes
+#define MEM_BUDGET_CHECK_STACK          3072    // 事件紀錄背景一致性檢查 task 的 stack
+
+/* 記錄 heap 水位的階段 */
+typedef enum {
+    MEM_PHASE_BOOT,         // app_main 到進入喚醒流程
+    MEM_PHASE_BLE_INIT,     // BLE host 初始化
+    MEM_PHASE_OTA,          // OTA 開始到結束或中止
+    MEM_PHASE_EVENT_LOG,    // 一筆事件紀錄的產生與寫入
+    MEM_PHASE_NUM,
+} mem_phase_t;
+
+/* 每個階段累計的最低水位，重新啟動後保留，斷電後清除 */
+typedef struct {
+    uint32_t min_free;          // 可用 heap 的最小值 (bytes)
+    uint32_t min_largest_block; // 最大連續可用區塊的最小值 (bytes)
+    uint32_t min_stack_free;    // 執行該階段的 task 剩餘 stack 的最小值 (bytes)
+    uint32_t runs;              // 進入該階段的次數
+} mem_phase_stats_t;
+
+/* 開機時呼叫: 建立 cJSON pool 的 lock 並以 DIAG_ID_MEM_BUDGET 提供各階段的統計 */
+esp_err_t mem_budget_init(void);
+
+void mem_budget_phase_begin(mem_phase_t phase);
+void mem_budget_phase_end(mem_phase_t phase);
+
+/* 階段進行中的檢查點 (例如每次 OTA 寫入)，只更新可用 heap 與最大連續區塊 */
+void mem_budget_sample(mem_phase_t phase);
+
+/*
+  一筆 cJSON 物件建立前呼叫 begin，刪除後呼叫 end。期間 cJSON 由 MEM_BUDGET_JSON_POOL 配置，
+  其他 task 的 begin 會等待；end 恢復預設的配置函數並釋放 pool 供下一筆使用
+*/
+void mem_budget_json_begin(void);
+void mem_budget_json_end(void);
+
+/* 印出各階段的水位與 cJSON pool 的最大用量 */
+void mem_budget_report(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,174 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  資料分區的 OTA: 每個 block 先比較 SHA-256，只抹除並寫入內容改變的 sector，
+  未改變的 block 不需傳輸也不會增加 flash 抹寫次數
+*/
+
+#include <stdbool.h>
+#include <string.h>
+#include "esp_log.h"
+#include "mbedtls/sha256.h"
+#include "flash_meter.h"
+#include "ota_data.h"
+
+#define OTA_DATA_READ_CHUNK     256     // 計算 flash 中 block 的 SHA-256 時每次讀取的長度
+
+static const char *TAG = "ota_data";
+
+static const esp_partition_t *data_partition;
+static bool in_block;                   // 已收到 header，正在接收 block 內容
+static uint32_t block_offset;
+static uint32_t block_pos;              // block 內已寫入的長度
+static uint8_t block_hash[OTA_DATA_HASH_LEN];
+static mbedtls_sha256_context block_ctx;
+static uint32_t blocks, skipped, written, mismatched;
+static uint32_t flash_bytes;            // 寫入 flash 的 block 內容長度
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* 計算 flash 中 offset 開始一個 block 的 SHA-256 */
+static esp_err_t flash_block_hash(uint32_t offset, uint8_t *hash)
+{
+    uint8_t chunk[OTA_DATA_READ_CHUNK];
+    mbedtls_sha256_context ctx;
+    esp_err_t err = ESP_OK;
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    for (uint32_t pos = 0; pos < OTA_DATA_BLOCK_SIZE; pos += sizeof(chunk)) {
+        err = esp_partition_read(data_partition, offset + pos, chunk, sizeof(chunk));
+        if (err != ESP_OK) {
+            break;
+        }
+        mbedtls_sha256_update(&ctx, chunk, sizeof(chunk));
+    }
+    mbedtls_sha256_finish(&ctx, hash);
+    mbedtls_sha256_free(&ctx);
+    return err;
+}
+
+/* 收到 block header: flash 內容相同時略過，否則抹除該 sector 準備寫入 */
+static ota_status_t feed_header(const uint8_t *data, uint16_t len)
+{
+    uint8_t flash_hash[OTA_DATA_HASH_LEN];
+
+    if (len != OTA_DATA_HEADER_LEN) {
+        ESP_LOGE(TAG, "block header must be %d bytes, got %d", OTA_DATA_HEADER_LEN, len);
+        return OTA_STATUS_BAD_BLOCK;
+    }
+    block_offset = get_le32(data);
+    if (block_offset % OTA_DATA_BLOCK_SIZE || block_offset >= data_partition->size ||
+        data_partition->size - block_offset < OTA_DATA_BLOCK_SIZE) {
+        ESP_LOGE(TAG, "bad block offset 0x%lx", (unsigned long)block_offset);
+        return OTA_STATUS_TOO_LARGE;
+    }
+    memcpy(block_hash, data + 4, OTA_DATA_HASH_LEN);
+    blocks++;
+
+    esp_err_t err = flash_block_hash(block_offset, flash_hash);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "read block 0x%lx failed (%s)", (unsigned long)block_offset, esp_err_to_name(err));
+        return OTA_STATUS_FLASH_ERROR;
+    }
+    if (memcmp(flash_hash, block_hash, OTA_DATA_HASH_LEN) == 0) {
+        ESP_LOGD(TAG, "block 0x%lx unchanged", (unsigned long)block_offset);
+        skipped++;
+        return OTA_STATUS_BLOCK_UNCHANGED;
+    }
+    err = esp_partition_erase_range(data_partition, block_offset, OTA_DATA_BLOCK_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "erase block 0x%lx failed (%s)", (unsigned long)block_offset, esp_err_to_name(err));
+        return OTA_STATUS_FLASH_ERROR;
+    }
+    mbedtls_sha256_init(&block_ctx);
+    mbedtls_sha256_starts(&block_ctx, 0);
+    block_pos = 0;
+    in_block = true;
+    return OTA_STATUS_OK;
+}
+
+/* 收到 block 內容: 直接寫入 flash，收滿一個 block 時核對 SHA-256 */
+static ota_status_t feed_block(const uint8_t *data, uint16_t len)
+{
+    uint8_t hash[OTA_DATA_HASH_LEN];
+
+    if (block_pos + len > OTA_DATA_BLOCK_SIZE) {
+        ESP_LOGE(TAG, "block 0x%lx overflow (%lu + %d)", (unsigned long)block_offset, (unsigned long)block_pos, len);
+        return OTA_STATUS_BAD_BLOCK;
+    }
+    esp_err_t err = esp_partition_write(data_partition, block_offset + block_pos, data, len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "write block 0x%lx failed (%s)", (unsigned long)block_offset, esp_err_to_name(err));
+        return OTA_STATUS_FLASH_ERROR;
+    }
+    flash_meter_logical(data_partition->label, len);
+    flash_bytes += len;
+    mbedtls_sha256_update(&block_ctx, data, len);
+    block_pos += len;
+    if (block_pos < OTA_DATA_BLOCK_SIZE) {
+        return OTA_STATUS_OK;
+    }
+
+    in_block = false;
+    mbedtls_sha256_finish(&block_ctx, hash);
+    mbedtls_sha256_free(&block_ctx);
+    if (memcmp(hash, block_hash, OTA_DATA_HASH_LEN) != 0) {
+        ESP_LOGW(TAG, "block 0x%lx hash mismatch", (unsigned long)block_offset);
+        mismatched++;
+        return OTA_STATUS_BLOCK_HASH;
+    }
+    written++;
+    return OTA_STATUS_OK;
+}
+
+void ota_data_begin(const esp_partition_t *part)
+{
+    if (in_block) {
+        mbedtls_sha256_free(&block_ctx);
+    }
+    data_partition = part;
+    in_block = false;
+    blocks = 0;
+    skipped = 0;
+    written = 0;
+    mismatched = 0;
+    flash_bytes = 0;
+}
+
+ota_status_t ota_data_feed(const uint8_t *data, uint16_t len)
+{
+    return in_block ? feed_block(data, len) : feed_header(data, len);
+}
+
+ota_status_t ota_data_end(void)
+{
+    if (in_block) {
+        ESP_LOGE(TAG, "block 0x%lx incomplete (%lu bytes)", (unsigned long)block_offset, (unsigned long)block_pos);
+        mbedtls_sha256_free(&block_ctx);
+        in_block = false;
+        return OTA_STATUS_BAD_BLOCK;
+    }
+    return OTA_STATUS_OK;
+}
+
+uint32_t ota_data_flash_bytes(void)
+{
+    return flash_bytes;
+}
+
+void ota_data_report(void)
+{
+    ESP_LOGI(TAG, "%s: %lu blocks, %lu unchanged, %lu written, %lu hash mismatch",
+             data_partition ? data_partition->label : "-", (unsigned long)blocks, (unsigned long)skipped,
+             (unsigned long)written, (unsigned long)mismatched);
+}
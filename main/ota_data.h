@@ -0,0 +1,63 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "ota_update.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  資料分區 (例如 storage) 的 OTA: 映像切成 OTA_DATA_BLOCK_SIZE 的 block (不足補 0xFF)，
+  每個 block 先寫入一個 header，設備比較 flash 中該 sector 的 SHA-256，相同時以
+  OTA_STATUS_BLOCK_UNCHANGED 回應，client 略過這個 block；不同時抹除該 sector，
+  client 接著寫入 OTA_DATA_BLOCK_SIZE bytes 的內容 (可分多次寫入)。
+  結果也是 OTA Control 的狀態碼，以寫入命令送出 header 時 client 讀取 OTA Control 得知。
+
+  block header (little endian，需以單次寫入送出，MTU 至少 OTA_DATA_HEADER_LEN + 3):
+  | offset | size | 內容                                      |
+  |--------|------|-------------------------------------------|
+  | 0      | 4    | block 在分區中的位置，OTA_DATA_BLOCK_SIZE 的倍數 |
+  | 4      | 32   | block 新內容的 SHA-256                     |
+*/
+#define OTA_DATA_BLOCK_SIZE     4096    // 與 flash sector 相同，每個 block 獨立抹除
+#define OTA_DATA_HASH_LEN       32
+#define OTA_DATA_HEADER_LEN     (4 + OTA_DATA_HASH_LEN)
+
+/* 開始更新分區 part，清除上一次的進度與統計 */
+void ota_data_begin(const esp_partition_t *part);
+
+/*
+  收到 OTA Data 時呼叫，依目前進度解讀為 block header 或 block 內容。
+  @return OTA_STATUS_BLOCK_UNCHANGED: block 與 flash 相同，不需傳送內容
+          OTA_STATUS_BLOCK_HASH: block 寫入完成但內容與 header 的 SHA-256 不符，client 可重送這個 block
+          其他非 OTA_STATUS_OK 的狀態碼表示無法繼續
+*/
+ota_status_t ota_data_feed(const uint8_t *data, uint16_t len);
+
+/*
+  OTA_CONTROL_END 時呼叫，最後一個 block 尚未收完時回傳 OTA_STATUS_BAD_BLOCK。
+  SHA-256 不符的 block 已在寫入回應與 OTA Control 的狀態碼中回報，由 client 決定是否重送
+*/
+ota_status_t ota_data_end(void);
+
+/* ota_data_begin() 之後寫入 flash 的長度 (不含 header 與略過的 block) */
+uint32_t ota_data_flash_bytes(void);
+
+/* 印出 block 總數、略過與寫入的 block 數 */
+void ota_data_report(void);
+
+#ifdef __cplusplus
+}
+#endif
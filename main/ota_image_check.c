@@ -0,0 +1,120 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  OTA 映像開頭檢查
+
+  映像格式: esp_image_header_t，接著第一個 segment (DROM) 的 esp_image_segment_header_t，
+  segment 資料開頭即為 esp_app_desc_t。原本要等整個檔案傳完，esp_ota_end() 才會發現映像錯誤，
+  改為收到開頭的 OTA_IMAGE_CHECK_LEN bytes 就檢查，不符時立即中止。
+  與目前韌體的比較 (版本、eFuse secure version) 由 ota_image_policy_t 提供，這個檔案只解讀映像格式。
+*/
+
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "ota_image_check.h"
+
+static const char *TAG = "ota_image_check";
+
+static uint8_t head_buf[OTA_IMAGE_CHECK_LEN];
+static uint16_t head_len;
+static bool head_checked;
+static const ota_image_policy_t *head_policy;
+
+static ota_status_t check_image_header(const esp_image_header_t *header)
+{
+    if (header->segment_count == 0 || header->segment_count > ESP_IMAGE_MAX_SEGMENTS) {
+        ESP_LOGE(TAG, "invalid segment count %d", header->segment_count);
+        return OTA_STATUS_BAD_SEGMENT;
+    }
+    if (header->chip_id != CONFIG_IDF_FIRMWARE_CHIP_ID) {
+        ESP_LOGE(TAG, "image chip id %d, expected %d", header->chip_id, CONFIG_IDF_FIRMWARE_CHIP_ID);
+        return OTA_STATUS_BAD_CHIP;
+    }
+    return OTA_STATUS_OK;
+}
+
+static ota_status_t check_app_desc(const esp_app_desc_t *desc, const ota_image_policy_t *policy)
+{
+    if (desc->magic_word != ESP_APP_DESC_MAGIC_WORD) {
+        ESP_LOGE(TAG, "app desc magic word 0x%lx", (unsigned long)desc->magic_word);
+        return OTA_STATUS_BAD_APP_DESC;
+    }
+    if (policy && policy->secure_version_ok && !policy->secure_version_ok(desc->secure_version)) {
+        ESP_LOGE(TAG, "secure version %lu is lower than eFuse", (unsigned long)desc->secure_version);
+        return OTA_STATUS_SECURE_VERSION;
+    }
+    if (policy && policy->running_version &&
+        strncmp(desc->version, policy->running_version, sizeof(desc->version)) == 0) {
+        ESP_LOGW(TAG, "version %.32s is already running", desc->version);
+        return OTA_STATUS_SAME_VERSION;
+    }
+    ESP_LOGI(TAG, "new firmware version %.32s", desc->version);
+    return OTA_STATUS_OK;
+}
+
+ota_status_t ota_image_check(const uint8_t *head, size_t len, const ota_image_policy_t *policy)
+{
+    const size_t segment_offset = sizeof(esp_image_header_t);
+    const size_t desc_offset = segment_offset + sizeof(esp_image_segment_header_t);
+    ota_status_t status;
+
+    if (len >= 1 && head[0] != ESP_IMAGE_HEADER_MAGIC) {
+        ESP_LOGE(TAG, "image magic 0x%02x", head[0]);
+        return OTA_STATUS_BAD_MAGIC;
+    }
+    if (len >= segment_offset) {
+        esp_image_header_t header;
+        memcpy(&header, head, sizeof(header));
+        status = check_image_header(&header);
+        if (status != OTA_STATUS_OK) {
+            return status;
+        }
+    }
+    if (len >= desc_offset) {
+        esp_image_segment_header_t segment;
+        memcpy(&segment, head + segment_offset, sizeof(segment));
+        if (segment.data_len < sizeof(esp_app_desc_t)) {
+            ESP_LOGE(TAG, "first segment too short (%lu)", (unsigned long)segment.data_len);
+            return OTA_STATUS_BAD_SEGMENT;
+        }
+    }
+    if (len >= OTA_IMAGE_CHECK_LEN) {
+        esp_app_desc_t desc;
+        memcpy(&desc, head + desc_offset, sizeof(desc));
+        return check_app_desc(&desc, policy);
+    }
+    return OTA_STATUS_OK;
+}
+
+void ota_image_check_begin(const ota_image_policy_t *policy)
+{
+    head_policy = policy;
+    head_len = 0;
+    head_checked = false;
+}
+
+ota_status_t ota_image_check_feed(const uint8_t *data, uint16_t len)
+{
+    if (head_checked) {
+        return OTA_STATUS_OK;
+    }
+    uint16_t copy = OTA_IMAGE_CHECK_LEN - head_len;
+    if (copy > len) {
+        copy = len;
+    }
+    memcpy(head_buf + head_len, data, copy);
+    head_len += copy;
+
+    ota_status_t status = ota_image_check(head_buf, head_len, head_policy);
+    if (status == OTA_STATUS_OK && head_len == OTA_IMAGE_CHECK_LEN) {
+        head_checked = true;
+    }
+    return status;
+}
@@ -0,0 +1,52 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_app_format.h"
+#include "ota_update.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 映像開頭需檢查的長度: image header + 第一個 segment header + app 描述 */
+#define OTA_IMAGE_CHECK_LEN     (sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t))
+
+/*
+  1: 版本與目前執行的韌體相同時拒絕更新。預設關閉: 版本字串未更新的建置 (例如同一個 git tag 的修正)
+  或重新安裝同一版本修復 flash 時不應被拒絕
+*/
+#define OTA_IMAGE_SKIP_SAME_VERSION     0
+
+/*
+  與目前執行的韌體比較的條件，由呼叫端以 ESP-IDF 取得，檢查本身不依賴 IDF 的執行環境 (可在主機測試)
+*/
+typedef struct {
+    const char *running_version;                        // 版本相同時拒絕，NULL 表示不比較
+    bool      (*secure_version_ok)(uint32_t version);   // anti-rollback 檢查，NULL 表示不檢查
+} ota_image_policy_t;
+
+/*
+  檢查映像開頭 head[0..len)，len 可小於 OTA_IMAGE_CHECK_LEN，只檢查已收到的部分。
+  policy 可為 NULL (只檢查格式)。通過 (或資料還不足以判斷) 時回傳 OTA_STATUS_OK
+*/
+ota_status_t ota_image_check(const uint8_t *head, size_t len, const ota_image_policy_t *policy);
+
+/* esp_ota_begin() 後呼叫，清除已收到的映像開頭，之後以 policy 檢查 (需在 OTA 期間有效) */
+void ota_image_check_begin(const ota_image_policy_t *policy);
+
+/* 收到 OTA Data 時呼叫，收集映像開頭並檢查，收齊並通過後不再檢查 */
+ota_status_t ota_image_check_feed(const uint8_t *data, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  OTA 映像經 L2CAP CoC 傳輸: 一個 SDU 可達 OTA_L2CAP_SDU_SIZE bytes，沒有 ATT header 與每次寫入的回呼，
+  流量控制由 credit 處理 (SDU 寫入 flash 後才交還接收緩衝，送端自然被擋住)
+*/
+
+#include "esp_log.h"
+#include "ota_update.h"
+#include "ota_l2cap.h"
+
+#if OTA_L2CAP_SUPPORTED
+#include "host/ble_hs.h"
+#include "host/ble_l2cap.h"
+#endif
+
+static const char *TAG = "ota_l2cap";
+
+#if OTA_L2CAP_SUPPORTED
+
+static os_membuf_t sdu_mem[OS_MEMPOOL_SIZE(OTA_L2CAP_SDU_NUM, OTA_L2CAP_SDU_SIZE)];
+static struct os_mempool sdu_mempool;
+static struct os_mbuf_pool sdu_mbuf_pool;
+static uint8_t sdu_buf[OTA_L2CAP_SDU_SIZE];    // mbuf chain 攤平後寫入 flash
+static bool l2cap_ready;
+
+/* 交給 NimBLE 一個新的接收緩衝 (即補發 credit) */
+static int sdu_recv_ready(struct ble_l2cap_chan *chan)
+{
+    struct os_mbuf *sdu_rx = os_mbuf_get_pkthdr(&sdu_mbuf_pool, 0);
+    if (sdu_rx == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+    return ble_l2cap_recv_ready(chan, sdu_rx);
+}
+
+static void sdu_received(uint16_t conn_handle, struct ble_l2cap_chan *chan, struct os_mbuf *sdu)
+{
+    uint16_t len = OS_MBUF_PKTLEN(sdu);
+    esp_err_t err = ESP_ERR_INVALID_SIZE;
+
+    if (sdu->om_len == len) {
+        // SDU 在單一 mbuf 中，不需複製
+        err = ota_update_data(conn_handle, sdu->om_data, len);
+    } else if (len <= sizeof(sdu_buf) && os_mbuf_copydata(sdu, 0, len, sdu_buf) == 0) {
+        ota_update_count_copy(conn_handle, len);
+        err = ota_update_data(conn_handle, sdu_buf, len);
+    }
+    os_mbuf_free_chain(sdu);
+    if (err != ESP_OK) {
+        // 中止原因已記錄在 OTA Control，關閉通道讓 client 停止傳送
+        ESP_LOGE(TAG, "conn %d sdu %d bytes rejected (%s)", conn_handle, len, esp_err_to_name(err));
+        ble_l2cap_disconnect(chan);
+        return;
+    }
+    sdu_recv_ready(chan);
+}
+
+static int l2cap_event(struct ble_l2cap_event *event, void *arg)
+{
+    switch (event->type) {
+    case BLE_L2CAP_EVENT_COC_ACCEPT:
+        if (!ota_update_is_active(event->accept.conn_handle, OTA_TRANSPORT_L2CAP)) {
+            ESP_LOGW(TAG, "conn %d coc without ota begin, rejected", event->accept.conn_handle);
+            return BLE_HS_EREJECT;
+        }
+        return sdu_recv_ready(event->accept.chan);
+    case BLE_L2CAP_EVENT_COC_CONNECTED:
+        ESP_LOGI(TAG, "conn %d coc connected, status %d", event->connect.conn_handle, event->connect.status);
+        return 0;
+    case BLE_L2CAP_EVENT_COC_DISCONNECTED:
+        ESP_LOGI(TAG, "conn %d coc disconnected", event->disconnect.conn_handle);
+        return 0;
+    case BLE_L2CAP_EVENT_COC_DATA_RECEIVED:
+        sdu_received(event->receive.conn_handle, event->receive.chan, event->receive.sdu_rx);
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+esp_err_t ota_l2cap_init(void)
+{
+    int rc = os_mempool_init(&sdu_mempool, OTA_L2CAP_SDU_NUM, OTA_L2CAP_SDU_SIZE, sdu_mem, "ota_sdu");
+    if (rc == 0) {
+        rc = os_mbuf_pool_init(&sdu_mbuf_pool, &sdu_mempool, OTA_L2CAP_SDU_SIZE, OTA_L2CAP_SDU_NUM);
+    }
+    if (rc == 0) {
+        rc = ble_l2cap_create_server(OTA_L2CAP_PSM, OTA_L2CAP_SDU_SIZE, l2cap_event, NULL);
+    }
+    if (rc != 0) {
+        ESP_LOGE(TAG, "create coc server failed, rc = %d", rc);
+        return ESP_FAIL;
+    }
+    l2cap_ready = true;
+    ESP_LOGI(TAG, "ota coc server on psm 0x%04x, sdu %d", OTA_L2CAP_PSM, OTA_L2CAP_SDU_SIZE);
+    return ESP_OK;
+}
+
+bool ota_l2cap_available(void)
+{
+    return l2cap_ready;
+}
+
+#else
+
+esp_err_t ota_l2cap_init(void)
+{
+    ESP_LOGI(TAG, "l2cap coc not supported by this bluetooth host, ota uses gatt only");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+bool ota_l2cap_available(void)
+{
+    return false;
+}
+
+#endif
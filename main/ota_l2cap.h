@@ -0,0 +1,43 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "mem_budget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* LE credit-based L2CAP CoC 只有 NimBLE 提供 API，Bluedroid 下只使用 GATT 傳輸 */
+#if defined(CONFIG_BT_NIMBLE_ENABLED) && CONFIG_BT_NIMBLE_L2CAP_COC_MAX_NUM > 0
+#define OTA_L2CAP_SUPPORTED     1
+#else
+#define OTA_L2CAP_SUPPORTED     0
+#endif
+
+#define OTA_L2CAP_PSM           0x0081  // LE 動態 PSM 範圍 0x0080 ~ 0x00FF
+#define OTA_L2CAP_SDU_SIZE      2048    // 每個 SDU 最大長度，收完一個 SDU 寫入 flash 後才補發 credit
+#define OTA_L2CAP_SDU_NUM       MEM_BUDGET_L2CAP_SDUS   // 接收緩衝的 SDU 數量
+
+/*
+  建立 OTA 用的 L2CAP CoC server，需在 BLE host 啟動後呼叫。
+  只接受已寫入 OTA_CONTROL_BEGIN_L2CAP 的連線，收到的 SDU 直接交給 ota_update_data()
+  @return 不支援時回傳 ESP_ERR_NOT_SUPPORTED
+*/
+esp_err_t ota_l2cap_init(void);
+
+/* L2CAP CoC 傳輸是否可用 */
+bool ota_l2cap_available(void);
+
+#ifdef __cplusplus
+}
+#endif
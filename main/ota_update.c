@@ -0,0 +1,341 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  Silicon Labs OTA 流程: 寫 OTA Control 0 開始，透過 OTA Data 分段傳輸檔案，寫 OTA Control 3 結束並重新啟動
+  支援 L2CAP CoC 的 client 可改寫 OTA Control 0x10 開始，映像改由 CoC 傳輸，結束方式相同
+  開始時多寫 1 byte 的目標可改為更新資料分區，資料以 block 傳輸並略過內容未改變的 block (見 ota_data.h)
+*/
+
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_efuse.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_ota_ops.h"
+#include "esp_flash_partitions.h"
+#include "esp_partition.h"
+#include "event_store.h"
+#include "fast_boot.h"
+#include "flash_meter.h"
+#include "mem_budget.h"
+#include "ota_data.h"
+#include "ota_l2cap.h"
+#include "ota_image_check.h"
+#include "ota_update.h"
+
+#define OTA_MEM_SAMPLE_WRITES   16      // 每幾次寫入取樣一次 heap 水位 (取最大連續區塊需走訪 heap)
+
+static const char *TAG = "ota_update";
+
+/*
+   update handle : set by esp_ota_begin(), must be freed via esp_ota_end(); esp_ota_begin()回傳的hundle，後續用於esp_ota_write()和esp_ota_end()
+*/
+static esp_ota_handle_t update_handle = 0;
+/*update_partition: 要進行放置更新韌體的分區*/
+static const esp_partition_t *update_partition = NULL;
+static bool ota_started = false;
+static uint16_t ota_owner;      // 進行 OTA 的連線，OTA 期間其他連線不能寫入
+static uint32_t ota_received;   // 收到的 OTA 資料長度
+static uint32_t ota_written;    // 已寫入 update partition 的長度 (app)，資料分區由 ota_data 統計
+static uint32_t ota_writes;     // 寫入次數
+static uint32_t ota_copied;     // 應用程式在交給 ota_update_data() 前複製的長度 (見 ota_update_count_copy())
+static ota_transport_t ota_transport;
+static ota_target_t ota_target;
+static ota_status_t ota_status = OTA_STATUS_OK;
+static ota_image_policy_t image_policy;
+
+/*
+  印出本次 OTA 收到的資料量、應用程式複製的次數 (每 byte) 與實際寫入 flash 的資料量
+  (資料分區略過未改變的 block 時小於 1)。BLE 堆棧內部的複製 (HCI、L2CAP 重組) 不計入
+*/
+static void ota_report_transfer(void)
+{
+    uint32_t flash_bytes = ota_target == OTA_TARGET_STORAGE ? ota_data_flash_bytes() : ota_written;
+    uint32_t flash_per_100 = ota_received ? (uint64_t)flash_bytes * 100 / ota_received : 0;
+    uint32_t copies_per_100 = ota_received ? (uint64_t)ota_copied * 100 / ota_received : 0;
+    ESP_LOGI(TAG, "%s %lu bytes received in %lu writes, %lu.%02lu copies/byte (app only), "
+             "%lu bytes written to flash, %lu.%02lu flash bytes/byte",
+             ota_transport == OTA_TRANSPORT_L2CAP ? "l2cap" : "gatt", (unsigned long)ota_received,
+             (unsigned long)ota_writes, (unsigned long)(copies_per_100 / 100), (unsigned long)(copies_per_100 % 100),
+             (unsigned long)flash_bytes, (unsigned long)(flash_per_100 / 100), (unsigned long)(flash_per_100 % 100));
+    if (ota_target == OTA_TARGET_STORAGE) {
+        ota_data_report();
+    }
+}
+
+/*
+  捨棄進行中的 OTA，資料分區已寫入的 block 保留，重新開始時比較 hash 即可略過。
+  資料分區只寫了一部分，事件紀錄維持停用 (重新啟動後也不掛載)，直到有一次傳輸完成
+*/
+static void ota_abort(void)
+{
+    if (ota_target != OTA_TARGET_STORAGE) {
+        esp_ota_abort(update_handle);
+    }
+    ota_started = false;
+}
+
+/* OTA 中止並記錄原因 */
+static void ota_fail(ota_status_t status)
+{
+    if (ota_started) {
+        ota_abort();
+    }
+    ota_status = status;
+    ota_report_transfer();
+    mem_budget_phase_end(MEM_PHASE_OTA);
+}
+
+/* 開始更新資料分區，只支援 GATT 傳輸 (block header 需以寫入回應告知是否略過) */
+static esp_err_t ota_begin_storage(uint8_t value)
+{
+    if (value == OTA_CONTROL_BEGIN_L2CAP) {
+        ESP_LOGW(TAG, "data partition update over l2cap not supported");
+        ota_status = OTA_STATUS_NO_TRANSPORT;
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    update_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, EVENT_STORE_PARTITION);
+    if (update_partition == NULL) {
+        ESP_LOGE(TAG, "Failed to find partition %s", EVENT_STORE_PARTITION);
+        ota_status = OTA_STATUS_BAD_TARGET;
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (event_store_suspend() != ESP_OK) {
+        ESP_LOGW(TAG, "%s is busy", EVENT_STORE_PARTITION);
+        ota_status = OTA_STATUS_BAD_TARGET;
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGI(TAG, "Writing to partition %s subtype %d at offset 0x%lx", update_partition->label, update_partition->subtype, update_partition->address);
+    ota_data_begin(update_partition);
+    return ESP_OK;
+}
+
+#if CONFIG_BOOTLOADER_APP_ANTI_ROLLBACK
+static bool secure_version_ok(uint32_t version)
+{
+    return esp_efuse_check_secure_version(version);
+}
+#endif
+
+/* 新映像與目前執行的韌體比較的條件 */
+static const ota_image_policy_t *ota_image_policy(void)
+{
+#if OTA_IMAGE_SKIP_SAME_VERSION
+    image_policy.running_version = esp_app_get_description()->version;
+#endif
+#if CONFIG_BOOTLOADER_APP_ANTI_ROLLBACK
+    image_policy.secure_version_ok = secure_version_ok;
+#endif
+    return &image_policy;
+}
+
+/* 開始更新下一個 OTA app 分區 */
+static esp_err_t ota_begin_app(void)
+{
+    // 讀取下一個partition內容，例如: type: 0, subtype 17, address: 190000, size: 180000, erase size: 1000, label: ota_1, encrypted: 0
+    update_partition = esp_ota_get_next_update_partition(NULL);
+    assert(update_partition != NULL);
+    /*
+      update_partition->subtype: partition subtype;
+      update_partition->address: starting address of the partition in flash
+    */
+    ESP_LOGI(TAG, "Writing to partition %s subtype %d at offset 0x%lx", update_partition->label, update_partition->subtype, update_partition->address);
+    // OTA_WITH_SEQUENTIAL_WRITES: Used for esp_ota_begin() if new image size is unknown and erase can be done in incremental manner (assuming write operation is in continuous sequence)
+    esp_err_t err = esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &update_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_begin failed (%s)", esp_err_to_name(err));
+        ota_fail(OTA_STATUS_FLASH_ERROR);
+        return err;
+    }
+    ota_image_check_begin(ota_image_policy());
+    return ESP_OK;
+}
+
+esp_err_t ota_update_control(uint16_t conn_id, const uint8_t *data, uint16_t len)
+{
+    esp_err_t err;
+    uint8_t value = data[0];
+    ota_target_t target = len > 1 ? (ota_target_t)data[1] : OTA_TARGET_APP;
+
+    ESP_LOGI(TAG, "conn %d ota-control = %d target %d", conn_id, value, target);
+    if (ota_started && ota_owner != conn_id) {
+        // 只以寫入回應拒絕，ota_status 屬於進行中的 OTA，不能被其他連線改變
+        ESP_LOGW(TAG, "ota is owned by conn %d", ota_owner);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (value == OTA_CONTROL_BEGIN_L2CAP && !ota_l2cap_available()) {
+        ESP_LOGW(TAG, "l2cap transport not available");
+        ota_status = OTA_STATUS_NO_TRANSPORT;
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (value == OTA_CONTROL_BEGIN || value == OTA_CONTROL_BEGIN_L2CAP) {
+        if (target != OTA_TARGET_APP && target != OTA_TARGET_STORAGE) {
+            ESP_LOGW(TAG, "unknown ota target %d", target);
+            ota_status = OTA_STATUS_BAD_TARGET;
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        if (ota_started) {
+            // 同一連線重新開始，捨棄先前寫入的資料
+            ota_abort();
+        }
+        ESP_LOGI(TAG, "======beginota======");
+        ota_target = target;
+        ota_received = 0;
+        ota_written = 0;
+        ota_writes = 0;
+        ota_copied = 0;
+        err = target == OTA_TARGET_STORAGE ? ota_begin_storage(value) : ota_begin_app();
+        if (err != ESP_OK) {
+            return err;
+        }
+        ota_started = true;
+        ota_owner = conn_id;
+        ota_transport = value == OTA_CONTROL_BEGIN_L2CAP ? OTA_TRANSPORT_L2CAP : OTA_TRANSPORT_GATT;
+        ota_status = OTA_STATUS_OK;
+        mem_budget_phase_begin(MEM_PHASE_OTA);
+    } else if (value == OTA_CONTROL_END) {
+        if (!ota_started) {
+            ota_status = OTA_STATUS_NOT_STARTED;
+            return ESP_ERR_INVALID_STATE;
+        }
+        ESP_LOGI(TAG, "======endota======");
+        if (ota_target == OTA_TARGET_STORAGE) {
+            ota_status_t status = ota_data_end();
+            if (status != OTA_STATUS_OK) {
+                ota_fail(status);
+                return ESP_ERR_INVALID_STATE;
+            }
+            // 分區內容已直接寫入，清除更新中的旗標後重新啟動，以新內容掛載
+            if (event_store_resume() != ESP_OK) {
+                // 旗標仍在時重新啟動也不會掛載，OTA 維持進行中，client 可再寫入 OTA_CONTROL_END
+                ota_status = OTA_STATUS_FLASH_ERROR;
+                return ESP_FAIL;
+            }
+            ota_started = false;
+            ota_report_transfer();
+            mem_budget_phase_end(MEM_PHASE_OTA);
+            flash_meter_save();
+            ESP_LOGI(TAG, "Prepare to restart system!");
+            esp_restart();
+        }
+        ota_started = false;
+        err = esp_ota_end(update_handle);
+        if (err != ESP_OK) {
+            if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
+                ESP_LOGE(TAG, "Image validation failed, image is corrupted");
+            }
+            ESP_LOGE(TAG, "esp_ota_end failed (%s)!", esp_err_to_name(err));
+        } else {
+            err = esp_ota_set_boot_partition(update_partition);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "esp_ota_set_boot_partition failed (%s)!", esp_err_to_name(err));
+            } else {
+                // esp_ota_end() 已完整驗證映像，bootloader 與第一次啟動都不需再驗證
+                fast_boot_record_verified(update_partition);
+            }
+        }
+        ota_report_transfer();
+        mem_budget_phase_end(MEM_PHASE_OTA);
+        flash_meter_save();
+        ESP_LOGI(TAG, "Prepare to restart system!");
+        esp_restart();
+    }
+    return ESP_OK;
+}
+
+esp_err_t ota_update_data(uint16_t conn_id, const uint8_t *data, uint16_t len)
+{
+    if (!ota_started || ota_owner != conn_id) {
+        ESP_LOGW(TAG, "conn %d ota-data without ota begin, ignored", conn_id);
+        // 已中止的 OTA 保留中止原因，client 可讀取 OTA Control 得知
+        if (!ota_started && ota_status == OTA_STATUS_OK) {
+            ota_status = OTA_STATUS_NOT_STARTED;
+        }
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGD(TAG, "ota-data = %d", len);
+    ota_received += len;
+    if (++ota_writes % OTA_MEM_SAMPLE_WRITES == 0) {
+        mem_budget_sample(MEM_PHASE_OTA);
+    }
+    if (ota_target == OTA_TARGET_STORAGE) {
+        ota_status_t status = ota_data_feed(data, len);
+        if (status == OTA_STATUS_BLOCK_UNCHANGED || status == OTA_STATUS_BLOCK_HASH) {
+            // 以寫入回應告知 client 略過或重送這個 block，OTA 繼續 (以寫入命令送出時由 OTA Control 讀取)
+            ota_status = status;
+            return ESP_FAIL;
+        }
+        if (status != OTA_STATUS_OK) {
+            ota_fail(status);
+            return ESP_FAIL;
+        }
+        ota_status = OTA_STATUS_OK;
+        return ESP_OK;
+    }
+    if (ota_written + len > update_partition->size) {
+        ESP_LOGE(TAG, "image exceeds partition size 0x%lx", update_partition->size);
+        ota_fail(OTA_STATUS_TOO_LARGE);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    ota_status_t status = ota_image_check_feed(data, len);
+    if (status != OTA_STATUS_OK) {
+        ESP_LOGE(TAG, "image rejected (0x%02x), abort", status);
+        ota_fail(status);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    esp_err_t err = esp_ota_write(update_handle, (const void *)data, len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_write error (%s)!", esp_err_to_name(err));
+        ota_fail(OTA_STATUS_FLASH_ERROR);
+        return err;
+    }
+    ota_written += len;
+    flash_meter_logical(update_partition->label, len);
+    return ESP_OK;
+}
+
+void ota_update_count_copy(uint16_t conn_id, uint32_t len)
+{
+    if (ota_started && ota_owner == conn_id) {
+        ota_copied += len;
+    }
+}
+
+ota_status_t ota_update_get_status(uint16_t conn_id)
+{
+    if (ota_started && ota_owner != conn_id) {
+        return OTA_STATUS_NOT_STARTED;
+    }
+    return ota_status;
+}
+
+bool ota_update_is_active(uint16_t conn_id, ota_transport_t transport)
+{
+    return ota_started && ota_owner == conn_id && ota_transport == transport;
+}
+
+void ota_update_control_value(uint8_t *out)
+{
+    uint16_t psm = ota_l2cap_available() ? OTA_L2CAP_PSM : 0;
+    out[0] = ota_status;
+    out[1] = OTA_TRANSPORT_GATT | (psm ? OTA_TRANSPORT_L2CAP : 0);
+    out[2] = psm & 0xff;
+    out[3] = psm >> 8;
+    out[4] = (1 << OTA_TARGET_APP) | (1 << OTA_TARGET_STORAGE);
+}
+
+void ota_update_conn_close(uint16_t conn_id)
+{
+    if (ota_started && ota_owner == conn_id) {
+        ESP_LOGW(TAG, "conn %d disconnected during ota, abort", conn_id);
+        ota_abort();
+        ota_report_transfer();
+        mem_budget_phase_end(MEM_PHASE_OTA);
+    }
+}
@@ -0,0 +1,113 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Silicon Labs OTA Control 寫入值 */
+#define OTA_CONTROL_BEGIN       0x00
+#define OTA_CONTROL_END         0x03
+#define OTA_CONTROL_BEGIN_L2CAP 0x10    // 擴充: 開始 OTA，映像改由 L2CAP CoC 傳輸 (見 ota_l2cap.h)
+
+/*
+  寫入 OTA Control: 1 byte 為上述控制值 (更新 app)；擴充的 2 bytes 為 [控制值, ota_target_t]，
+  開始時選擇要更新的分區
+*/
+#define OTA_CONTROL_WRITE_LEN   2
+
+/*
+  讀取 OTA Control 的屬性值:
+  | offset | size | 內容                                        |
+  |--------|------|---------------------------------------------|
+  | 0      | 1    | ota_status_t                                |
+  | 1      | 1    | 支援的傳輸方式 (ota_transport_t 的 bitmask)  |
+  | 2      | 2    | L2CAP CoC 的 PSM (little endian)，不支援時為 0 |
+  | 4      | 1    | 可更新的目標 (1 << ota_target_t 的 bitmask)  |
+*/
+#define OTA_CONTROL_READ_LEN    5
+
+/* OTA 更新的目標分區 */
+typedef enum {
+    OTA_TARGET_APP      = 0x00,     // 下一個 OTA app 分區，映像寫完後設為開機分區
+    OTA_TARGET_STORAGE  = 0x01,     // 事件紀錄的資料分區 (EVENT_STORE_PARTITION)，以 block 傳輸 (見 ota_data.h)
+} ota_target_t;
+
+/* OTA 映像的傳輸方式 */
+typedef enum {
+    OTA_TRANSPORT_GATT  = 0x01,     // 寫入 OTA Data characteristic (Silicon Labs 相容)
+    OTA_TRANSPORT_L2CAP = 0x02,     // LE credit-based L2CAP CoC
+} ota_transport_t;
+
+/*
+  OTA 狀態碼，OTA 中止後寫入 OTA Control 的屬性值供 client 讀取，也作為寫入回應的錯誤碼
+  (ATT application error 0x80 ~ 0x9F)
+*/
+typedef enum {
+    OTA_STATUS_OK               = 0x00,
+    OTA_STATUS_NOT_STARTED      = 0x80,     // 尚未寫入 OTA_CONTROL_BEGIN，或 OTA 由其他連線進行中
+    OTA_STATUS_BAD_MAGIC        = 0x81,     // 不是 ESP 韌體映像
+    OTA_STATUS_BAD_CHIP         = 0x82,     // 映像的 chip id 與本機不符
+    OTA_STATUS_BAD_SEGMENT      = 0x83,     // segment 數量或第一個 segment 長度不正確
+    OTA_STATUS_BAD_APP_DESC     = 0x84,     // 找不到 esp_app_desc_t
+    OTA_STATUS_SECURE_VERSION   = 0x85,     // secure version 低於 eFuse 記錄的版本 (anti-rollback)
+    OTA_STATUS_SAME_VERSION     = 0x86,     // 與目前執行的版本相同，不需更新
+    OTA_STATUS_TOO_LARGE        = 0x87,     // 超過 update partition 大小
+    OTA_STATUS_FLASH_ERROR      = 0x88,     // esp_ota_begin() 或 esp_ota_write() 失敗
+    OTA_STATUS_NO_TRANSPORT     = 0x89,     // 要求的傳輸方式不支援，client 應改用 OTA_CONTROL_BEGIN
+    OTA_STATUS_BLOCK_UNCHANGED  = 0x8A,     // 資料分區的 block 與 flash 相同，client 略過這個 block (不中止 OTA)
+    OTA_STATUS_BLOCK_HASH       = 0x8B,     // 資料分區的 block 內容與 header 的 SHA-256 不符，client 可重送 (不中止 OTA)
+    OTA_STATUS_BAD_BLOCK        = 0x8C,     // 資料分區的 block header 格式錯誤、block 超過長度或結束時未收完
+    OTA_STATUS_BAD_TARGET       = 0x8D,     // 不支援的目標，或目標分區正在使用中
+} ota_status_t;
+
+/*
+  處理連線 conn_id 寫入 OTA Control 的值 (1 ~ OTA_CONTROL_WRITE_LEN bytes)，OTA_CONTROL_END 成功時會重新啟動。
+  OTA 由開始的連線獨佔，其他連線的 OTA 寫入回傳 ESP_ERR_INVALID_STATE
+*/
+esp_err_t ota_update_control(uint16_t conn_id, const uint8_t *value, uint16_t len);
+
+/*
+  將連線 conn_id 在 OTA Data 或 L2CAP CoC 收到的資料寫入 update partition，
+  收到映像開頭時即檢查 image header 與 app 描述，不符時立即中止 OTA。
+  目標為資料分區時交給 ota_data_feed()，回應 OTA_STATUS_BLOCK_UNCHANGED / OTA_STATUS_BLOCK_HASH 時不中止 OTA；
+  block header 的結果同時保留在 OTA Control 的狀態碼，以寫入命令 (不需回應) 送出時 client 讀取 OTA Control 得知。
+  OTA 結束或中止時印出收到的資料量、複製次數與實際寫入 flash 的資料量
+*/
+esp_err_t ota_update_data(uint16_t conn_id, const uint8_t *data, uint16_t len);
+
+/*
+  連線 conn_id 的 OTA 資料在交給 ota_update_data() 前被應用程式複製了 len bytes
+  (長寫入緩衝池、攤平分散的 mbuf、堆棧保存的屬性值)，OTA 結束時以每 byte 的複製次數印出
+*/
+void ota_update_count_copy(uint16_t conn_id, uint32_t len);
+
+/*
+  連線 conn_id 最近一次 OTA 寫入的狀態，用於寫入回應: OTA 由其他連線進行中時為
+  OTA_STATUS_NOT_STARTED (不改變進行中 OTA 的狀態)，否則為 OTA 的狀態
+*/
+ota_status_t ota_update_get_status(uint16_t conn_id);
+
+/* 連線 conn_id 是否正以 transport 進行 OTA */
+bool ota_update_is_active(uint16_t conn_id, ota_transport_t transport);
+
+/* 填入 OTA Control 的讀取值 (OTA_CONTROL_READ_LEN bytes) */
+void ota_update_control_value(uint8_t *out);
+
+/* 連線斷開時呼叫，若為 OTA 進行中的連線則中止 OTA */
+void ota_update_conn_close(uint16_t conn_id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,78 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  以 耗電流.txt 的量測電流估計每個狀態的耗電，不需電流表即可比較不同喚醒策略。
+  只使用 C 標準函式庫，可在主機上與模擬的平台一起編譯
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "power_model.h"
+
+#define POWER_STATS_MAGIC   0x50574d33  // "PWM3"，power_stats_t 改變時更新
+
+static const uint32_t state_current_ua[WAKE_STATE_NUM] = {
+    [WAKE_STATE_BOOT]     = POWER_BOOT_UA,
+    [WAKE_STATE_SLEEP]    = POWER_SLEEP_UA,
+    [WAKE_STATE_EVENT]    = POWER_EVENT_UA,
+    [WAKE_STATE_BLE_ADV]  = POWER_BLE_ADV_UA,
+    [WAKE_STATE_BLE_CONN] = POWER_BLE_CONN_UA,
+    [WAKE_STATE_CONSOLE]  = POWER_CONSOLE_UA,
+    [WAKE_STATE_SAMPLE]   = POWER_SAMPLE_UA,
+};
+
+static const char *const state_name[WAKE_STATE_NUM] = {
+    [WAKE_STATE_BOOT]     = "boot",
+    [WAKE_STATE_SLEEP]    = "sleep",
+    [WAKE_STATE_EVENT]    = "event",
+    [WAKE_STATE_BLE_ADV]  = "ble_adv",
+    [WAKE_STATE_BLE_CONN] = "ble_conn",
+    [WAKE_STATE_CONSOLE]  = "console",
+    [WAKE_STATE_SAMPLE]   = "sample",
+};
+
+void power_model_boot(power_stats_t *stats, int64_t now_us)
+{
+    if (stats->magic != POWER_STATS_MAGIC) {
+        memset(stats, 0, sizeof(*stats));
+        stats->magic = POWER_STATS_MAGIC;
+    }
+    stats->boot_count++;
+    stats->state = WAKE_STATE_BOOT;
+    // 重新啟動後時鐘歸零，上一次啟動的最後一段已在重新啟動前累計
+    stats->enter_us = now_us;
+}
+
+void power_model_enter(power_stats_t *stats, wake_state_t state, int64_t now_us)
+{
+    if (stats->state < WAKE_STATE_NUM && now_us > stats->enter_us) {
+        stats->time_us[stats->state] += now_us - stats->enter_us;
+    }
+    stats->state = state;
+    stats->enter_us = now_us;
+}
+
+double power_model_charge_uah(const power_stats_t *stats, wake_state_t state)
+{
+    return (double)state_current_ua[state] * stats->time_us[state] / 3600e6;
+}
+
+void power_model_report(const power_stats_t *stats)
+{
+    double total_uah = 0;
+
+    printf("power model after %lu boots:\n", (unsigned long)stats->boot_count);
+    for (int i = 0; i < WAKE_STATE_NUM; i++) {
+        double uah = power_model_charge_uah(stats, i);
+        total_uah += uah;
+        printf("  %-8s %10lld ms %10.3f uAh %10.3f mJ\n", state_name[i], (long long)(stats->time_us[i] / 1000),
+               uah, uah * POWER_MODEL_SUPPLY_MV * 3.6e-3);
+    }
+    printf("  total    %10.3f uAh %10.3f mJ\n", total_uah, total_uah * POWER_MODEL_SUPPLY_MV * 3.6e-3);
+}
@@ -0,0 +1,42 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include "wake_fsm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define POWER_MODEL_SUPPLY_MV       3300
+
+/* 各狀態的電流 (uA)，量測值見 耗電流.txt */
+#define POWER_SLEEP_UA              11940
+#define POWER_EVENT_UA              29430
+#define POWER_BLE_ADV_UA            32250
+#define POWER_BLE_CONN_UA           31040
+#define POWER_BOOT_UA               POWER_EVENT_UA      // 未量測，以 CPU 執行時的電流估計
+#define POWER_CONSOLE_UA            POWER_EVENT_UA      // 未量測，以 CPU 執行時的電流估計
+#define POWER_SAMPLE_UA             POWER_EVENT_UA      // 未量測，以 CPU 執行時的電流估計
+
+/* 每次啟動時呼叫，stats 無效 (第一次上電) 時清除，目前狀態設為 WAKE_STATE_BOOT */
+void power_model_boot(power_stats_t *stats, int64_t now_us);
+
+/* 累計目前狀態到 now_us 的時間並切換到 state */
+void power_model_enter(power_stats_t *stats, wake_state_t state, int64_t now_us);
+
+/* 狀態 state 累計消耗的電量 (uAh) */
+double power_model_charge_uah(const power_stats_t *stats, wake_state_t state);
+
+/* 印出各狀態的累計時間、電量與能量 */
+void power_model_report(const power_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
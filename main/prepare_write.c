@@ -0,0 +1,212 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  長特徵值寫入 (Prepare Write / Execute Write)
+
+  緩衝區由靜態緩衝池以 PREPARE_WRITE_BLOCK_SIZE 為單位配置連續區塊，回應用的 esp_gatt_rsp_t
+  也只有一份重複使用，整個流程不呼叫 malloc。GATT 事件都在 BTC task 中處理，因此不需加鎖。
+*/
+
+#include <string.h>
+#include "esp_log.h"
+#include "prepare_write.h"
+
+#define PREPARE_WRITE_POOL_SIZE     (PREPARE_WRITE_BLOCK_SIZE * PREPARE_WRITE_BLOCK_NUM)
+
+static const char *TAG = "prepare_write";
+
+typedef struct {
+    uint16_t                handle;
+    uint16_t                capacity;
+    prepare_write_handler_t handler;
+} prepare_attr_t;
+
+typedef struct {
+    bool     in_use;
+    uint16_t conn_id;
+    uint16_t handle;
+    uint16_t capacity;
+    uint16_t len;           // 目前收到的最大 offset + len
+    uint8_t  first_block;
+    uint8_t  block_num;
+} prepare_session_t;
+
+static uint8_t prepare_pool[PREPARE_WRITE_POOL_SIZE];
+static bool block_used[PREPARE_WRITE_BLOCK_NUM];
+static prepare_attr_t attr_tab[PREPARE_WRITE_MAX_ATTRS];
+static prepare_session_t session_tab[PREPARE_WRITE_MAX_SESSIONS];
+static esp_gatt_rsp_t prepare_rsp;
+
+static const prepare_attr_t *find_attr(uint16_t handle)
+{
+    for (int i = 0; i < PREPARE_WRITE_MAX_ATTRS; i++) {
+        if (attr_tab[i].handle == handle) {
+            return &attr_tab[i];
+        }
+    }
+    return NULL;
+}
+
+static prepare_session_t *find_session(uint16_t conn_id)
+{
+    for (int i = 0; i < PREPARE_WRITE_MAX_SESSIONS; i++) {
+        if (session_tab[i].in_use && session_tab[i].conn_id == conn_id) {
+            return &session_tab[i];
+        }
+    }
+    return NULL;
+}
+
+/* 在緩衝池中找連續 block_num 個空區塊 (first fit) */
+static int pool_alloc(uint8_t block_num)
+{
+    for (int first = 0; first + block_num <= PREPARE_WRITE_BLOCK_NUM; first++) {
+        int n = 0;
+        while (n < block_num && !block_used[first + n]) {
+            n++;
+        }
+        if (n == block_num) {
+            memset(&block_used[first], true, block_num);
+            return first;
+        }
+        first += n;
+    }
+    return -1;
+}
+
+static void session_free(prepare_session_t *session)
+{
+    memset(&block_used[session->first_block], false, session->block_num);
+    session->in_use = false;
+}
+
+static uint8_t *session_buf(const prepare_session_t *session)
+{
+    return &prepare_pool[session->first_block * PREPARE_WRITE_BLOCK_SIZE];
+}
+
+static esp_gatt_status_t session_open(uint16_t conn_id, uint16_t handle, prepare_session_t **out)
+{
+    const prepare_attr_t *attr = find_attr(handle);
+    uint16_t capacity = attr ? attr->capacity : PREPARE_BUF_MAX_SIZE;
+    uint8_t block_num = (capacity + PREPARE_WRITE_BLOCK_SIZE - 1) / PREPARE_WRITE_BLOCK_SIZE;
+
+    prepare_session_t *session = NULL;
+    for (int i = 0; i < PREPARE_WRITE_MAX_SESSIONS; i++) {
+        if (!session_tab[i].in_use) {
+            session = &session_tab[i];
+            break;
+        }
+    }
+    int first = session ? pool_alloc(block_num) : -1;
+    if (first < 0) {
+        ESP_LOGE(TAG, "%s, no free buffer for %d bytes", __func__, capacity);
+        return ESP_GATT_PREPARE_Q_FULL;
+    }
+    session->in_use = true;
+    session->conn_id = conn_id;
+    session->handle = handle;
+    session->capacity = capacity;
+    session->len = 0;
+    session->first_block = first;
+    session->block_num = block_num;
+    *out = session;
+    return ESP_GATT_OK;
+}
+
+esp_err_t prepare_write_register(uint16_t handle, uint16_t capacity, prepare_write_handler_t handler)
+{
+    if (capacity == 0 || capacity > PREPARE_WRITE_POOL_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    prepare_attr_t *slot = (prepare_attr_t *)find_attr(handle);
+    for (int i = 0; slot == NULL && i < PREPARE_WRITE_MAX_ATTRS; i++) {
+        if (attr_tab[i].handler == NULL && attr_tab[i].capacity == 0) {
+            slot = &attr_tab[i];
+        }
+    }
+    if (slot == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    slot->handle = handle;
+    slot->capacity = capacity;
+    slot->handler = handler;
+    return ESP_OK;
+}
+
+void prepare_write_event(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param)
+{
+    ESP_LOGD(TAG, "prepare write, handle = %d, offset = %d, value len = %d",
+             param->write.handle, param->write.offset, param->write.len);
+    esp_gatt_status_t status = ESP_GATT_OK;
+    prepare_session_t *session = find_session(param->write.conn_id);
+    if (session == NULL) {
+        status = session_open(param->write.conn_id, param->write.handle, &session);
+    } else if (session->handle != param->write.handle) {
+        // 一次長寫入只處理一個屬性
+        status = ESP_GATT_REQ_NOT_SUPPORTED;
+    }
+    if (status == ESP_GATT_OK) {
+        if (param->write.offset > session->capacity) {
+            status = ESP_GATT_INVALID_OFFSET;
+        } else if ((param->write.offset + param->write.len) > session->capacity) {
+            status = ESP_GATT_INVALID_ATTR_LEN;
+        }
+    }
+
+    /* send response when param->write.need_rsp is true, the response echoes the received value */
+    if (param->write.need_rsp) {
+        prepare_rsp.attr_value.len = param->write.len;
+        prepare_rsp.attr_value.handle = param->write.handle;
+        prepare_rsp.attr_value.offset = param->write.offset;
+        prepare_rsp.attr_value.auth_req = ESP_GATT_AUTH_REQ_NONE;
+        memcpy(prepare_rsp.attr_value.value, param->write.value, param->write.len);
+        esp_err_t response_err = esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id, status, &prepare_rsp);
+        if (response_err != ESP_OK) {
+            ESP_LOGE(TAG, "Send response error");
+        }
+    }
+    if (status != ESP_GATT_OK) {
+        return;
+    }
+
+    memcpy(session_buf(session) + param->write.offset, param->write.value, param->write.len);
+    if (param->write.offset + param->write.len > session->len) {
+        session->len = param->write.offset + param->write.len;
+    }
+}
+
+void prepare_write_exec(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param)
+{
+    prepare_session_t *session = find_session(param->exec_write.conn_id);
+    esp_gatt_status_t status = ESP_GATT_OK;
+
+    if (session && param->exec_write.exec_write_flag == ESP_GATT_PREP_WRITE_EXEC) {
+        const prepare_attr_t *attr = find_attr(session->handle);
+        if (attr && attr->handler) {
+            status = attr->handler(gatts_if, session->conn_id, session->handle, session_buf(session), session->len);
+        } else {
+            esp_log_buffer_hex(TAG, session_buf(session), session->len);
+        }
+    } else if (session) {
+        ESP_LOGI(TAG, "ESP_GATT_PREP_WRITE_CANCEL");
+    }
+    if (session) {
+        session_free(session);
+    }
+    esp_ble_gatts_send_response(gatts_if, param->exec_write.conn_id, param->exec_write.trans_id, status, NULL);
+}
+
+void prepare_write_conn_close(uint16_t conn_id)
+{
+    prepare_session_t *session = find_session(conn_id);
+    if (session) {
+        session_free(session);
+    }
+}
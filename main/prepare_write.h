@@ -0,0 +1,50 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_gatts_api.h"
+#include "mem_budget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PREPARE_BUF_MAX_SIZE            1024    // 未註冊的屬性預設可接受的長寫入長度
+#define PREPARE_WRITE_BLOCK_SIZE        256
+#define PREPARE_WRITE_BLOCK_NUM         MEM_BUDGET_PREPARE_WRITE_BLOCKS  // 靜態緩衝池，由所有長寫入共用
+#define PREPARE_WRITE_MAX_ATTRS         8
+#define PREPARE_WRITE_MAX_SESSIONS      CONFIG_BT_ACL_CONNECTIONS
+
+/*
+  長寫入執行 (ESP_GATT_PREP_WRITE_EXEC) 後，將完整資料交給屬性的處理函數，
+  回傳值做為 Execute Write 的回應
+*/
+typedef esp_gatt_status_t (*prepare_write_handler_t)(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t handle,
+                                                     const uint8_t *data, uint16_t len);
+
+/*
+  設定屬性可接受的長寫入長度與處理函數，capacity 可超過 PREPARE_BUF_MAX_SIZE，
+  上限為緩衝池大小 PREPARE_WRITE_BLOCK_SIZE * PREPARE_WRITE_BLOCK_NUM
+*/
+esp_err_t prepare_write_register(uint16_t handle, uint16_t capacity, prepare_write_handler_t handler);
+
+/* ESP_GATTS_WRITE_EVT 且 param->write.is_prep 為 true 時呼叫 */
+void prepare_write_event(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param);
+
+/* ESP_GATTS_EXEC_WRITE_EVT 時呼叫，執行或取消長寫入，處理函數返回後以其狀態回應 client */
+void prepare_write_exec(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param);
+
+/* 斷線時釋放該連線尚未執行的長寫入 */
+void prepare_write_conn_close(uint16_t conn_id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,247 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  FreeRTOS task 剖析: 以 uxTaskGetSystemState() 取得各 task 的累計執行時間 (run time stats) 與 stack 水位，
+  區段開始與結束的差值即為 CPU 佔比；再以 esp_timer 定時取樣 task 狀態，ready 次數多表示 task 在等 CPU，
+  blocked 次數多表示 task 在等 queue / semaphore。FreeRTOS 沒有提供 task 切換與 queue 等待的計數，
+  以取樣的狀態次數代替。
+
+  快照存在 RTC 保留的 RAM，所有連線斷開重新啟動後，下一次 BLE 連線仍可讀取。
+*/
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "diag.h"
+#include "task_profiler.h"
+
+#define TASK_PROFILER_MAGIC     0x54505246  // "TPRF"
+
+static const char *TAG = "task_profiler";
+
+static const char *session_names[TASK_PROFILER_NUM] = {
+    [TASK_PROFILER_BLE]        = "ble",
+    [TASK_PROFILER_WAKE_EVENT] = "wake_event",
+};
+
+/* 區段中每個 task 的累計 */
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t     start_runtime;
+    uint16_t     ready_samples;
+    uint16_t     blocked_samples;
+} task_track_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t len[TASK_PROFILER_NUM];
+    uint8_t  snapshot[TASK_PROFILER_NUM][TASK_PROFILER_SNAPSHOT_MAX];
+} task_profiler_store_t;
+
+static __NOINIT_ATTR task_profiler_store_t store;
+static portMUX_TYPE profiler_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskStatus_t sample_buf[TASK_PROFILER_MAX_TASKS];    // esp_timer task 取樣用
+static TaskStatus_t status_buf[TASK_PROFILER_MAX_TASKS];    // 區段開始、結束與 diag 讀取用
+static task_track_t tracks[TASK_PROFILER_MAX_TASKS];
+static int track_num;
+static int active_session = -1;
+static int64_t session_start_us;
+static uint32_t sample_count;
+static esp_timer_handle_t sample_timer;
+
+static task_track_t *find_track(TaskHandle_t handle)
+{
+    for (int i = 0; i < track_num; i++) {
+        if (tracks[i].handle == handle) {
+            return &tracks[i];
+        }
+    }
+    if (track_num < TASK_PROFILER_MAX_TASKS) {
+        // 區段中建立的 task 從 0 開始計算
+        tracks[track_num] = (task_track_t) { .handle = handle };
+        return &tracks[track_num++];
+    }
+    return NULL;
+}
+
+static void sample_timer_cb(void *arg)
+{
+    UBaseType_t num = uxTaskGetSystemState(sample_buf, TASK_PROFILER_MAX_TASKS, NULL);
+
+    taskENTER_CRITICAL(&profiler_lock);
+    for (int i = 0; i < num; i++) {
+        task_track_t *track = find_track(sample_buf[i].xHandle);
+        if (track == NULL) {
+            continue;
+        }
+        if (sample_buf[i].eCurrentState == eReady) {
+            track->ready_samples++;
+        } else if (sample_buf[i].eCurrentState == eBlocked) {
+            track->blocked_samples++;
+        }
+    }
+    sample_count++;
+    taskEXIT_CRITICAL(&profiler_lock);
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, v & 0xffff);
+    put_u16(p + 2, v >> 16);
+}
+
+/* 依區段開始後的累計產生快照，回傳長度 */
+static size_t build_snapshot(task_profiler_session_t session, uint8_t *out)
+{
+    uint32_t total_runtime;
+    UBaseType_t num = uxTaskGetSystemState(status_buf, TASK_PROFILER_MAX_TASKS, &total_runtime);
+    uint32_t elapsed_us = esp_timer_get_time() - session_start_us;
+    uint32_t runtime_sum = 0;
+
+    taskENTER_CRITICAL(&profiler_lock);
+    for (int i = 0; i < num; i++) {
+        task_track_t *track = find_track(status_buf[i].xHandle);
+        if (track) {
+            runtime_sum += status_buf[i].ulRunTimeCounter - track->start_runtime;
+        }
+    }
+    out[0] = TASK_PROFILER_VERSION;
+    out[1] = session;
+    out[2] = 0;
+    out[3] = 0;
+    put_u32(&out[4], elapsed_us);
+    put_u32(&out[8], sample_count);
+    uint8_t *entry = &out[TASK_PROFILER_HEADER_LEN];
+    for (int i = 0; i < num; i++) {
+        const TaskStatus_t *status = &status_buf[i];
+        task_track_t *track = find_track(status->xHandle);
+        if (track == NULL) {
+            continue;
+        }
+        uint32_t runtime = status->ulRunTimeCounter - track->start_runtime;
+        memset(entry, 0, TASK_PROFILER_NAME_LEN);
+        strncpy((char *)entry, status->pcTaskName, TASK_PROFILER_NAME_LEN);
+        put_u16(&entry[10], runtime_sum ? (uint64_t)runtime * 1000 / runtime_sum : 0);
+        put_u16(&entry[12], status->usStackHighWaterMark);   // ESP-IDF 中單位為 bytes
+        entry[14] = status->uxCurrentPriority;
+        entry[15] = status->eCurrentState;
+        put_u16(&entry[16], track->ready_samples);
+        put_u16(&entry[18], track->blocked_samples);
+        entry += TASK_PROFILER_ENTRY_LEN;
+        out[2]++;
+    }
+    taskEXIT_CRITICAL(&profiler_lock);
+    return entry - out;
+}
+
+void task_profiler_begin(task_profiler_session_t session)
+{
+    if (active_session >= 0) {
+        ESP_LOGW(TAG, "%s session still active, restart as %s", session_names[active_session], session_names[session]);
+        esp_timer_stop(sample_timer);
+    }
+    UBaseType_t num = uxTaskGetSystemState(status_buf, TASK_PROFILER_MAX_TASKS, NULL);
+
+    taskENTER_CRITICAL(&profiler_lock);
+    track_num = 0;
+    for (int i = 0; i < num; i++) {
+        tracks[track_num++] = (task_track_t) {
+            .handle = status_buf[i].xHandle,
+            .start_runtime = status_buf[i].ulRunTimeCounter,
+        };
+    }
+    sample_count = 0;
+    active_session = session;
+    session_start_us = esp_timer_get_time();
+    taskEXIT_CRITICAL(&profiler_lock);
+
+    esp_timer_start_periodic(sample_timer, TASK_PROFILER_SAMPLE_MS * 1000);
+}
+
+void task_profiler_end(task_profiler_session_t session)
+{
+    static char hex[TASK_PROFILER_SNAPSHOT_MAX * 2 + 1];
+
+    if (active_session != session) {
+        return;
+    }
+    esp_timer_stop(sample_timer);
+    size_t len = build_snapshot(session, store.snapshot[session]);
+    store.len[session] = len;
+    active_session = -1;
+
+    for (size_t i = 0; i < len; i++) {
+        static const char digits[] = "0123456789abcdef";
+        hex[i * 2] = digits[store.snapshot[session][i] >> 4];
+        hex[i * 2 + 1] = digits[store.snapshot[session][i] & 0x0f];
+    }
+    hex[len * 2] = '\0';
+    // tools/task_profile_decode.py 由 log 中找出這一行解碼
+    printf("TPROF %s %s\n", session_names[session], hex);
+}
+
+/* 依序輸出各區段最近一次的快照；進行中的區段先更新為目前的累計 */
+static size_t task_profiler_diag_read(uint32_t offset, uint8_t *buf, size_t cap)
+{
+    static uint8_t live[TASK_PROFILER_SNAPSHOT_MAX];
+    static uint16_t live_len;
+
+    if (offset == 0) {
+        live_len = active_session >= 0 ? build_snapshot(active_session, live) : 0;
+    }
+    size_t written = 0;
+    uint32_t pos = 0;
+    for (int i = -1; i < TASK_PROFILER_NUM && written < cap; i++) {
+        const uint8_t *data = i < 0 ? live : store.snapshot[i];
+        uint32_t len = i < 0 ? live_len : store.len[i];
+        if (i == active_session) {
+            // 已在 live 中輸出
+            continue;
+        }
+        if (offset < pos + len) {
+            uint32_t start = offset > pos ? offset - pos : 0;
+            uint32_t n = len - start;
+            if (n > cap - written) {
+                n = cap - written;
+            }
+            memcpy(buf + written, data + start, n);
+            written += n;
+            offset += n;
+        }
+        pos += len;
+    }
+    return written;
+}
+
+esp_err_t task_profiler_init(void)
+{
+    if (store.magic != TASK_PROFILER_MAGIC) {
+        // 上電後 RAM 內容無效
+        memset(&store, 0, sizeof(store));
+        store.magic = TASK_PROFILER_MAGIC;
+    }
+    const esp_timer_create_args_t sample_args = {
+        .callback = sample_timer_cb,
+        .name = "task_profiler",
+    };
+    esp_err_t ret = esp_timer_create(&sample_args, &sample_timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return diag_register(DIAG_ID_TASK_PROFILE, task_profiler_diag_read);
+}
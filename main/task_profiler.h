@@ -0,0 +1,60 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  FreeRTOS task 剖析快照格式 (little endian)，解碼見 tools/task_profile_decode.py
+
+  | offset | size | 內容                                            |
+  |--------|------|-------------------------------------------------|
+  | 0      | 1    | TASK_PROFILER_VERSION                           |
+  | 1      | 1    | 區段 (task_profiler_session_t)                   |
+  | 2      | 1    | task 數 N                                       |
+  | 3      | 1    | 保留                                            |
+  | 4      | 4    | 區段長度 (us)                                    |
+  | 8      | 4    | 取樣次數                                        |
+  | 12     | 20*N | 每個 task: 名稱 (10 bytes，不足補 0)、CPU 佔比 (0.1%)、
+                    剩餘 stack 最小值 (bytes)、優先權、狀態 (eTaskState)、
+                    ready 取樣數 (可執行但在等 CPU)、blocked 取樣數 (等待 queue / semaphore / delay) |
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TASK_PROFILER_VERSION       1
+#define TASK_PROFILER_MAX_TASKS     16
+#define TASK_PROFILER_SAMPLE_MS     50      // 取樣 task 狀態的週期
+#define TASK_PROFILER_NAME_LEN      10
+#define TASK_PROFILER_HEADER_LEN    12
+#define TASK_PROFILER_ENTRY_LEN     20
+#define TASK_PROFILER_SNAPSHOT_MAX  (TASK_PROFILER_HEADER_LEN + TASK_PROFILER_ENTRY_LEN * TASK_PROFILER_MAX_TASKS)
+
+typedef enum {
+    TASK_PROFILER_BLE,          // BLE 開始廣播到所有連線斷開
+    TASK_PROFILER_WAKE_EVENT,   // GPIO 喚醒後寫入事件紀錄
+    TASK_PROFILER_NUM,
+} task_profiler_session_t;
+
+/* 開機時呼叫，以 DIAG_ID_TASK_PROFILE 提供各區段最近一次的快照 */
+esp_err_t task_profiler_init(void);
+
+/* 開始區段: 記下各 task 的執行時間並開始定時取樣，同時只能有一個區段 */
+void task_profiler_begin(task_profiler_session_t session);
+
+/* 結束區段: 產生快照 (重新啟動後保留) 並以一行 hex 印到 console */
+void task_profiler_end(task_profiler_session_t session);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,128 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdbool.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "diag.h"
+#include "temp_sampler.h"
+#include "temp_sensor.h"
+#include "temp_threshold.h"
+#include "wake_fsm.h"
+
+#define TEMP_SAMPLER_MAGIC      0x54534d50  // "TSMP"
+
+static const char *TAG = "temp_sampler";
+
+/* 與外部比較器相同的臨界值，觸發時寫入相同的事件 */
+static const temp_threshold_t thresholds[] = {
+    { .trigger_cc = 100,  .hysteresis_cc = TEMP_SAMPLER_HYSTERESIS_CC, .event = TEMPERATURE_WAKEUP_GPIO1 },
+    { .trigger_cc = -100, .hysteresis_cc = TEMP_SAMPLER_HYSTERESIS_CC, .event = TEMPERATURE_WAKEUP_GPIO2 },
+    { .trigger_cc = -500, .hysteresis_cc = TEMP_SAMPLER_HYSTERESIS_CC, .event = TEMPERATURE_WAKEUP_GPIO3 },
+};
+
+#define THRESHOLD_NUM           (sizeof(thresholds) / sizeof(thresholds[0]))
+
+const temp_sampler_driver_t temp_sampler_onchip = {
+    .name = "onchip",
+    .read = temp_sensor_read,
+};
+
+/* 觸發狀態與上一個樣本在事件紀錄後重新啟動時仍需保留，遲滯才有效 */
+typedef struct {
+    uint32_t             magic;
+    bool                 valid;         // prev_cc 有效
+    uint32_t             active;        // 已觸發的臨界值 (bit)
+    temp_sampler_stats_t stats;
+} sampler_store_t;
+
+static __NOINIT_ATTR sampler_store_t store;
+static const temp_sampler_driver_t *driver = &temp_sampler_onchip;
+
+static size_t temp_sampler_diag_read(uint32_t offset, uint8_t *buf, size_t cap)
+{
+    if (offset >= sizeof(store.stats)) {
+        return 0;
+    }
+    size_t len = sizeof(store.stats) - offset;
+    if (len > cap) {
+        len = cap;
+    }
+    memcpy(buf, (const uint8_t *)&store.stats + offset, len);
+    return len;
+}
+
+esp_err_t temp_sampler_init(const temp_sampler_driver_t *drv)
+{
+    if (drv) {
+        driver = drv;
+    }
+    if (store.magic != TEMP_SAMPLER_MAGIC) {
+        // 上電後 RAM 內容無效
+        memset(&store, 0, sizeof(store));
+        store.magic = TEMP_SAMPLER_MAGIC;
+        store.stats.period_ms = TEMP_SAMPLER_MIN_PERIOD_MS;
+    }
+    return diag_register(DIAG_ID_TEMP_SAMPLER, temp_sampler_diag_read);
+}
+
+uint8_t temp_sampler_run(void)
+{
+    temp_sampler_stats_t *stats = &store.stats;
+    int16_t cc;
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = driver->read(&cc);
+    uint32_t us = esp_timer_get_time() - start;
+
+    stats->samples++;
+    stats->last_us = us;
+    stats->total_us += us;
+    if (us > stats->max_us) {
+        stats->max_us = us;
+    }
+    if (ret != ESP_OK) {
+        stats->errors++;
+        ESP_LOGW(TAG, "%s read failed (%s)", driver->name, esp_err_to_name(ret));
+        return 0;
+    }
+
+    int fired = temp_threshold_update(thresholds, THRESHOLD_NUM, cc, &store.active);
+    int32_t margin = temp_threshold_margin(thresholds, THRESHOLD_NUM, cc, store.active);
+    stats->period_ms = temp_threshold_next_period(stats->period_ms, store.valid ? stats->last_cc : cc, cc, margin,
+                                                  TEMP_SAMPLER_MIN_PERIOD_MS, TEMP_SAMPLER_MAX_PERIOD_MS);
+    stats->last_cc = cc;
+    store.valid = true;
+    ESP_LOGD(TAG, "%d cC in %lu us, next %lu ms", cc, (unsigned long)us, (unsigned long)stats->period_ms);
+
+    if (fired < 0) {
+        return 0;
+    }
+    stats->events++;
+    ESP_LOGI(TAG, "%d cC crossed %d cC", cc, thresholds[fired].trigger_cc);
+    return thresholds[fired].event;
+}
+
+uint32_t temp_sampler_period_ms(void)
+{
+    return store.stats.period_ms;
+}
+
+void temp_sampler_report(void)
+{
+    const temp_sampler_stats_t *stats = &store.stats;
+    if (stats->samples == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "%s: %lu samples (%lu errors), %lu events, read avg %lu us, max %lu us, last %d cC, period %lu ms",
+             driver->name, (unsigned long)stats->samples, (unsigned long)stats->errors, (unsigned long)stats->events,
+             (unsigned long)(stats->total_us / stats->samples), (unsigned long)stats->max_us, stats->last_cc,
+             (unsigned long)stats->period_ms);
+}
@@ -0,0 +1,63 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  timer 喚醒的溫度取樣: light sleep 中定時醒來讀取溫度，以軟體判斷臨界值與遲滯 (temp_threshold.h)，
+  只有跨越臨界值時才進入事件紀錄流程，其餘樣本讀取後直接回到 light sleep，不重新啟動。
+  取樣週期依溫度變化速率在 TEMP_SAMPLER_MIN_PERIOD_MS 與 TEMP_SAMPLER_MAX_PERIOD_MS 之間調整
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEMP_SAMPLER_ENABLE         1       // 0: 只使用外部比較器 (GPIO 10 ~ 12)
+#define TEMP_SAMPLER_MIN_PERIOD_MS  2000
+#define TEMP_SAMPLER_MAX_PERIOD_MS  60000
+#define TEMP_SAMPLER_HYSTERESIS_CC  50      // 0.5°C，觸發後回升超過臨界值加上此值才解除
+
+/* 溫度感測器，預設為晶片內建的感測器 (temp_sensor.h)，可換成外接感測器的實作 */
+typedef struct {
+    const char *name;
+    esp_err_t (*read)(int16_t *centi_celsius);
+} temp_sampler_driver_t;
+
+extern const temp_sampler_driver_t temp_sampler_onchip;
+
+/* 取樣統計，重新啟動後保留，斷電後清除 */
+typedef struct {
+    uint32_t samples;
+    uint32_t errors;            // 讀取失敗的次數
+    uint32_t events;            // 跨越臨界值的次數
+    uint32_t last_us;           // 最近一次讀取的耗時
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t period_ms;         // 目前的取樣週期
+    int16_t  last_cc;           // 最近一次的溫度 (0.01°C)
+} temp_sampler_stats_t;
+
+/* 開機時呼叫，driver 為 NULL 時使用 temp_sampler_onchip，以 DIAG_ID_TEMP_SAMPLER 提供統計 (temp_sampler_stats_t) */
+esp_err_t temp_sampler_init(const temp_sampler_driver_t *driver);
+
+/* timer 喚醒後取樣一次，跨越臨界值時回傳對應的事件 GPIO (wake_fsm.h)，否則回傳 0 */
+uint8_t temp_sampler_run(void);
+
+/* 下一次取樣前的 light sleep 時間 */
+uint32_t temp_sampler_period_ms(void);
+
+/* 印出取樣次數、讀取耗時與目前的週期 */
+void temp_sampler_report(void);
+
+#ifdef __cplusplus
+}
+#endif
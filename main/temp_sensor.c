@@ -0,0 +1,52 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "esp_log.h"
+#include "soc/soc_caps.h"
+#if SOC_TEMP_SENSOR_SUPPORTED
+#include "driver/temperature_sensor.h"
+#endif
+#include "temp_sensor.h"
+
+#if SOC_TEMP_SENSOR_SUPPORTED
+static const char *TAG = "temp_sensor";
+static temperature_sensor_handle_t temp_sensor;
+
+esp_err_t temp_sensor_read(int16_t *centi_celsius)
+{
+    esp_err_t ret;
+
+    if (temp_sensor == NULL) {
+        temperature_sensor_config_t sensor_cfg = TEMPERATURE_SENSOR_CONFIG_DEFAULT(-10, 80);
+        ret = temperature_sensor_install(&sensor_cfg, &temp_sensor);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "install temperature sensor failed (%s)", esp_err_to_name(ret));
+            temp_sensor = NULL;
+            return ret;
+        }
+    }
+    ret = temperature_sensor_enable(temp_sensor);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "enable temperature sensor failed (%s)", esp_err_to_name(ret));
+        return ret;
+    }
+    float celsius;
+    ret = temperature_sensor_get_celsius(temp_sensor, &celsius);
+    temperature_sensor_disable(temp_sensor);
+    if (ret == ESP_OK) {
+        *centi_celsius = (int16_t)(celsius * 100);
+    }
+    return ret;
+}
+#else
+esp_err_t temp_sensor_read(int16_t *centi_celsius)
+{
+    *centi_celsius = 0;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#endif
@@ -0,0 +1,28 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  晶片內建的溫度感測器，由溫度取樣 (temp_sampler.c) 與溫度通知 (temperature_stream.c) 共用。
+  第一次讀取時安裝，每次讀取前後開啟與關閉，light sleep 期間不耗電
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 讀取溫度 (0.01°C)，晶片不支援時回傳 ESP_ERR_NOT_SUPPORTED */
+esp_err_t temp_sensor_read(int16_t *centi_celsius);
+
+#ifdef __cplusplus
+}
+#endif
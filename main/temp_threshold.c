@@ -0,0 +1,76 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "temp_threshold.h"
+
+/* 觸發後解除的溫度 */
+static int32_t release_cc(const temp_threshold_t *th)
+{
+    return (int32_t)th->trigger_cc + th->hysteresis_cc;
+}
+
+int temp_threshold_update(const temp_threshold_t *th, size_t num, int16_t cc, uint32_t *active)
+{
+    int fired = -1;
+
+    for (size_t i = 0; i < num && i < TEMP_THRESHOLD_MAX; i++) {
+        uint32_t bit = 1UL << i;
+        if (*active & bit) {
+            if (cc > release_cc(&th[i])) {
+                *active &= ~bit;
+            }
+        } else if (cc <= th[i].trigger_cc && fired < 0) {
+            *active |= bit;
+            fired = i;
+        }
+    }
+    return fired;
+}
+
+int32_t temp_threshold_margin(const temp_threshold_t *th, size_t num, int16_t cc, uint32_t active)
+{
+    int32_t margin = INT32_MAX;
+
+    for (size_t i = 0; i < num && i < TEMP_THRESHOLD_MAX; i++) {
+        int32_t d;
+        if (active & (1UL << i)) {
+            d = release_cc(&th[i]) + 1 - cc;
+        } else {
+            d = cc - th[i].trigger_cc;
+        }
+        if (d < 0) {
+            d = 0;
+        }
+        if (d < margin) {
+            margin = d;
+        }
+    }
+    return margin;
+}
+
+uint32_t temp_threshold_next_period(uint32_t period_ms, int16_t prev_cc, int16_t cc, int32_t margin_cc,
+                                    uint32_t min_ms, uint32_t max_ms)
+{
+    int32_t delta = cc > prev_cc ? cc - prev_cc : prev_cc - cc;
+    uint64_t next = (uint64_t)period_ms * 2;
+
+    if (delta > 0) {
+        // 以目前速率到達邊界所需的時間的一半
+        uint64_t eta = (uint64_t)margin_cc * period_ms / delta / 2;
+        if (eta < next) {
+            next = eta;
+        }
+    }
+    if (next < min_ms) {
+        next = min_ms;
+    }
+    if (next > max_ms) {
+        next = max_ms;
+    }
+    return (uint32_t)next;
+}
@@ -0,0 +1,50 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  溫度臨界值與遲滯判斷，以及依溫度變化速率調整取樣週期 (與 ESP-IDF 無關，可直接在主機上編譯)。
+  溫度單位為 0.01°C
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEMP_THRESHOLD_MAX      32      // 觸發狀態以 uint32_t 的 bit 表示
+
+typedef struct {
+    int16_t trigger_cc;     // 溫度小於等於此值時觸發
+    int16_t hysteresis_cc;  // 觸發後回升到 trigger_cc + hysteresis_cc 以上才解除
+    uint8_t event;          // 觸發時寫入的事件 (wake_fsm.h 的事件 GPIO)
+} temp_threshold_t;
+
+/*
+  以新的樣本更新觸發狀態，*active 的 bit i 表示 th[i] 已觸發。
+  每次最多新觸發一個臨界值 (依陣列順序)，一次跨越多個時其餘留到下一次取樣，每個跨越各寫入一筆事件；
+  解除不產生事件。回傳新觸發的臨界值索引，沒有時回傳 -1
+*/
+int temp_threshold_update(const temp_threshold_t *th, size_t num, int16_t cc, uint32_t *active);
+
+/* 目前溫度與最近一個會改變觸發狀態的邊界的距離，已達到邊界 (尚有未觸發的跨越) 時為 0 */
+int32_t temp_threshold_margin(const temp_threshold_t *th, size_t num, int16_t cc, uint32_t active);
+
+/*
+  依上一個週期的溫度變化估計到達邊界的時間，下一個週期取其一半:
+  變化越快或越接近邊界取樣越密，溫度不變時週期加倍。每次最多加倍，結果限制在 [min_ms, max_ms]
+*/
+uint32_t temp_threshold_next_period(uint32_t period_ms, int16_t prev_cc, int16_t cc, int32_t margin_cc,
+                                    uint32_t min_ms, uint32_t max_ms);
+
+#ifdef __cplusplus
+}
+#endif
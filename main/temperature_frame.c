@@ -0,0 +1,134 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+#include "temperature_frame.h"
+
+#define VARINT_MAX_LEN      5
+
+static size_t varint_len(uint32_t value)
+{
+    size_t len = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        len++;
+    }
+    return len;
+}
+
+static size_t varint_put(uint8_t *out, uint32_t value)
+{
+    size_t len = 0;
+    while (value >= 0x80) {
+        out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+    return len;
+}
+
+static int varint_get(const uint8_t *buf, size_t len, size_t *pos, uint32_t *value)
+{
+    uint32_t result = 0;
+    for (int shift = 0, i = 0; i < VARINT_MAX_LEN; shift += 7, i++) {
+        if (*pos >= len) {
+            return -1;
+        }
+        uint8_t byte = buf[(*pos)++];
+        result |= (uint32_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// zigzag: 讓小的負數也只需要一個位元組
+static uint32_t zigzag_encode(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t zigzag_decode(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+size_t temperature_frame_encode(const temperature_sample_t *samples, size_t count, uint8_t seq,
+                                uint8_t *out, size_t out_cap, size_t *packed)
+{
+    *packed = 0;
+    if (count == 0 || out_cap < TEMPERATURE_FRAME_HEADER_LEN) {
+        return 0;
+    }
+
+    uint32_t ts = samples[0].timestamp_ms;
+    int16_t value = samples[0].centi_celsius;
+    out[0] = TEMPERATURE_FRAME_VERSION;
+    out[1] = seq;
+    out[3] = (uint8_t)ts;
+    out[4] = (uint8_t)(ts >> 8);
+    out[5] = (uint8_t)(ts >> 16);
+    out[6] = (uint8_t)(ts >> 24);
+    out[7] = (uint8_t)value;
+    out[8] = (uint8_t)((uint16_t)value >> 8);
+
+    size_t pos = TEMPERATURE_FRAME_HEADER_LEN;
+    size_t n = 1;
+    while (n < count && n < TEMPERATURE_FRAME_MAX_SAMPLES) {
+        // 時間戳記不會倒退，若發生則視為時間差 0
+        uint32_t dt = samples[n].timestamp_ms >= ts ? samples[n].timestamp_ms - ts : 0;
+        uint32_t dv = zigzag_encode((int32_t)samples[n].centi_celsius - value);
+        if (pos + varint_len(dt) + varint_len(dv) > out_cap) {
+            break;
+        }
+        pos += varint_put(out + pos, dt);
+        pos += varint_put(out + pos, dv);
+        ts += dt;
+        value = samples[n].centi_celsius;
+        n++;
+    }
+    out[2] = (uint8_t)n;
+    *packed = n;
+    return pos;
+}
+
+int temperature_frame_decode(const uint8_t *buf, size_t len, temperature_frame_info_t *info,
+                             temperature_sample_t *out, size_t out_cap)
+{
+    if (len < TEMPERATURE_FRAME_HEADER_LEN || buf[0] != TEMPERATURE_FRAME_VERSION || buf[2] == 0) {
+        return -1;
+    }
+    if (info) {
+        info->version = buf[0];
+        info->seq = buf[1];
+        info->count = buf[2];
+    }
+
+    uint32_t ts = (uint32_t)buf[3] | (uint32_t)buf[4] << 8 | (uint32_t)buf[5] << 16 | (uint32_t)buf[6] << 24;
+    int32_t value = (int16_t)((uint16_t)buf[7] | (uint16_t)buf[8] << 8);
+    size_t pos = TEMPERATURE_FRAME_HEADER_LEN;
+    size_t n = 0;
+    for (size_t i = 0; i < buf[2]; i++) {
+        if (i > 0) {
+            uint32_t dt, dv;
+            if (varint_get(buf, len, &pos, &dt) != 0 || varint_get(buf, len, &pos, &dv) != 0) {
+                return -1;
+            }
+            ts += dt;
+            value += zigzag_decode(dv);
+        }
+        if (n < out_cap) {
+            out[n].timestamp_ms = ts;
+            out[n].centi_celsius = (int16_t)value;
+            n++;
+        }
+    }
+    return pos == len ? (int)n : -1;
+}
@@ -0,0 +1,62 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  溫度通知封包格式 (與 ESP-IDF 無關，可直接在主機端編譯解碼)
+
+  | offset | size | 內容                                   |
+  |--------|------|----------------------------------------|
+  | 0      | 1    | 版本 TEMPERATURE_FRAME_VERSION         |
+  | 1      | 1    | 封包序號 (每送出一包加 1)              |
+  | 2      | 1    | 本包樣本數 N                           |
+  | 3      | 4    | 第一筆樣本時間 (開機後 ms, little endian) |
+  | 7      | 2    | 第一筆樣本溫度 (0.01°C, int16 little endian) |
+  | 9      | ...  | 其餘 N-1 筆: varint(時間差 ms) + zigzag varint(溫度差) |
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEMPERATURE_FRAME_VERSION       1
+#define TEMPERATURE_FRAME_HEADER_LEN    9
+#define TEMPERATURE_FRAME_MAX_SAMPLES   255
+
+typedef struct {
+    uint32_t timestamp_ms;  // 開機後的時間
+    int16_t  centi_celsius; // 溫度，單位 0.01°C
+} temperature_sample_t;
+
+typedef struct {
+    uint8_t version;
+    uint8_t seq;
+    uint8_t count;
+} temperature_frame_info_t;
+
+/*
+  將 samples 盡可能多地打包進 out (最多 out_cap 位元組)
+  @return 寫入 out 的位元組數，*packed 為實際打包的樣本數；out_cap 不足以放入一筆樣本時回傳 0
+*/
+size_t temperature_frame_encode(const temperature_sample_t *samples, size_t count, uint8_t seq,
+                                uint8_t *out, size_t out_cap, size_t *packed);
+
+/*
+  解碼一個封包，最多輸出 out_cap 筆樣本
+  @return 解出的樣本數，格式錯誤時回傳 -1
+*/
+int temperature_frame_decode(const uint8_t *buf, size_t len, temperature_frame_info_t *info,
+                             temperature_sample_t *out, size_t out_cap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,224 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  定時取樣溫度並暫存，依照目前 MTU 將多筆樣本打包成一個 notification 送出，
+  減少每筆資料需要的無線電事件次數。
+  取樣與送出都在 esp_timer task 執行 (訂閱時也是排入 kick_timer)，pending 只有一個消費者，
+  不會有兩個 task 同時打包並移除同一批樣本
+*/
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ble_host.h"
+#include "temp_sensor.h"
+#include "temperature_frame.h"
+#include "temperature_stream.h"
+
+#define ATT_NOTIFY_HEADER_LEN   3   // opcode + handle
+
+static const char *TAG = "temp_stream";
+
+static portMUX_TYPE stream_lock = portMUX_INITIALIZER_UNLOCKED;
+static temperature_sample_t pending[TEMP_STREAM_BUF_LEN];
+static size_t pending_count;
+static uint8_t frame_seq;
+
+/* 每個開啟 notify/indicate 的連線 */
+typedef struct {
+    bool          active;
+    bool          need_confirm;
+    uint16_t      conn_id;
+    uint16_t      attr_handle;
+    uint16_t      mtu;
+} stream_subscriber_t;
+
+static stream_subscriber_t subscribers[TEMP_STREAM_MAX_SUBSCRIBERS];
+
+static esp_timer_handle_t sample_timer;
+static esp_timer_handle_t flush_timer;
+static esp_timer_handle_t kick_timer;     // 訂閱後立即在 esp_timer task 送出累積的樣本
+
+static stream_subscriber_t *find_subscriber(uint16_t conn_id)
+{
+    for (int i = 0; i < TEMP_STREAM_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].active && subscribers[i].conn_id == conn_id) {
+            return &subscribers[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+  打包並排入每個訂閱連線的送出佇列；force 為 false 時只送出塞滿的封包，未滿的樣本留到下一次。
+  封包大小以所有訂閱連線中最小的 MTU 為準，每個連線收到相同的封包。
+  只在 esp_timer task 呼叫，打包到移除之間 pending 只會在尾端增加 (取樣也在同一個 task)
+*/
+static void stream_flush(bool force)
+{
+    uint8_t frame[BLE_HOST_MAX_MTU - ATT_NOTIFY_HEADER_LEN];
+    stream_subscriber_t targets[TEMP_STREAM_MAX_SUBSCRIBERS];
+
+    for (;;) {
+        size_t len = 0, packed = 0;
+        uint16_t min_mtu = BLE_HOST_MAX_MTU;
+        int target_num = 0;
+
+        taskENTER_CRITICAL(&stream_lock);
+        for (int i = 0; i < TEMP_STREAM_MAX_SUBSCRIBERS; i++) {
+            if (subscribers[i].active) {
+                targets[target_num++] = subscribers[i];
+                if (subscribers[i].mtu < min_mtu) {
+                    min_mtu = subscribers[i].mtu;
+                }
+            }
+        }
+        if (target_num > 0 && pending_count > 0) {
+            len = temperature_frame_encode(pending, pending_count, frame_seq, frame,
+                                           min_mtu - ATT_NOTIFY_HEADER_LEN, &packed);
+            if (!force && packed == pending_count) {
+                // 還塞得下更多樣本，等下一次
+                len = 0;
+            }
+        }
+        taskEXIT_CRITICAL(&stream_lock);
+
+        if (len == 0) {
+            return;
+        }
+        int queued = 0;
+        for (int i = 0; i < target_num; i++) {
+            esp_err_t ret = ble_host_notify(targets[i].conn_id, targets[i].attr_handle,
+                                            frame, len, targets[i].need_confirm);
+            if (ret == ESP_OK) {
+                queued++;
+            } else {
+                ESP_LOGW(TAG, "conn %d queue %u samples failed (%s)", targets[i].conn_id, (unsigned)packed, esp_err_to_name(ret));
+            }
+        }
+        if (queued == 0) {
+            // 所有佇列都滿了，樣本留在緩衝區等下一次
+            return;
+        }
+
+        taskENTER_CRITICAL(&stream_lock);
+        frame_seq++;
+        pending_count -= packed;
+        memmove(pending, pending + packed, pending_count * sizeof(pending[0]));
+        taskEXIT_CRITICAL(&stream_lock);
+    }
+}
+
+static void sample_timer_cb(void *arg)
+{
+    temperature_sample_t sample = {
+        .timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000),
+    };
+    esp_err_t ret = temp_sensor_read(&sample.centi_celsius);
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&stream_lock);
+    if (pending_count == TEMP_STREAM_BUF_LEN) {
+        // 緩衝區已滿，丟棄最舊的樣本
+        memmove(pending, pending + 1, (TEMP_STREAM_BUF_LEN - 1) * sizeof(pending[0]));
+        pending_count--;
+    }
+    pending[pending_count++] = sample;
+    taskEXIT_CRITICAL(&stream_lock);
+
+    stream_flush(false);
+}
+
+static void flush_timer_cb(void *arg)
+{
+    stream_flush(true);
+}
+
+esp_err_t temperature_stream_init(void)
+{
+    // 先讀取一次以安裝溫度感測器，失敗時不開始取樣
+    int16_t centi_celsius;
+    esp_err_t ret = temp_sensor_read(&centi_celsius);
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        return ret;
+    }
+
+    const esp_timer_create_args_t sample_args = {
+        .callback = sample_timer_cb,
+        .name = "temp_sample",
+    };
+    const esp_timer_create_args_t flush_args = {
+        .callback = flush_timer_cb,
+        .name = "temp_flush",
+    };
+    const esp_timer_create_args_t kick_args = {
+        .callback = flush_timer_cb,
+        .name = "temp_kick",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&sample_args, &sample_timer), TAG, "create sample timer failed");
+    ESP_RETURN_ON_ERROR(esp_timer_create(&flush_args, &flush_timer), TAG, "create flush timer failed");
+    ESP_RETURN_ON_ERROR(esp_timer_create(&kick_args, &kick_timer), TAG, "create kick timer failed");
+    ESP_RETURN_ON_ERROR(esp_timer_start_periodic(sample_timer, TEMP_STREAM_SAMPLE_PERIOD_MS * 1000), TAG, "start sample timer failed");
+    ESP_RETURN_ON_ERROR(esp_timer_start_periodic(flush_timer, TEMP_STREAM_FLUSH_PERIOD_MS * 1000), TAG, "start flush timer failed");
+    return ESP_OK;
+}
+
+void temperature_stream_set_mtu(uint16_t conn_id, uint16_t mtu)
+{
+    if (mtu > BLE_HOST_MAX_MTU) {
+        mtu = BLE_HOST_MAX_MTU;
+    }
+    taskENTER_CRITICAL(&stream_lock);
+    stream_subscriber_t *sub = find_subscriber(conn_id);
+    if (sub) {
+        sub->mtu = mtu;
+    }
+    taskEXIT_CRITICAL(&stream_lock);
+}
+
+void temperature_stream_start(uint16_t conn_id, uint16_t attr_handle, bool need_confirm, uint16_t mtu)
+{
+    if (mtu > BLE_HOST_MAX_MTU) {
+        mtu = BLE_HOST_MAX_MTU;
+    }
+    taskENTER_CRITICAL(&stream_lock);
+    stream_subscriber_t *sub = find_subscriber(conn_id);
+    for (int i = 0; sub == NULL && i < TEMP_STREAM_MAX_SUBSCRIBERS; i++) {
+        if (!subscribers[i].active) {
+            sub = &subscribers[i];
+        }
+    }
+    if (sub) {
+        sub->active = true;
+        sub->conn_id = conn_id;
+        sub->attr_handle = attr_handle;
+        sub->need_confirm = need_confirm;
+        sub->mtu = mtu;
+    }
+    taskEXIT_CRITICAL(&stream_lock);
+
+    // 先把訂閱前累積的樣本送出，交給 esp_timer task 以免與取樣的送出同時進行 (已排入時忽略)
+    if (kick_timer) {
+        esp_timer_start_once(kick_timer, 0);
+    }
+}
+
+void temperature_stream_stop(uint16_t conn_id)
+{
+    taskENTER_CRITICAL(&stream_lock);
+    stream_subscriber_t *sub = find_subscriber(conn_id);
+    if (sub) {
+        sub->active = false;
+    }
+    taskEXIT_CRITICAL(&stream_lock);
+}
@@ -0,0 +1,40 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "ble_host.h"
+#include "mem_budget.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEMP_STREAM_SAMPLE_PERIOD_MS    1000    // 取樣週期
+#define TEMP_STREAM_FLUSH_PERIOD_MS     10000   // 未滿一包時，最長多久送出一次
+#define TEMP_STREAM_BUF_LEN             MEM_BUDGET_TEMP_SAMPLES  // 暫存的樣本數上限，滿了會丟棄最舊的樣本
+#define TEMP_STREAM_MAX_SUBSCRIBERS     BLE_HOST_MAX_CONN
+
+/* 安裝溫度感測器並開始定時取樣 */
+esp_err_t temperature_stream_init(void);
+
+/* 連線的 MTU 交換完成時更新，每包可打包的樣本數隨之改變 */
+void temperature_stream_set_mtu(uint16_t conn_id, uint16_t mtu);
+
+/* 連線的 CCCD 開啟 notify/indicate 後開始送出溫度封包 */
+void temperature_stream_start(uint16_t conn_id, uint16_t attr_handle, bool need_confirm, uint16_t mtu);
+
+/* 連線的 CCCD 關閉或斷線時停止送出，沒有訂閱者時暫存的樣本保留到下次開啟 */
+void temperature_stream_stop(uint16_t conn_id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,29 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include "esp_check.h"
+#include "esp_sleep.h"
+#include "driver/uart.h"
+
+/* console uart，喚醒後由 diag_console 處理指令 */
+#define EXAMPLE_UART_NUM        CONFIG_ESP_CONSOLE_UART_NUM
+/* Notice that ESP32 has to use the iomux input to configure uart as wakeup source
+ * Please use 'UxRXD_GPIO_NUM' as uart rx pin. No limitation to the other target */
+#define EXAMPLE_UART_WAKEUP_THRESHOLD   3   // 喚醒所需的 RX 上升緣數，喚醒用的字元不會被接收
+
+static const char *TAG = "uart_wakeup";
+
+esp_err_t example_register_uart_wakeup(void)
+{
+    /* UART will wakeup the chip up from light sleep if the edges that RX pin received has reached the threshold */
+    ESP_RETURN_ON_ERROR(uart_set_wakeup_threshold(EXAMPLE_UART_NUM, EXAMPLE_UART_WAKEUP_THRESHOLD),
+                        TAG, "Set uart wakeup threshold failed");
+    /* Only uart0 and uart1 (if has) support to be configured as wakeup source */
+    ESP_RETURN_ON_ERROR(esp_sleep_enable_uart_wakeup(EXAMPLE_UART_NUM),
+                        TAG, "Configure uart as wakeup source failed");
+
+    ESP_LOGI(TAG, "uart wakeup source is ready");
+    return ESP_OK;
+}
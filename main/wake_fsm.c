@@ -0,0 +1,121 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  喚醒流程: 啟動後進入 light sleep，pin 9 喚醒時開始藍芽廣播 (斷線後重新啟動)，
+  pin 10 ~ 14 喚醒時寫入事件紀錄後重新啟動；timer 喚醒時取樣溫度，跨越臨界值時同樣寫入事件紀錄，
+  否則回到 light sleep。硬體相關的操作都經由 wake_platform_t
+*/
+
+#include <stddef.h>
+#include <stdio.h>
+#include "power_model.h"
+#include "wake_fsm.h"
+
+static const wake_platform_t *platform;
+
+static const struct {
+    uint8_t     gpio;
+    const char *name;
+} wake_events[] = {
+    { TEMPERATURE_WAKEUP_GPIO1,    "Temperature1 ≤ 1°C" },
+    { TEMPERATURE_WAKEUP_GPIO2,    "Temperature2 ≤ -1°C" },
+    { TEMPERATURE_WAKEUP_GPIO3,    "Temperature3 ≤ -5°C" },
+    { LOW_BATTERY_WAKEUP_GPIO,     "Low Battery" },
+    { DEVICE_ABNORMAL_WAKEUP_GPIO, "Device Abnormal" },
+};
+
+const char *wake_fsm_event_name(uint8_t gpio)
+{
+    for (size_t i = 0; i < sizeof(wake_events) / sizeof(wake_events[0]); i++) {
+        if (wake_events[i].gpio == gpio) {
+            return wake_events[i].name;
+        }
+    }
+    return NULL;
+}
+
+void wake_fsm_set_state(wake_state_t state)
+{
+    power_model_enter(platform->stats, state, platform->now_us());
+}
+
+void wake_fsm_restart(void)
+{
+    // 重新啟動到下次進入 light sleep 的時間算在 WAKE_STATE_BOOT
+    wake_fsm_set_state(WAKE_STATE_BOOT);
+    platform->restart();
+}
+
+/* 寫入事件紀錄後重新啟動 */
+static void handle_event(uint8_t gpio)
+{
+    const char *name = wake_fsm_event_name(gpio);
+    if (name) {
+        printf("%s\n", name);
+        wake_fsm_set_state(WAKE_STATE_EVENT);
+        platform->write_event(gpio);
+    }
+    wake_fsm_restart();
+}
+
+static void fsm_begin(const wake_platform_t *p)
+{
+    platform = p;
+    power_model_boot(p->stats, p->now_us());
+    power_model_report(p->stats);
+}
+
+void wake_fsm_run_ble(const wake_platform_t *p)
+{
+    fsm_begin(p);
+    wake_fsm_set_state(WAKE_STATE_BLE_ADV);
+    p->start_ble();
+}
+
+void wake_fsm_run(const wake_platform_t *p)
+{
+    fsm_begin(p);
+
+    for (;;) {
+        wake_fsm_set_state(WAKE_STATE_SLEEP);
+        p->light_sleep();
+        if (!p->woken_by_timer || !p->woken_by_timer() || !p->sample) {
+            break;
+        }
+        uint8_t gpio = 0;
+        wake_fsm_set_state(WAKE_STATE_SAMPLE);
+        wake_sample_t result = p->sample(&gpio);
+        if (result == WAKE_SAMPLE_EVENT) {
+            handle_event(gpio);
+            return;
+        }
+        if (result == WAKE_SAMPLE_RESTART) {
+            wake_fsm_restart();
+            return;
+        }
+    }
+    if (p->woken_by_uart && p->woken_by_uart()) {
+        wake_fsm_set_state(WAKE_STATE_CONSOLE);
+        p->start_console();
+        return;
+    }
+    if (!p->woken_by_gpio()) {
+        wake_fsm_restart();
+        return;
+    }
+
+    /* Waiting for the gpio inactive, or the chip will continously trigger wakeup */
+    uint8_t gpio = p->wait_gpio_inactive();
+    if (gpio == BLE_WAKEUP_GPIO) {
+        wake_fsm_set_state(WAKE_STATE_BLE_ADV);
+        p->start_ble();
+        return;
+    }
+    handle_event(gpio);
+}
@@ -0,0 +1,95 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLE_WAKEUP_GPIO                   9
+#define TEMPERATURE_WAKEUP_GPIO1          10
+#define TEMPERATURE_WAKEUP_GPIO2          11
+#define TEMPERATURE_WAKEUP_GPIO3          12
+#define LOW_BATTERY_WAKEUP_GPIO           13
+#define DEVICE_ABNORMAL_WAKEUP_GPIO       14
+
+/* 喚醒流程的狀態，每個狀態對應 耗電流.txt 的一項量測 */
+typedef enum {
+    WAKE_STATE_BOOT,        // 啟動到進入 light sleep
+    WAKE_STATE_SLEEP,       // light sleep
+    WAKE_STATE_EVENT,       // pin 10 ~ 14 喚醒後寫入事件紀錄
+    WAKE_STATE_BLE_ADV,     // pin 9 喚醒後藍芽廣播
+    WAKE_STATE_BLE_CONN,    // 藍芽連線
+    WAKE_STATE_CONSOLE,     // UART 喚醒後的診斷 console
+    WAKE_STATE_SAMPLE,      // timer 喚醒後取樣溫度
+    WAKE_STATE_NUM,
+} wake_state_t;
+
+/* timer 喚醒後取樣的結果 */
+typedef enum {
+    WAKE_SAMPLE_SLEEP,      // 沒有跨越臨界值，不重新啟動，直接回到 light sleep
+    WAKE_SAMPLE_EVENT,      // 跨越臨界值，與 GPIO 喚醒相同寫入事件紀錄
+    WAKE_SAMPLE_RESTART,    // 其他 timer 喚醒 (例如重複事件 hold-off 結束)，重新啟動
+} wake_sample_t;
+
+/* 各狀態累計的時間，由平台放在重新啟動後仍保留的記憶體 */
+typedef struct {
+    uint32_t     magic;
+    uint32_t     boot_count;
+    wake_state_t state;
+    int64_t      enter_us;                  // 進入目前狀態的時間 (本次啟動的時鐘)
+    int64_t      time_us[WAKE_STATE_NUM];
+} power_stats_t;
+
+/*
+  平台相關的操作。喚醒流程本身不呼叫 ESP-IDF，換成模擬的實作 (虛擬時鐘、腳本化的 GPIO)
+  即可在主機上執行相同的流程
+*/
+typedef struct {
+    int64_t (*now_us)(void);
+    void    (*light_sleep)(void);           // 進入 light sleep 直到被喚醒
+    bool    (*woken_by_gpio)(void);
+    bool    (*woken_by_uart)(void);
+    bool    (*woken_by_timer)(void);
+    wake_sample_t (*sample)(uint8_t *gpio); // timer 喚醒後取樣，跨越臨界值時 *gpio 為事件的 GPIO
+    uint8_t (*wait_gpio_inactive)(void);    // 等待喚醒腳位回到非觸發準位，回傳喚醒的 GPIO
+    void    (*start_ble)(void);             // 開始藍芽廣播後返回，之後由 GATT 事件推進狀態
+    void    (*write_event)(uint8_t gpio);
+    void    (*start_console)(void);         // 開始診斷 console 後返回，閒置後由 console 重新啟動
+    void    (*restart)(void);
+    power_stats_t *stats;
+} wake_platform_t;
+
+/*
+  執行一次 啟動 -> light sleep -> 喚醒處理 的流程，BLE 與 UART 喚醒時在開始廣播或 console 後返回。
+  timer 喚醒取樣沒有跨越臨界值時不重新啟動，直接回到 light sleep
+*/
+void wake_fsm_run(const wake_platform_t *platform);
+
+/*
+  不進入 light sleep，直接開始藍芽廣播後返回。用於新的 OTA 映像第一次啟動: 映像在開始廣播後才標記為有效，
+  在此之前的事件與重新啟動會使 bootloader 回到上一個 app。標記後沒有連線時由平台重新啟動，回到 wake_fsm_run()
+*/
+void wake_fsm_run_ble(const wake_platform_t *platform);
+
+/* 狀態改變時呼叫 (例如 GATT 連線與斷線)，累計前一個狀態的時間 */
+void wake_fsm_set_state(wake_state_t state);
+
+/* 累計目前狀態的時間後重新啟動 */
+void wake_fsm_restart(void);
+
+/* GPIO 對應的事件名稱，不是事件腳位時回傳 NULL */
+const char *wake_fsm_event_name(uint8_t gpio);
+
+#ifdef __cplusplus
+}
+#endif
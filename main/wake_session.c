@@ -0,0 +1,135 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+  喚醒工作排程: 事件喚醒後只等待宣告的工作完成就結束，不使用固定的延遲，
+  背景工作完成時以 task notification 喚醒等待中的 task，最長等待 WAKE_SESSION_DEADLINE_MS
+*/
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "diag.h"
+#include "wake_fsm.h"
+#include "wake_session.h"
+
+#define WAKE_SESSION_MAGIC      0x57534553  // "WSES"
+
+static const char *TAG = "wake_session";
+
+typedef struct {
+    uint32_t magic;
+    wake_session_stats_t events[WAKE_SESSION_EVENT_TYPES];
+} wake_session_store_t;
+
+static __NOINIT_ATTR wake_session_store_t store;
+static TaskHandle_t waiter;
+
+static bool all_done(const wake_work_t *works, size_t num, uint32_t *pending)
+{
+    *pending = 0;
+    for (size_t i = 0; i < num; i++) {
+        if (works[i].done && !works[i].done(works[i].ctx)) {
+            *pending |= 1 << i;
+        }
+    }
+    return *pending == 0;
+}
+
+bool wake_session_run(uint8_t gpio, const wake_work_t *works, size_t num)
+{
+    int64_t start = esp_timer_get_time();
+    int64_t deadline = start + WAKE_SESSION_DEADLINE_MS * 1000LL;
+    uint32_t pending;
+
+    if (num > WAKE_SESSION_MAX_WORK) {
+        num = WAKE_SESSION_MAX_WORK;
+    }
+    waiter = xTaskGetCurrentTaskHandle();
+    for (size_t i = 0; i < num; i++) {
+        works[i].start(works[i].ctx);
+    }
+    bool completed = all_done(works, num, &pending);
+    while (!completed) {
+        int64_t remaining_us = deadline - esp_timer_get_time();
+        if (remaining_us <= 0) {
+            break;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(remaining_us / 1000) + 1);
+        completed = all_done(works, num, &pending);
+    }
+    waiter = NULL;
+
+    uint32_t elapsed_us = esp_timer_get_time() - start;
+    for (size_t i = 0; !completed && i < num; i++) {
+        if (pending & (1 << i)) {
+            ESP_LOGW(TAG, "%s not done after %d ms", works[i].name, WAKE_SESSION_DEADLINE_MS);
+        }
+    }
+    unsigned idx = gpio - TEMPERATURE_WAKEUP_GPIO1;
+    if (idx < WAKE_SESSION_EVENT_TYPES) {
+        wake_session_stats_t *stats = &store.events[idx];
+        stats->count++;
+        stats->timeouts += !completed;
+        stats->last_us = elapsed_us;
+        stats->total_us += elapsed_us;
+        if (elapsed_us > stats->max_us) {
+            stats->max_us = elapsed_us;
+        }
+    }
+    ESP_LOGI(TAG, "gpio %u session %lu us", gpio, (unsigned long)elapsed_us);
+    return completed;
+}
+
+void wake_session_notify(void)
+{
+    TaskHandle_t task = waiter;
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+static size_t wake_session_diag_read(uint32_t offset, uint8_t *buf, size_t cap)
+{
+    if (offset >= sizeof(store.events)) {
+        return 0;
+    }
+    size_t len = sizeof(store.events) - offset;
+    if (len > cap) {
+        len = cap;
+    }
+    memcpy(buf, (const uint8_t *)store.events + offset, len);
+    return len;
+}
+
+esp_err_t wake_session_init(void)
+{
+    if (store.magic != WAKE_SESSION_MAGIC) {
+        // 上電後 RAM 內容無效
+        memset(&store, 0, sizeof(store));
+        store.magic = WAKE_SESSION_MAGIC;
+    }
+    return diag_register(DIAG_ID_WAKE_SESSION, wake_session_diag_read);
+}
+
+void wake_session_report(void)
+{
+    for (int i = 0; i < WAKE_SESSION_EVENT_TYPES; i++) {
+        const wake_session_stats_t *stats = &store.events[i];
+        if (stats->count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%s: %lu wakes, avg %lu us, max %lu us, last %lu us, %lu timeouts",
+                 wake_fsm_event_name(TEMPERATURE_WAKEUP_GPIO1 + i), (unsigned long)stats->count,
+                 (unsigned long)(stats->total_us / stats->count), (unsigned long)stats->max_us,
+                 (unsigned long)stats->last_us, (unsigned long)stats->timeouts);
+    }
+}
@@ -0,0 +1,58 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WAKE_SESSION_DEADLINE_MS    3000    // 一次喚醒最長的清醒時間，超過時不再等待未完成的工作
+#define WAKE_SESSION_MAX_WORK       4       // 一次喚醒最多的工作數
+#define WAKE_SESSION_EVENT_TYPES    5       // GPIO 10 ~ 14 各自統計
+
+/* 喚醒後要完成的一項工作 */
+typedef struct {
+    const char *name;
+    void (*start)(void *ctx);   // 開始工作，可以同步完成，或交給其他 task 後返回
+    bool (*done)(void *ctx);    // 完成條件，NULL 表示 start 返回即完成；狀態改變時由完成的一方呼叫 wake_session_notify()
+    void *ctx;
+} wake_work_t;
+
+/* 每種喚醒事件的清醒時間，重新啟動後保留，斷電後清除 */
+typedef struct {
+    uint32_t count;
+    uint32_t timeouts;          // 到達 WAKE_SESSION_DEADLINE_MS 仍有工作未完成的次數
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} wake_session_stats_t;
+
+/* 開機時呼叫，以 DIAG_ID_WAKE_SESSION 提供各事件的統計 (wake_session_stats_t 陣列，依 GPIO 10 ~ 14 排列) */
+esp_err_t wake_session_init(void);
+
+/*
+  GPIO gpio 喚醒後依序開始 works 中的工作，所有工作完成或到達 WAKE_SESSION_DEADLINE_MS 時返回，
+  並記錄這次清醒的時間。所有工作都完成時回傳 true
+*/
+bool wake_session_run(uint8_t gpio, const wake_work_t *works, size_t num);
+
+/* 工作的完成條件可能已改變 (例如背景 task 結束)，喚醒等待中的 wake_session_run() 重新檢查 */
+void wake_session_notify(void);
+
+/* 印出各事件的平均與最長清醒時間 */
+void wake_session_report(void);
+
+#ifdef __cplusplus
+}
+#endif
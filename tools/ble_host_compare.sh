@@ -0,0 +1,53 @@
+#!/bin/sh
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# 比較 Bluedroid 與 NimBLE host: 分別建置 build 與 build_nimble，印出 idf.py size 的 flash 與 DRAM 用量；
+# 指定序列埠時依序燒錄，等待 GPIO 9 喚醒 (按下按鈕) 後擷取 ble_host tag 的 host 初始化與開始廣播時間
+#
+#   tools/ble_host_compare.sh [序列埠 [每次等待的秒數]]
+#
+# 需在 ESP-IDF 環境 (export.sh) 中於專案根目錄執行
+
+set -e
+
+PORT=$1
+WAIT=${2:-60}
+DEFAULTS_BLUEDROID="sdkconfig.defaults"
+DEFAULTS_NIMBLE="sdkconfig.defaults;sdkconfig.defaults.nimble"
+
+# <名稱> <build 目錄> <sdkconfig> <SDKCONFIG_DEFAULTS>
+build_host() {
+    echo "== $1: build"
+    idf.py -B "$2" -D SDKCONFIG="$3" -D SDKCONFIG_DEFAULTS="$4" build > "$2.log" 2>&1 || {
+        tail -20 "$2.log"
+        exit 1
+    }
+    echo "== $1: size"
+    idf.py -B "$2" -D SDKCONFIG="$3" -D SDKCONFIG_DEFAULTS="$4" size | grep -E "Used static|Total image size|Flash Code|Flash Data|DRAM"
+}
+
+# <名稱> <build 目錄> <sdkconfig> <SDKCONFIG_DEFAULTS>
+startup_host() {
+    [ -n "$PORT" ] || return 0
+    echo "== $1: flash $PORT, press GPIO 9 within $WAIT s"
+    idf.py -B "$2" -D SDKCONFIG="$3" -D SDKCONFIG_DEFAULTS="$4" -p "$PORT" flash > "$2.flash.log" 2>&1
+    python -c '
+import re, serial, sys, time
+port, wait = sys.argv[1], float(sys.argv[2])
+found = 0
+with serial.Serial(port, 115200, timeout=0.5) as s:
+    end = time.time() + wait
+    while time.time() < end and found < 2:
+        line = s.readline().decode(errors="replace").strip()
+        if re.search(r"ble_host: \S+ (init|advertising) \d+ ms", line):
+            print(line)
+            found += 1
+if found < 2:
+    print("no ble_host startup lines, GPIO 9 not pressed?")
+' "$PORT" "$WAIT"
+}
+
+build_host bluedroid build sdkconfig "$DEFAULTS_BLUEDROID"
+build_host nimble build_nimble sdkconfig.nimble "$DEFAULTS_NIMBLE"
+startup_host bluedroid build sdkconfig "$DEFAULTS_BLUEDROID"
+startup_host nimble build_nimble sdkconfig.nimble "$DEFAULTS_NIMBLE"
@@ -0,0 +1,307 @@
+#!/usr/bin/env python3
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# main/diag_console.h 的主機端: 經由 UART 喚醒裝置、切換 baud rate 並以 frame 取得事件紀錄與診斷資料
+#   diag_uart_client.py /dev/ttyUSB0 dump log -o data.json --baud 2000000
+#   diag_uart_client.py /dev/ttyUSB0 dump 0x03 -o task_profile.bin
+#   diag_uart_client.py /dev/ttyUSB0 stats
+#   diag_uart_client.py --selftest      以 pty 模擬裝置，不需要硬體
+# 只使用標準函式庫 (termios)，Linux / macOS
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import threading
+import time
+import tty
+
+SOF = 0xA5
+FRAME_DATA = 0x01
+FRAME_END = 0x02
+FRAME_ERROR = 0x03
+PAYLOAD_MAX = 1024
+PROMPT = b'diag> '
+
+
+def _crc16_table():
+    table = []
+    for i in range(256):
+        crc = i << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+        table.append(crc & 0xFFFF)
+    return table
+
+
+CRC16_TABLE = _crc16_table()
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE，與 main/diag_console.c 相同"""
+    for b in data:
+        crc = ((crc << 8) & 0xFFFF) ^ CRC16_TABLE[(crc >> 8) ^ b]
+    return crc
+
+
+def make_frame(ftype, seq, payload):
+    body = struct.pack('<BHH', ftype, seq, len(payload)) + payload
+    return bytes([SOF]) + body + struct.pack('<H', crc16(body))
+
+
+class Port:
+    """raw 模式的 tty (實體 UART 或 pty)"""
+
+    def __init__(self, path, baud=115200):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        self.set_baud(baud)
+        self.pending = b''
+
+    def set_baud(self, baud):
+        speed = getattr(termios, 'B%d' % baud, None)
+        if speed is None:
+            raise ValueError('unsupported baud %d' % baud)
+        attrs = termios.tcgetattr(self.fd)
+        attrs[4] = attrs[5] = speed
+        termios.tcsetattr(self.fd, termios.TCSADRAIN, attrs)
+
+    def write(self, data):
+        os.write(self.fd, data)
+
+    def _fill(self, deadline):
+        remaining = deadline - time.monotonic()
+        if remaining <= 0 or not select.select([self.fd], [], [], remaining)[0]:
+            return False
+        self.pending += os.read(self.fd, 65536)
+        return True
+
+    def read(self, n, timeout):
+        deadline = time.monotonic() + timeout
+        while len(self.pending) < n and self._fill(deadline):
+            pass
+        data, self.pending = self.pending[:n], self.pending[n:]
+        return data
+
+    def read_until(self, token, timeout):
+        """讀到 token (含) 為止，逾時前資料持續進來時延長等待"""
+        deadline = time.monotonic() + timeout
+        while token not in self.pending:
+            if not self._fill(deadline):
+                raise TimeoutError('waiting for %r, got %r' % (token, self.pending[-80:]))
+            deadline = time.monotonic() + timeout
+        end = self.pending.index(token) + len(token)
+        data, self.pending = self.pending[:end], self.pending[end:]
+        return data
+
+
+class DiagClient:
+    def __init__(self, port, timeout=2.0):
+        self.port = port
+        self.timeout = timeout
+
+    def wake(self, attempts=10):
+        """UART 喚醒時前幾個字元會遺失，重送換行直到看到提示字元"""
+        for _ in range(attempts):
+            self.port.write(b'\r\n')
+            try:
+                self.port.read_until(PROMPT, 0.5)
+                return
+            except TimeoutError:
+                pass
+        raise TimeoutError('no prompt from device')
+
+    def command(self, line):
+        self.port.write(line.encode() + b'\n')
+        out = self.port.read_until(PROMPT, self.timeout)
+        return out[:-len(PROMPT)].decode(errors='replace')
+
+    def set_baud(self, baud):
+        self.port.write(b'baud %d\n' % baud)
+        reply = self.port.read_until(b'\n', self.timeout)
+        if not reply.strip().endswith(b'OK %d' % baud):
+            raise RuntimeError('baud rejected: %r' % reply)
+        # 裝置在回應後才切換，提示字元以新的 baud rate 送出
+        time.sleep(0.05)
+        self.port.set_baud(baud)
+        self.port.pending = b''
+        self.wake()
+
+    def _read_frame(self):
+        while True:
+            b = self.port.read(1, self.timeout)
+            if not b:
+                raise TimeoutError('frame timeout')
+            if b[0] == SOF:
+                break
+        header = self.port.read(5, self.timeout)
+        ftype, seq, length = struct.unpack('<BHH', header)
+        if length > PAYLOAD_MAX:
+            raise ValueError('bad frame length %d' % length)
+        payload = self.port.read(length + 2, self.timeout)
+        if len(payload) != length + 2:
+            raise TimeoutError('short frame')
+        (crc,) = struct.unpack('<H', payload[-2:])
+        if crc16(header + payload[:-2]) != crc:
+            raise ValueError('crc error in frame %d' % seq)
+        return ftype, seq, payload[:-2]
+
+    def dump(self, source, retries=3):
+        """source 為 'log' 或診斷資料編號，frame 錯誤時由已收到的位置重新要求"""
+        data = b''
+        for _ in range(retries + 1):
+            self.port.write(b'dump %s %d\n' % (str(source).encode(), len(data)))
+            reply = self.port.read_until(b'\n', self.timeout)
+            if b'ERR' in reply:
+                raise RuntimeError(reply.decode(errors='replace').strip())
+            expect = 0
+            try:
+                while True:
+                    ftype, seq, payload = self._read_frame()
+                    if ftype == FRAME_DATA:
+                        if seq != expect:
+                            raise ValueError('frame %d missing' % expect)
+                        data += payload
+                        expect += 1
+                    elif ftype == FRAME_END:
+                        self.port.read_until(PROMPT, self.timeout)
+                        return data
+                    elif ftype == FRAME_ERROR:
+                        (err,) = struct.unpack('<i', payload)
+                        self.port.read_until(PROMPT, self.timeout)
+                        raise RuntimeError('device error 0x%x' % err)
+            except (ValueError, TimeoutError) as e:
+                print('retry from %d: %s' % (len(data), e), file=sys.stderr)
+                # 丟棄剩餘的 frame 後重新要求
+                try:
+                    self.port.read_until(PROMPT, self.timeout)
+                except TimeoutError:
+                    self.wake()
+        raise RuntimeError('dump failed after %d retries' % retries)
+
+
+class FakeDevice(threading.Thread):
+    """在 pty 的另一端模擬 diag_console，用於在沒有硬體時驗證協定與主機端"""
+
+    def __init__(self, fd, sources, corrupt_frame=None):
+        super().__init__(daemon=True)
+        self.fd = fd
+        self.sources = sources
+        self.corrupt_frame = corrupt_frame
+
+    def send(self, data):
+        while data:
+            n = os.write(self.fd, data)
+            data = data[n:]
+
+    def run(self):
+        line = b''
+        while True:
+            try:
+                c = os.read(self.fd, 1)
+            except OSError:
+                return
+            if not c:
+                return
+            if c not in b'\r\n':
+                line += c
+                continue
+            if line:
+                self.handle(line.decode().split())
+                line = b''
+            self.send(PROMPT)
+
+    def handle(self, argv):
+        if argv[0] == 'baud':
+            self.send(b'OK %s\n' % argv[1].encode())
+        elif argv[0] == 'dump':
+            key = argv[1] if argv[1] == 'log' else int(argv[1], 0)
+            if key not in self.sources:
+                self.send(b'OK\n' + make_frame(FRAME_ERROR, 0, struct.pack('<i', 0x105)))
+                return
+            data = self.sources[key]
+            offset = int(argv[2]) if len(argv) > 2 else 0
+            self.send(b'OK\n')
+            seq = 0
+            while True:
+                chunk = data[offset:offset + PAYLOAD_MAX]
+                if chunk:
+                    frame = make_frame(FRAME_DATA, seq, chunk)
+                    if seq == self.corrupt_frame:
+                        # 只損壞一次，驗證重新要求
+                        frame = frame[:-1] + bytes([frame[-1] ^ 0xFF])
+                        self.corrupt_frame = None
+                    self.send(frame)
+                    seq += 1
+                    offset += len(chunk)
+                if len(chunk) < PAYLOAD_MAX:
+                    self.send(make_frame(FRAME_END, seq, struct.pack('<I', len(data))))
+                    return
+        else:
+            self.send(b'ERR unknown command\n')
+
+
+def selftest():
+    master, slave = os.openpty()
+    tty.setraw(master)
+    log = b''.join(b'{"event":"Temperature1 \xe2\x89\xa4 1\xc2\xb0C","time after startup(ms)":%d}\n' % i
+                   for i in range(20000))
+    sources = {'log': log, 5: os.urandom(64)}
+    FakeDevice(master, sources, corrupt_frame=3).start()
+    client = DiagClient(Port(os.ttyname(slave)))
+    client.wake()
+    client.set_baud(2000000 if hasattr(termios, 'B2000000') else 115200)
+    start = time.monotonic()
+    data = client.dump('log')
+    elapsed = time.monotonic() - start
+    assert data == log, 'log mismatch'
+    assert client.dump(5) == sources[5], 'diag mismatch'
+    try:
+        client.dump(9)
+        raise AssertionError('missing diag id accepted')
+    except RuntimeError:
+        pass
+    print('selftest ok: %d bytes in %.2f s' % (len(data), elapsed))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='diag_console UART client')
+    parser.add_argument('port', nargs='?')
+    parser.add_argument('command', nargs='*', help='dump log|<diag id>, stats, or any console command')
+    parser.add_argument('--baud', type=int, help='switch to this baud rate before the command')
+    parser.add_argument('-o', '--output', help='write dump to file (default: stdout)')
+    parser.add_argument('--selftest', action='store_true', help='run against a simulated device on a pty')
+    args = parser.parse_args()
+
+    if args.selftest:
+        selftest()
+        return
+    if not args.port or not args.command:
+        parser.error('port and command are required')
+    client = DiagClient(Port(args.port))
+    client.wake()
+    if args.baud:
+        client.set_baud(args.baud)
+    if args.command[0] == 'dump':
+        source = args.command[1] if len(args.command) > 1 else 'log'
+        if source != 'log':
+            source = int(source, 0)
+        start = time.monotonic()
+        data = client.dump(source)
+        print('%d bytes in %.2f s' % (len(data), time.monotonic() - start), file=sys.stderr)
+        if args.output:
+            with open(args.output, 'wb') as f:
+                f.write(data)
+        else:
+            sys.stdout.buffer.write(data)
+    else:
+        print(client.command(' '.join(args.command)), end='')
+    if args.baud:
+        # 恢復預設 baud rate，log 可繼續以 monitor 查看
+        client.set_baud(115200)
+
+
+if __name__ == '__main__':
+    main()
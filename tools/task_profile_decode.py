@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# 解碼 main/task_profiler.h 的 task 剖析快照
+#   由 log 取出 "TPROF <session> <hex>" 行:  idf.py monitor | tee boot.log; task_profile_decode.py boot.log
+#   由診斷 characteristic (DIAG_ID_TASK_PROFILE) 讀出的原始資料:  task_profile_decode.py --raw diag.bin
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct('<BBBxII')
+ENTRY = struct.Struct('<10sHHBBHH')
+VERSION = 1
+SESSIONS = {0: 'ble', 1: 'wake_event'}
+STATES = {0: 'running', 1: 'ready', 2: 'blocked', 3: 'suspended', 4: 'deleted'}
+
+
+def decode(data):
+    """回傳 (快照, 剩餘資料)，一次讀出的診斷資料可能包含多個快照"""
+    version, session, count, window_us, samples = HEADER.unpack_from(data)
+    if version != VERSION:
+        raise ValueError('unsupported snapshot version %d' % version)
+    tasks = []
+    for i in range(count):
+        name, permille, stack, prio, state, ready, blocked = ENTRY.unpack_from(data, HEADER.size + i * ENTRY.size)
+        tasks.append({
+            'name': name.rstrip(b'\0').decode(errors='replace'),
+            'cpu': permille / 10,
+            'stack_free': stack,
+            'priority': prio,
+            'state': STATES.get(state, str(state)),
+            'ready': ready,
+            'blocked': blocked,
+        })
+    snapshot = {
+        'session': SESSIONS.get(session, str(session)),
+        'window_ms': window_us / 1000,
+        'samples': samples,
+        'tasks': tasks,
+    }
+    return snapshot, data[HEADER.size + count * ENTRY.size:]
+
+
+def print_snapshot(snap):
+    print('session %s: %.1f ms, %d samples' % (snap['session'], snap['window_ms'], snap['samples']))
+    print('  %-10s %6s %10s %4s %-9s %6s %8s' % ('task', 'cpu%', 'stack_free', 'prio', 'state', 'ready', 'blocked'))
+    for t in sorted(snap['tasks'], key=lambda t: -t['cpu']):
+        print('  %-10s %6.1f %10d %4d %-9s %6d %8d' % (
+            t['name'], t['cpu'], t['stack_free'], t['priority'], t['state'], t['ready'], t['blocked']))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='decode task profiler snapshots')
+    parser.add_argument('file', nargs='?', help='log or raw file (default: stdin)')
+    parser.add_argument('--raw', action='store_true', help='input is raw diag characteristic data')
+    args = parser.parse_args()
+
+    if args.raw:
+        data = open(args.file, 'rb').read() if args.file else sys.stdin.buffer.read()
+        while len(data) >= HEADER.size:
+            snap, data = decode(data)
+            print_snapshot(snap)
+        return
+    lines = open(args.file, errors='replace') if args.file else sys.stdin
+    for line in lines:
+        pos = line.find('TPROF ')
+        if pos < 0:
+            continue
+        fields = line[pos:].split()
+        if len(fields) < 3:
+            continue
+        snap, _ = decode(bytes.fromhex(fields[2]))
+        print_snapshot(snap)
+
+
+if __name__ == '__main__':
+    main()